@@ -15,6 +15,25 @@
 #define SRC_ENFORCEMENT_EN      0           // Indicates if source enforcement is enabled.
 
 #define REG_INTF_BUS_WIDTH      4           // Width (in bytes) of the register interface bus.
+#define PRIO_MATCH_SIMD_EN      1           // Use SIMD kernels for priority entry matching if the host supports them.
+
+#define DECISION_CACHE_EN       0           // Cache transaction decisions per (RRID, permission, address block).
+#define DECISION_CACHE_SIZE     256         // Number of decision cache lines, a power of 2.
+#define DECISION_CACHE_BLOCK    64          // Size (in bytes) of the address block of a cached decision, a power of 2.
+
+#define CONCURRENT_CHECK_EN     1           // Allow several threads to check transactions on one IOPMP instance.
+#define EPOCH_READER_SLOTS      64          // Number of reader slots of the configuration epoch.
+
+#define CHECKPOINT_CHUNKS       1024        // Number of chunks the tables are split into to track writes since a checkpoint, a multiple of 64.
+
+#define FABRIC_QUEUE_DEPTH      1024        // Number of requests queued to each worker thread of an IOPMP fabric, a power of 2.
+
+#define VIOLATION_LOG_EN        0           // Record every violation in a side-band log, see iopmp_violation_log_drain(). Embeds the ring in iopmp_dev_t.
+#define VIOLATION_LOG_DEPTH     1024        // Number of records the violation log holds until it is drained, a power of 2.
+
+#define HIT_STATS_EN            0           // Count entry hits and entry scans per RRID, see iopmp_dump_stats(). Bypasses the decision cache.
+
+#define TRACE_EN                0           // Record register accesses and transactions to a trace, see iopmp_trace_record_start().
 
 // Select the behavior for an MDCFG table improper setting.
 // 0: correct the values to make the table have a proper setting
@@ -52,24 +52,253 @@
 #define ENTRY_REG_INDEX(iopmp, offset)      ((((offset) - (iopmp->reg_file.entryoffset.offset)) % ENTRY_REG_STRIDE) / MIN_REG_WIDTH)
 #define IS_IN_RANGE(offset, start, end) (((offset) >= (start)) && ((offset) <= (end)))
 #define CONCAT32(upr_bits, lwr_bits) (((uint64_t)upr_bits << WORD_BITS) | lwr_bits)
+// Register word for atomic updates, the packed register fields can't be addressed
+#define REG_WORD(iopmp, offset)             (&(iopmp)->reg_file.regs4[(offset) / MIN_REG_WIDTH])
 #define IS_MD_ASSOCIATED(md_num, srcmd_en_md, srcmd_enh_mdh) \
     ((md_num < 31) ? ((srcmd_en_md >> md_num) & 1) : ((srcmd_enh_mdh >> (md_num - 31)) & 1))
 
 #define MASK_BIT_POS(BIT_POS) ((1U << BIT_POS) - 1)
 #define GET_BIT(VAL, BIT_NUM) ((VAL >> BIT_NUM) & 1)
 
+// Bitsets of RRIDs, one bit per RRID in 64-bit words
+#define RRID_WORDS(rrid_num)    (ALIGNUP((rrid_num), 64) / 64)
+#define BITSET_GET(set, i)      (((set)[(i) / 64] >> ((i) % 64)) & 1)
+#define BITSET_SET(set, i)      ((set)[(i) / 64] |= (1ULL << ((i) % 64)))
+#define BITSET_CLR(set, i)      ((set)[(i) / 64] &= ~(1ULL << ((i) % 64)))
+
+// Decoded form of the entry array used on the check path. It is kept in sync
+// with the entry array by write_register() and reset_iopmp(). Entry i covers
+// the bytes [lo[i], hi[i]). An entry with hi[i] < lo[i] never matches, which
+// is how entries in OFF mode are represented. lo[] and hi[] are separate
+// arrays so the matching kernels can load several entries at once.
+// addr[] and cfg[] mirror the entry array without ENTRY_USER_CFG, so neither
+// the check path nor decoding touches its 16-byte records.
+typedef struct {
+    uint64_t *lo;                       // Start byte address (inclusive)
+    uint64_t *hi;                       // End byte address (exclusive)
+    uint16_t *cfg;                      // ENTRY_CFG[15:0], permission and suppression bits
+    uint64_t *addr;                     // ENTRY_ADDRH:ENTRY_ADDR
+} entry_cache_t;
+
+// Candidate entries of each RRID used on the check path. The entries an RRID
+// must check are the spans [lwr_entry[m], upr_entry[m]) of every MD m set in
+// rrid_mds[rrid], visited in ascending MD order. Spans are clipped to
+// HWCFG1.entry_num and nonempty_mds tracks which of them are non-empty.
+// It is kept in sync with SRCMD_EN(H), MDCFG and HWCFG3.md_entry_num by
+// write_register() and reset_iopmp().
+// rrid_{r,w,x}_mds[rrid] bit m is the permission the SRCMD table gives to the
+// RRID in MD m: SRCMD_{R,W,X}(H) in SRCMD table format 0, SRCMD_PERM(H) in
+// format 2 where the execute permission follows the read permission.
+// In SRCMD table format 0, md_rrids[m * RRID_WORDS(rrid_num)] is the bitset of
+// the RRIDs associated with MD m, the transpose of rrid_mds[].
+typedef struct {
+    uint64_t *rrid_mds;                     // MDs associated with each RRID
+    uint64_t *md_rrids;                     // RRIDs associated with each MD, SRCMD table format 0 only
+    uint64_t *rrid_r_mds;                   // MDs the RRID may read
+    uint64_t *rrid_w_mds;                   // MDs the RRID may write
+    uint64_t *rrid_x_mds;                   // MDs the RRID may execute
+    uint64_t nonempty_mds;                  // MDs owning at least one entry
+    uint32_t lwr_entry[IOPMP_MAX_MD_NUM];   // First entry of each MD
+    uint32_t upr_entry[IOPMP_MAX_MD_NUM];   // One past the last entry of each MD
+    bool spans_ordered;                     // Spans are disjoint and in ascending MD order
+} md_cache_t;
+
+#define NONPRIO_INDEX_NIL   0xFFFF
+
+// Interval tree over the decoded ranges of non-priority entries, see
+// iopmp_nonprio_index.c. Nodes are entry indexes; NONPRIO_INDEX_NIL is the
+// empty subtree.
+typedef struct {
+    uint16_t root;
+    uint16_t *left;
+    uint16_t *right;
+    uint64_t *max_hi;                       // Maximum end address of the subtree
+    uint64_t *indexed;                      // Entries in the tree, one bit each
+} nonprio_index_t;
+
+// The decision of the entry checks of a transaction
+typedef struct {
+    bool pass;                          // The transaction is legal
+    uint8_t error_type;                 // Error type of an illegal transaction
+    uint16_t eid;                       // Entry index to report
+    bool gen_intrpt;                    // The error triggers an interrupt
+    bool gen_buserr;                    // The error returns a bus error
+} decision_t;
+
+typedef struct {
+    uint64_t block;                     // Address / DECISION_CACHE_BLOCK
+    uint32_t seq;                       // Odd while the line is being filled
+    uint32_t gen;                       // Generation the line was filled in
+    uint16_t rrid;
+    uint8_t perm_key;                   // (perm << 1) | is_amo
+    decision_t decision;
+} decision_cache_line_t;
+
+// Direct-mapped cache of transaction decisions, see iopmp_decision_cache.c
+typedef struct {
+    uint32_t gen;                       // Current generation
+    iopmp_decision_cache_stats_t stats;
+    decision_cache_line_t lines[DECISION_CACHE_SIZE];
+} decision_cache_t;
+
+// Slot of the violation log
+typedef struct {
+    uint64_t ready;                     // seq + 1 once the record numbered seq is written
+    iopmp_violation_t rec;
+} violation_slot_t;
+
+// Bounded ring of violations, see iopmp_violation_log.c
+typedef struct {
+    uint64_t tail __attribute__((aligned(64)));    // Sequence number of the next record
+    uint64_t dropped;                   // Violations not recorded since the last drain
+    uint64_t head __attribute__((aligned(64)));    // Sequence number of the next record to drain
+    violation_slot_t slots[VIOLATION_LOG_DEPTH];
+} violation_log_t;
+
+// Hit counters of an entry, iopmp_entry_stats_t.matches is grants + denials
+typedef struct {
+    uint64_t grants;
+    uint64_t denials;
+    uint64_t partials;
+} entry_counters_t;
+
+// Hit and scan counters, see iopmp_stats.c. They live in their own block,
+// which isn't part of a checkpoint.
+typedef struct {
+    entry_counters_t *entries;          // Counters of each entry
+    iopmp_rrid_stats_t *rrids;          // Counters of each RRID
+    uint32_t entry_num;                 // Entries with counters
+    uint32_t rrid_num;                  // RRIDs with counters
+    void *block;                        // Memory holding the counters
+    size_t size;                        // Size (in bytes) of the block
+} iopmp_stats_t;
+
+// Trace recorder attached by iopmp_trace_record_start(), see iopmp_trace.c
+typedef struct {
+    FILE *file;
+    long header;                        // Offset of the trace header in the file
+    uint64_t num_records;               // Records written, updated atomically
+    iopmp_allocator_t allocator;        // Allocator of the recorder
+} trace_recorder_t;
+
+// Reader slot of the configuration epoch, one cache line each
+typedef struct {
+    uint32_t active __attribute__((aligned(64)));  // Read sections in progress
+} epoch_slot_t;
+
+// Configuration epoch, see iopmp_epoch.c
+typedef struct {
+    uint32_t epoch;                     // Odd while a write section is in progress
+    bool write_lock;                    // Serializes register accesses
+    epoch_slot_t readers[EPOCH_READER_SLOTS];
+} epoch_t;
+
+// Classes of register offsets below SRCMD_TABLE_BASE_OFFSET
+#define REG_CLASS_NONE          0       // Invalid access
+#define REG_CLASS_CTRL          1       // Control, status and error registers
+#define REG_CLASS_MDCFG         2       // MDCFG table
+#define REG_CLASS_SRCMD         3       // SRCMD table
+#define REG_CLASS_ENTRY         4       // Entry array
+#define REG_KEEPS_DECISIONS     0x80    // Writes never change a decision
+#define REG_CLASS(cls)          ((cls) & ~REG_KEEPS_DECISIONS)
+
+// Register decode table, built by reset_iopmp() from the read-only fields.
+// Offsets below SRCMD_TABLE_BASE_OFFSET are classified one word each, the
+// SRCMD table and entry array by their bounds.
+typedef struct {
+    uint8_t cls[SRCMD_TABLE_BASE_OFFSET / MIN_REG_WIDTH];
+    uint64_t srcmd_end;                 // One past the SRCMD table
+    uint64_t entry_start;               // Entry array
+    uint64_t entry_end;                 // One past the entry array
+    uint32_t md_mask;                   // Implemented MD bits of SRCMD_{EN,R,W,X}
+    uint32_t mdh_mask;                  // Implemented MD bits of SRCMD_{EN,R,W,X}H and MDSTALLH
+    uint32_t mdstall_mask;              // Implemented bits of MDSTALL.md
+} reg_decode_t;
+
+// A decoded access to the MDCFG table, SRCMD table or entry array
+typedef struct {
+    uint32_t idx;                       // Table index
+    uint32_t reg;                       // Register within the table row
+} reg_access_t;
+
+// Checks one transaction request, see validate_select()
+struct validate_ctx_t;
+typedef void (*iopmp_validator_t)(struct iopmp_dev_t *iopmp, const struct validate_ctx_t *ctx,
+                                  uint16_t req_rrid, uint64_t addr, uint32_t length,
+                                  uint32_t size, perm_type_e perm, bool is_amo,
+                                  iopmp_trans_rsp_t *iopmp_trans_rsp, uint8_t *intrpt);
+
+// Memory holding the tables of an IOPMP instance, see iopmp_instance.c
+typedef struct {
+    iopmp_allocator_t allocator;        // Allocates the instance and its tables
+    void *tables;                       // One block holding all tables
+    size_t size;                        // Size (in bytes) of the block
+    size_t used;                        // Size (in bytes) of the tables of the configuration
+    bool owned;                         // The instance is allocated by iopmp_create()
+} iopmp_storage_t;
+
+// Chunks of the tables written since the instance was last in sync with a
+// checkpoint, see iopmp_checkpoint.c
+typedef struct {
+    uint64_t synced;                    // Id of the checkpoint the tables match, 0 if none
+    uint32_t chunk_shift;               // log2 of the size (in bytes) of a chunk
+    uint64_t dirty[CHECKPOINT_CHUNKS / 64];
+} checkpoint_track_t;
+
+// Derived state a register write recomputes, see iopmp_program_begin()
+#define DEFER_NONPRIO_INDEX     (1U << 0)   // nonprio_index_rebuild()
+#define DEFER_MD_SPANS          (1U << 1)   // md_cache_update_spans()
+#define DEFER_RRID_STALL        (1U << 2)   // rrid_stall_update()
+#define DEFER_VALIDATOR         (1U << 3)   // validate_select()
+#define DEFER_DECISIONS         (1U << 4)   // decision_cache_invalidate()
+#define DEFER_STALL_REPLAY      (1U << 5)   // stall_buffer_replay()
+#define DEFER_ALL               0x3F
+
+// Programming session of an IOPMP instance
+typedef struct {
+    bool active;                        // Register writes defer their updates
+    uint32_t pending;                   // DEFER_* updates not yet run
+} program_session_t;
+
 typedef struct iopmp_dev_t {
     iopmp_regs_t reg_file;              // Register file for IOPMP
+    iopmp_srcmds_t iopmp_srcmds;        // IOPMP SRCMD table
     iopmp_entries_t iopmp_entries;      // IOPMP entry table
     err_mfrs_t err_svs;                 // Error status vector
-    int rrid_stall[IOPMP_MAX_RRID_NUM]; // Stall status array for requester IDs
-    int stall_cntr;                     // Counts stalled transactions
-    bool rridscp_unselectable[IOPMP_MAX_RRID_NUM];  // Unselectable RRID in RRID Cherry Pick Stall Control feature
+    uint64_t *rrid_stall;               // Stall status bitset of requester IDs
+    int stall_cntr;                     // Counts stalled transactions, updated atomically
+    iopmp_trans_req_t stall_buf[STALL_BUF_DEPTH];   // Stalled transactions in arrival order, in the first stall_cntr slots
+    uint64_t *rridscp_unselectable;     // Bitset of unselectable RRIDs in RRID Cherry Pick Stall Control feature
     uint64_t granularity;               // The granularity (bytes) of protected regions by entry
     bool imp_mdlck;                     // IOPMP implements the Memory Domain Lock (MDLCK) feature
     bool imp_err_reqid_eid;             // IOPMP implements ERR_REQID.eid
     bool imp_rridscp;                   // IOPMP implements RRIDSCP-related features
     bool imp_stall_buffer;              // IOPMP implements buffer to record and store stalled transactions
+    entry_cache_t entry_cache;          // Decoded entry ranges and permissions
+    md_cache_t md_cache;                // Candidate entry spans of each RRID
+    nonprio_index_t nonprio_index;      // Interval tree of non-priority entries
+    iopmp_validator_t validator;        // Transaction checker for this configuration
+    reg_decode_t reg_decode;            // Register offset decode table
+#if (DECISION_CACHE_EN == 1)
+    decision_cache_t decision_cache;    // Recent transaction decisions
+#endif
+    // The fields below aren't part of a checkpoint, see iopmp_checkpoint.c
+    epoch_t epoch;                      // Orders checks against register writes
+    checkpoint_track_t checkpoint;      // Writes to the tables since the last checkpoint
+    program_session_t program;          // Programming session in progress
+    uint32_t err_rec_claim;             // Set while a primary error capture fills the record
+    iopmp_stall_release_fn_t stall_release;     // Receives the released stalled transactions
+    void *stall_release_ctx;
+#if (VIOLATION_LOG_EN == 1)
+    violation_log_t violation_log;      // Every violation since the last drain
+#endif
+#if (TRACE_EN == 1)
+    trace_recorder_t *trace;            // Records register accesses and transactions
+#endif
+    iopmp_storage_t storage;            // Memory of the tables above
+#if (HIT_STATS_EN == 1)
+    iopmp_stats_t stats;                // Entry hits and entry scans per RRID
+#endif
 } iopmp_dev_t;
 
 // Configurations of IOPMP when reset
@@ -133,8 +362,8 @@ typedef enum {
 // The information the rule analyzer needs
 typedef struct iopmp_rule_analyzer_input_t {
     uint16_t rrid;
-    uint64_t prev_iopmpaddr;
-    uint64_t iopmpaddr;
+    uint64_t lo;                        // Decoded start byte address of the entry
+    uint64_t hi;                        // Decoded end byte address of the entry
     entry_cfg_t iopmpcfg;
     uint64_t trans_start;
     uint64_t trans_end;
@@ -158,12 +387,78 @@ typedef struct iopmp_rule_analyzer_output_t {
 uint8_t write_memory(uint64_t *data, uint64_t addr, uint32_t size);
 
 // Function Declarations: Core IOPMP operations
-void iopmpRuleAnalyzer(iopmp_dev_t *iopmp, iopmp_rule_analyzer_input_t *input,
-                       iopmp_rule_analyzer_output_t *output);
+void validate_select(iopmp_dev_t *iopmp);
+void stall_buffer_replay(iopmp_dev_t *iopmp);
+
+// Decision cache
+void decision_cache_reset(iopmp_dev_t *iopmp);
+void decision_cache_invalidate(iopmp_dev_t *iopmp);
+bool decision_cache_fits(uint64_t trans_start, uint64_t trans_end);
+bool decision_cache_lookup(iopmp_dev_t *iopmp, uint16_t rrid, perm_type_e perm, bool is_amo,
+                           uint64_t trans_start, uint64_t trans_end, decision_t *d);
+void decision_cache_insert(iopmp_dev_t *iopmp, uint16_t rrid, perm_type_e perm, bool is_amo,
+                           uint64_t block_start, const decision_t *d);
+// Instance tables
+int iopmp_tables_reserve(iopmp_dev_t *iopmp, const iopmp_cfg_t *cfg);
+int iopmp_tables_grow(iopmp_dev_t *iopmp, size_t size);
+size_t iopmp_tables_relayout(iopmp_dev_t *iopmp);
+
+// Checkpoint write tracking
+iopmp_checkpoint_t *checkpoint_capture(iopmp_dev_t *iopmp, bool track);
+void checkpoint_mark_dirty(iopmp_dev_t *iopmp, const void *ptr, size_t size);
+
+/* Records a write of size bytes at ptr in the tables for iopmp_restore() */
+static inline void checkpoint_dirty(iopmp_dev_t *iopmp, const void *ptr, size_t size)
+{
+    if (iopmp->checkpoint.synced)
+        checkpoint_mark_dirty(iopmp, ptr, size);
+}
+
+// Records a write of n elements of a table starting at element idx
+#define CHECKPOINT_DIRTY(iopmp, table, idx, n) \
+    checkpoint_dirty((iopmp), &(table)[idx], (n) * sizeof((table)[0]))
+
+// Configuration epoch
+void epoch_read_enter(iopmp_dev_t *iopmp);
+void epoch_read_exit(iopmp_dev_t *iopmp);
+void epoch_write_enter(iopmp_dev_t *iopmp);
+void epoch_write_exit(iopmp_dev_t *iopmp);
+void epoch_lock(iopmp_dev_t *iopmp);
+void epoch_unlock(iopmp_dev_t *iopmp);
+
 void errorCapture(iopmp_dev_t *iopmp, perm_type_e trans_type, uint8_t error_type,
                   uint16_t rrid, uint16_t entry_id, uint64_t err_addr,
                   bool gen_intrpt, bool gen_buserr, uint8_t *intrpt);
 void generate_interrupt(iopmp_dev_t *iopmp, bool gen_intrpt, uint8_t *intrpt);
+int sv_window_take(iopmp_dev_t *iopmp, uint32_t start, uint16_t *svw);
+int stats_reserve(iopmp_dev_t *iopmp, uint32_t entry_num, uint32_t rrid_num);
+void stats_release(iopmp_dev_t *iopmp);
+void violation_log_record(iopmp_dev_t *iopmp, perm_type_e perm, uint8_t etype, uint16_t rrid,
+                          uint16_t eid, uint64_t addr, bool intrpt, bool buserr);
+void trace_record_reg(iopmp_dev_t *iopmp, uint8_t kind, uint64_t offset, reg_intf_dw data,
+                      uint8_t num_bytes);
+void trace_record_trans(iopmp_dev_t *iopmp, const iopmp_trans_req_t *req,
+                        const iopmp_trans_rsp_t *rsp, uint8_t intrpt);
+
+// Entry cache maintenance
+void entry_cache_load(iopmp_dev_t *iopmp, uint32_t entry_idx);
+void entry_cache_update(iopmp_dev_t *iopmp, uint32_t entry_idx);
+void entry_cache_rebuild(iopmp_dev_t *iopmp);
+void md_cache_update_rrid(iopmp_dev_t *iopmp, uint32_t rrid);
+void md_cache_update_perms(iopmp_dev_t *iopmp, uint32_t srcmd_idx);
+void md_cache_update_spans(iopmp_dev_t *iopmp);
+void md_cache_rebuild(iopmp_dev_t *iopmp);
+int md_cache_entry_md(iopmp_dev_t *iopmp, uint32_t entry_idx);
+
+// Non-priority entry index maintenance and lookup
+typedef bool (*nonprio_index_visitor_t)(iopmp_dev_t *iopmp, uint16_t entry_idx, void *arg);
+void nonprio_index_insert(iopmp_dev_t *iopmp, uint32_t entry_idx);
+void nonprio_index_remove(iopmp_dev_t *iopmp, uint32_t entry_idx);
+void nonprio_index_rebuild(iopmp_dev_t *iopmp);
+uint32_t prio_match_first(iopmp_dev_t *iopmp, uint32_t lwr_entry, uint32_t upr_entry,
+                          uint64_t trans_start, uint64_t trans_end);
+bool nonprio_index_query(iopmp_dev_t *iopmp, uint64_t trans_start, uint64_t trans_end,
+                         nonprio_index_visitor_t visit, void *arg);
 
 /*
  * Calculate IOPMP granularity value 'G'
@@ -7,9 +7,209 @@
 typedef struct iopmp_dev_t iopmp_dev_t;
 typedef struct iopmp_cfg_t iopmp_cfg_t;
 
+// Decision cache statistics
+typedef struct {
+    uint64_t hits;              // Transactions decided by a cached decision
+    uint64_t misses;            // Lookups without a valid cached decision
+    uint64_t invalidations;     // Register writes which invalidated the cache
+} iopmp_decision_cache_stats_t;
+
+// Allocator of an IOPMP instance and its tables. alloc returns size bytes
+// aligned to align bytes, or NULL on failure. free may be NULL, e.g. for an
+// arena which is released as a whole.
+typedef struct {
+    void *(*alloc)(void *ctx, size_t size, size_t align);
+    void (*free)(void *ctx, void *ptr);
+    void *ctx;
+} iopmp_allocator_t;
+
+// Cascade of IOPMP instances, see iopmp_cascade.c. Stage s + 1 checks the
+// transactions granted by stage s, with the RRID tagged by stage s.
+typedef struct {
+    iopmp_dev_t **stages;       // Instances from the first to the last stage
+    size_t num_stages;
+} iopmp_cascade_t;
+
+// Route of an IOPMP fabric, see iopmp_fabric.c. A transaction with an RRID
+// in [rrid_lo, rrid_hi) and an address in [addr_lo, addr_hi) is checked by
+// the instance with RRID - rrid_base.
+typedef struct {
+    uint16_t rrid_lo;           // First RRID of the route
+    uint16_t rrid_hi;           // One past the last RRID of the route
+    uint64_t addr_lo;           // First address of the route
+    uint64_t addr_hi;           // One past the last address of the route
+    uint16_t rrid_base;         // Global RRID of RRID 0 of the instance
+    uint32_t instance;          // Index of the instance checking the route
+} iopmp_fabric_route_t;
+
+// Parallel IOPMP instances, see iopmp_fabric_create()
+typedef struct iopmp_fabric_t iopmp_fabric_t;
+
+// Receives a transaction released from the stall buffer, with its response
+// and wired interrupt flag, see iopmp_set_stall_release_callback()
+typedef void (*iopmp_stall_release_fn_t)(void *ctx, const iopmp_trans_req_t *trans_req,
+                                         const iopmp_trans_rsp_t *trans_rsp, uint8_t intrpt);
+
+// A violation recorded by the violation log, see iopmp_violation_log_drain()
+typedef struct {
+    uint64_t seq;               // Sequence number of the record
+    uint64_t addr;              // Address of the transaction
+    uint16_t rrid;              // RRID of the transaction
+    uint16_t eid;               // Entry index reported with the error
+    uint8_t perm;               // Type of the transaction, perm_type_e
+    uint8_t etype;              // Type of the violation, as ERR_INFO.etype
+    bool intrpt;                // The violation triggers an interrupt, it is suppressed otherwise
+    bool buserr;                // The violation returns a bus error, it is suppressed otherwise
+} iopmp_violation_t;
+
+// Hit counters of an entry, see iopmp_get_entry_stats()
+typedef struct {
+    uint64_t matches;           // Transactions matched by all bytes of the entry
+    uint64_t grants;            // Matches granting the transaction
+    uint64_t denials;           // Matches not granting the transaction
+    uint64_t partials;          // Transactions matched by some bytes of the entry
+} iopmp_entry_stats_t;
+
+// Scan counters of an RRID, see iopmp_get_rrid_stats()
+typedef struct {
+    uint64_t transactions;      // Transactions checked against the entries
+    uint64_t entries_scanned;   // Entries before the deciding entry, and the deciding entry
+    uint64_t mds_visited;       // MDs whose entries were scanned
+} iopmp_rrid_stats_t;
+
+// Formats of iopmp_dump_stats()
+typedef enum {
+    IOPMP_STATS_CSV,            // Rows of the entries and RRIDs with a non-zero counter
+    IOPMP_STATS_BINARY,         // iopmp_stats_header_t, then all entries and RRIDs
+} iopmp_stats_format_e;
+
+// Header of a binary dump of the hit counters. It is followed by entry_num
+// iopmp_entry_stats_t and rrid_num iopmp_rrid_stats_t, in host byte order.
+typedef struct {
+    char magic[8];              // "IOPMPHIT"
+    uint32_t version;           // 1
+    uint32_t entry_num;
+    uint32_t rrid_num;
+    uint32_t reserved;
+} iopmp_stats_header_t;
+
+// Entry layout proposed by iopmp_advise_entries(). Entry i of the proposed
+// layout is entry order[i] of the current layout.
+typedef struct {
+    uint32_t *order;            // entry_num current entry indexes
+    uint32_t entry_num;
+    uint32_t prio_entry;        // Proposed HWCFG2.prio_entry
+    uint32_t md_num;            // MDs with a proposed MDCFG(m).t, 0 without MDCFG table
+    uint32_t mdcfg_t[IOPMP_MAX_MD_NUM];     // Proposed MDCFG(m).t
+    uint64_t scanned;           // Entries the trace scans with the current layout
+    uint64_t scanned_advised;   // Entries the trace scans with the proposed layout
+    iopmp_allocator_t allocator;            // Allocator of order
+} iopmp_entry_advice_t;
+
+// Kinds of the records of a trace
+typedef enum {
+    IOPMP_TRACE_WRITE = 1,      // write_register()
+    IOPMP_TRACE_READ  = 2,      // read_register() and the data read
+    IOPMP_TRACE_TRANS = 3,      // iopmp_validate_access() and its response
+} iopmp_trace_kind_e;
+
+// iopmp_trace_record_t.flags of a transaction
+#define IOPMP_TRACE_AMO             (1U << 0)   // iopmp_trans_req_t.is_amo
+#define IOPMP_TRACE_ERROR           (1U << 1)   // iopmp_trans_rsp_t.status is IOPMP_ERROR
+#define IOPMP_TRACE_INTRPT          (1U << 2)   // The wired interrupt flag
+#define IOPMP_TRACE_STALLED         (1U << 3)   // iopmp_trans_rsp_t.rrid_stalled
+#define IOPMP_TRACE_NO_BUFFER       (1U << 4)   // iopmp_trans_rsp_t.rrid_stalled_no_available_buffer
+
+// Record of a trace, see iopmp_trace.c
+typedef struct {
+    uint8_t kind;               // iopmp_trace_kind_e
+    uint8_t num_bytes;          // Register access: bytes accessed
+    uint8_t perm;               // Transaction: perm_type_e
+    uint8_t flags;              // Transaction: IOPMP_TRACE_* flags
+    uint16_t rrid;              // Transaction: RRID of the request
+    uint8_t user;               // Transaction: iopmp_trans_rsp_t.user
+    uint8_t rsv;
+    uint64_t addr;              // Register offset, or address of the transaction
+    union {
+        uint64_t data;          // Register access: data written or read
+        struct {
+            uint32_t length;    // Transaction: length of the request
+            uint32_t size;      // Transaction: size of the request
+        };
+    };
+    uint32_t rsp_rrid;          // Transaction: iopmp_trans_rsp_t.rrid
+    uint16_t rrid_transl;       // Transaction: iopmp_trans_rsp_t.rrid_transl
+    uint16_t rsv2;
+} iopmp_trace_record_t;
+
+// Header of a trace, followed by its records, in host byte order
+typedef struct {
+    char magic[8];              // "IOPMPTRC"
+    uint32_t version;           // 1
+    uint32_t record_size;       // sizeof(iopmp_trace_record_t)
+    uint64_t num_records;       // 0 if the trace wasn't stopped, the size of the trace tells then
+    uint64_t reserved;
+} iopmp_trace_header_t;
+
+// Results of iopmp_trace_replay()
+typedef struct {
+    uint64_t writes;            // Register writes replayed
+    uint64_t reads;             // Register reads replayed
+    uint64_t transactions;      // Transactions replayed
+    uint64_t mismatches;        // Reads and transactions not getting the recorded result
+    uint64_t first_mismatch;    // Index of the first of them, UINT64_MAX if none
+    double seconds;             // Duration of the replay
+    double trans_per_sec;       // Transactions replayed per second
+} iopmp_trace_replay_stats_t;
+
+// Saved state of an IOPMP instance, see iopmp_checkpoint()
+typedef struct iopmp_checkpoint_t iopmp_checkpoint_t;
+
+extern iopmp_dev_t *iopmp_create(iopmp_cfg_t *cfg, const iopmp_allocator_t *allocator);
+extern void iopmp_destroy(iopmp_dev_t *iopmp);
 extern int reset_iopmp(iopmp_dev_t *iopmp, iopmp_cfg_t *cfg);
 extern reg_intf_dw read_register(iopmp_dev_t *iopmp, uint64_t offset, uint8_t num_bytes);
 extern void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8_t num_bytes);
+extern void write_register_block(iopmp_dev_t *iopmp, uint64_t offset, const reg_intf_dw *data,
+                                 size_t count, uint8_t num_bytes);
+extern void iopmp_program_begin(iopmp_dev_t *iopmp);
+extern void iopmp_program_commit(iopmp_dev_t *iopmp);
 extern void iopmp_validate_access(iopmp_dev_t *iopmp, iopmp_trans_req_t *trans_req, iopmp_trans_rsp_t* iopmp_trans_rsp, uint8_t *intrpt);
+extern void iopmp_set_stall_release_callback(iopmp_dev_t *iopmp, iopmp_stall_release_fn_t fn, void *ctx);
+extern void iopmp_get_decision_cache_stats(iopmp_dev_t *iopmp, iopmp_decision_cache_stats_t *stats);
+extern int iopmp_get_entry_stats(iopmp_dev_t *iopmp, uint32_t entry_idx, iopmp_entry_stats_t *stats);
+extern int iopmp_get_rrid_stats(iopmp_dev_t *iopmp, uint32_t rrid, iopmp_rrid_stats_t *stats);
+extern void iopmp_clear_stats(iopmp_dev_t *iopmp);
+extern int iopmp_dump_stats(iopmp_dev_t *iopmp, FILE *file, iopmp_stats_format_e format);
+extern size_t iopmp_violation_log_drain(iopmp_dev_t *iopmp, iopmp_violation_t *records, size_t max,
+                                        uint64_t *dropped);
+extern int iopmp_advise_entries(iopmp_dev_t *iopmp, const iopmp_trans_req_t *trace, size_t n,
+                                iopmp_entry_advice_t *advice);
+extern int iopmp_emit_entry_advice(iopmp_dev_t *iopmp, const iopmp_entry_advice_t *advice,
+                                   FILE *file, const char *name);
+extern void iopmp_entry_advice_free(iopmp_entry_advice_t *advice);
+extern int iopmp_trace_record_start(iopmp_dev_t *iopmp, FILE *file);
+extern int iopmp_trace_record_stop(iopmp_dev_t *iopmp);
+extern int iopmp_trace_replay(iopmp_dev_t *iopmp, const void *trace, size_t size,
+                              iopmp_trace_replay_stats_t *stats);
+extern int iopmp_trace_replay_file(iopmp_dev_t *iopmp, FILE *file, iopmp_trace_replay_stats_t *stats);
+extern void iopmp_validate_access_batch(iopmp_dev_t *iopmp, const iopmp_trans_req_batch_t *reqs,
+                                        iopmp_trans_rsp_t *rsps, uint8_t *intrpts, size_t n);
+extern iopmp_checkpoint_t *iopmp_checkpoint(iopmp_dev_t *iopmp);
+extern int iopmp_restore(iopmp_dev_t *iopmp, const iopmp_checkpoint_t *ckpt);
+extern size_t iopmp_checkpoint_size(const iopmp_checkpoint_t *ckpt);
+extern void iopmp_checkpoint_free(iopmp_checkpoint_t *ckpt);
+extern size_t iopmp_cascade_validate(const iopmp_cascade_t *cascade, const iopmp_trans_req_t *trans_req,
+                                     iopmp_trans_rsp_t *rsps, uint8_t *intrpts);
+extern void iopmp_cascade_validate_batch(const iopmp_cascade_t *cascade, const iopmp_trans_req_batch_t *reqs,
+                                         iopmp_trans_rsp_t *rsps, uint8_t *intrpts,
+                                         uint32_t *stages_checked, size_t n);
+extern iopmp_fabric_t *iopmp_fabric_create(iopmp_dev_t **instances, size_t num_instances,
+                                           const iopmp_fabric_route_t *routes, size_t num_routes,
+                                           bool threaded);
+extern void iopmp_fabric_destroy(iopmp_fabric_t *fabric);
+extern void iopmp_fabric_validate_batch(iopmp_fabric_t *fabric, const iopmp_trans_req_batch_t *reqs,
+                                        iopmp_trans_rsp_t *rsps, uint8_t *intrpts,
+                                        int32_t *routed_to, size_t n);
 
 #endif
@@ -673,25 +673,36 @@ typedef union {
         uint32_t         reserved4[472];
         mdcfg_t          mdcfg[IOPMP_MAX_MD_NUM];
         uint32_t         reserved5[(SRCMD_TABLE_BASE_OFFSET - (MDCFG_TABLE_BASE_OFFSET + (IOPMP_MAX_MD_NUM * 4))) / 4];
-        srcmd_table_t    srcmd_table[IOPMP_MAX_RRID_NUM];
     };
-    uint32_t regs4[(SRCMD_TABLE_BASE_OFFSET + (ALIGNUP(IOPMP_MAX_RRID_NUM, sizeof(uint32_t)) * SRCMD_REG_STRIDE)) / sizeof(uint32_t)];
-    uint64_t regs8[(SRCMD_TABLE_BASE_OFFSET + (ALIGNUP(IOPMP_MAX_RRID_NUM, sizeof(uint32_t)) * SRCMD_REG_STRIDE)) / sizeof(uint64_t)];
+    uint32_t regs4[SRCMD_TABLE_BASE_OFFSET / sizeof(uint32_t)];
+    uint64_t regs8[SRCMD_TABLE_BASE_OFFSET / sizeof(uint64_t)];
 } iopmp_regs_t;
 
+// IOPMP SRCMD table at SRCMD_TABLE_BASE_OFFSET, sized for the configuration
+// of the instance when reset
 typedef union {
-    struct __attribute__((__packed__)) {
-        entry_table_t    entry_table[IOPMP_MAX_ENTRY_NUM];
-    };
-    uint32_t regs4[(ALIGNUP(IOPMP_MAX_ENTRY_NUM, sizeof(uint32_t)) * ENTRY_REG_STRIDE) / sizeof(uint32_t)];
-    uint64_t regs8[(ALIGNUP(IOPMP_MAX_ENTRY_NUM, sizeof(uint32_t)) * ENTRY_REG_STRIDE) / sizeof(uint64_t)];
+    srcmd_table_t *srcmd_table;
+    uint32_t *regs4;
+    uint64_t *regs8;
+} iopmp_srcmds_t;
+
+// IOPMP entry array at ENTRYOFFSET, sized for the configuration of the
+// instance when reset
+typedef union {
+    entry_table_t *entry_table;
+    uint32_t *regs4;
+    uint64_t *regs8;
 } iopmp_entries_t;
 
-// Number of subsequent violation record windows to accommodate all RRIDs.
+// Maximum number of subsequent violation record windows to accommodate all RRIDs.
 #define NUM_SVW         (ALIGNUP(IOPMP_MAX_RRID_NUM, 16) / 16)
 
 typedef struct {
-    err_mfr_t sv[NUM_SVW];
+    err_mfr_t *sv;                          // Windows of HWCFG1.rrid_num RRIDs
+    uint64_t *summary;                      // Bit w is set if window w has a violation
+    uint64_t top;                           // Bit j is set if summary[j] is not zero, the
+                                            // NUM_SVW windows need 64 summary words at most
+    uint32_t num;                           // Number of windows
 } err_mfrs_t;
 
 #endif
\ No newline at end of file
@@ -38,6 +38,18 @@ typedef struct __attribute__((__packed__)) {
     bool        is_amo;    // Indicates the AMO Access
 } iopmp_trans_req_t;
 
+// Batch of IOPMP transaction requests in structure-of-arrays layout. Request
+// i is made of element i of every array. Each array should be aligned to 64
+// bytes, e.g. allocated with aligned_alloc(64, ...).
+typedef struct {
+    uint64_t    *addr;     // Target addresses for the transactions
+    uint32_t    *length;   // Lengths of the transactions
+    uint32_t    *size;     // Sizes of each access in the transactions
+    uint16_t    *rrid;     // Requester IDs
+    uint8_t     *perm;     // Types of permission requested, perm_type_e
+    bool        *is_amo;   // Indicate the AMO accesses
+} iopmp_trans_req_batch_t;
+
 // Enumerates status results for IOPMP transactions
 typedef enum {
     IOPMP_SUCCESS = 0,  // Transaction successful
@@ -0,0 +1,334 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Lookup Caches
+// This file maintains state derived from the register file which the check
+// path uses instead of decoding registers for every transaction. The caches
+// are rebuilt by reset_iopmp() and updated incrementally by write_register()
+// whenever a register they depend on is written.
+//
+// The main functions in this file include:
+// - entry_cache_load: Mirrors the address and configuration of one entry.
+// - entry_cache_update: Decodes one entry into its byte range and
+//   permission bits.
+// - entry_cache_rebuild: Decodes every implemented entry.
+// - md_cache_update_rrid: Recomputes the MDs associated with one RRID.
+// - md_cache_update_perms: Recomputes the SRCMD permissions of one SRCMD
+//   table entry.
+// - md_cache_update_spans: Recomputes the entry span of every MD.
+// - md_cache_rebuild: Recomputes the whole MD cache.
+// - md_cache_entry_md: Finds the MD an entry belongs to.
+***************************************************************************/
+
+#include "iopmp.h"
+
+/**
+  * @brief Computes the address range based on the IOPMP entry configuration.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param startAddr Pointer to store the start address of the range
+  * @param endAddr Pointer to store the end address of the range
+  * @param prev_iopmpaddr Previous IOPMP address (used in TOR mode)
+  * @param iopmpaddr Current IOPMP address
+  * @param iopmpcfg IOPMP entry configuration
+  * @return 0 on success, 1 if the IOPMP entry is disabled
+ **/
+static int iopmpAddrRange(iopmp_dev_t *iopmp, uint64_t *startAddr, uint64_t *endAddr, uint64_t prev_iopmpaddr, uint64_t iopmpaddr, entry_cfg_t iopmpcfg) {
+    uint64_t napot_mask;
+    // Check if IOPMP entry is OFF
+    if (iopmpcfg.a == IOPMP_OFF) { return 1; }
+
+    uint8_t G = get_granularity_G(iopmp);
+
+    switch (iopmpcfg.a) {
+        case IOPMP_NA4:  // Address range covers a single 4-byte address
+            *startAddr = iopmpaddr;
+            *endAddr   = iopmpaddr + 1;
+            break;
+
+        case IOPMP_TOR: // Address range specified by top-of-range mode
+            /* Bits [G-1:0] do not affect the TOR address-matching logic */
+            if (G >= 1) {
+                uint64_t G_mask = gen_granularity_tor_mask(G);
+                prev_iopmpaddr &= ~G_mask;
+                iopmpaddr      &= ~G_mask;
+            }
+            *startAddr = prev_iopmpaddr;
+            *endAddr   = iopmpaddr;
+            break;
+
+        default:  // Assume NAPOT (Naturally Aligned Power-of-Two) mode
+            /* When G>=2 and the mode is NAPOT, bits [G-2:0] read as all ones */
+            if (G >= 2) {
+                uint64_t G_mask = gen_granularity_napot_mask(G);
+                iopmpaddr |= G_mask;
+            }
+            napot_mask = iopmpaddr ^ (iopmpaddr + 1);
+            *startAddr = iopmpaddr & ~napot_mask;
+            *endAddr   = *startAddr + napot_mask + 1;
+            break;
+    }
+
+    return 0;
+}
+
+/**
+  * @brief Mirrors the address and configuration of an entry into the entry cache.
+  *
+  * The entry array stays the source of truth for read_register(). It must be
+  * called whenever ENTRY_ADDR(H) or ENTRY_CFG of the entry is written, before
+  * entry_cache_update().
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_idx The index of the entry.
+ **/
+void entry_cache_load(iopmp_dev_t *iopmp, uint32_t entry_idx)
+{
+    entry_table_t entry = iopmp->iopmp_entries.entry_table[entry_idx];
+
+    iopmp->entry_cache.addr[entry_idx] = CONCAT32(entry.entry_addrh.addrh, entry.entry_addr.addr);
+    iopmp->entry_cache.cfg[entry_idx]  = (uint16_t)entry.entry_cfg.raw;
+    CHECKPOINT_DIRTY(iopmp, iopmp->entry_cache.addr, entry_idx, 1);
+    CHECKPOINT_DIRTY(iopmp, iopmp->entry_cache.cfg, entry_idx, 1);
+}
+
+/**
+  * @brief Decodes an entry into the entry cache.
+  *
+  * A TOR entry takes its start address from the previous entry, so a write to
+  * ENTRY_ADDR(i) or ENTRY_ADDRH(i) must also update entry i+1. Only the
+  * mirrored address and configuration are read, see entry_cache_load().
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_idx The index of the entry to decode.
+ **/
+void entry_cache_update(iopmp_dev_t *iopmp, uint32_t entry_idx)
+{
+    entry_cfg_t iopmpcfg = { .raw = iopmp->entry_cache.cfg[entry_idx] };
+    uint64_t prev_iopmpaddr, iopmpaddr;
+    uint64_t start_addr, end_addr;
+
+    prev_iopmpaddr = (entry_idx == 0) ? 0 : iopmp->entry_cache.addr[entry_idx - 1];
+    iopmpaddr      = iopmp->entry_cache.addr[entry_idx];
+
+    // The index is keyed by the decoded range, so take the entry out first
+    nonprio_index_remove(iopmp, entry_idx);
+
+    if (iopmpAddrRange(iopmp, &start_addr, &end_addr, prev_iopmpaddr,
+                       iopmpaddr, iopmpcfg)) {
+        // Disabled entry: an inverted range never matches
+        iopmp->entry_cache.lo[entry_idx] = 1;
+        iopmp->entry_cache.hi[entry_idx] = 0;
+    } else {
+        // Multiply the addresses with 4 is equivalent to (Address << 2)
+        iopmp->entry_cache.lo[entry_idx] = start_addr * 4;
+        iopmp->entry_cache.hi[entry_idx] = end_addr * 4;
+    }
+    CHECKPOINT_DIRTY(iopmp, iopmp->entry_cache.lo, entry_idx, 1);
+    CHECKPOINT_DIRTY(iopmp, iopmp->entry_cache.hi, entry_idx, 1);
+
+    nonprio_index_insert(iopmp, entry_idx);
+}
+
+/**
+  * @brief Decodes all implemented entries into the entry cache.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void entry_cache_rebuild(iopmp_dev_t *iopmp)
+{
+    size_t words = ALIGNUP(iopmp->reg_file.hwcfg1.entry_num, 64) / 64;
+
+    iopmp->nonprio_index.root = NONPRIO_INDEX_NIL;
+    memset(iopmp->nonprio_index.indexed, 0, words * sizeof(uint64_t));
+    CHECKPOINT_DIRTY(iopmp, iopmp->nonprio_index.indexed, 0, words);
+    for (uint32_t i = 0; i < iopmp->reg_file.hwcfg1.entry_num; i++) {
+        entry_cache_load(iopmp, i);
+    }
+    for (uint32_t i = 0; i < iopmp->reg_file.hwcfg1.entry_num; i++) {
+        entry_cache_update(iopmp, i);
+    }
+}
+
+/**
+  * @brief Recomputes the MDs associated with an RRID in the MD cache.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param rrid The RRID whose SRCMD table entry has changed.
+ **/
+void md_cache_update_rrid(iopmp_dev_t *iopmp, uint32_t rrid)
+{
+    uint64_t mds = 0;
+    uint64_t changed;
+
+    switch (iopmp->reg_file.hwcfg3.srcmd_fmt) {
+    case 0:
+        // SRCMD_EN(H) hold the MDs associated with the RRID
+        mds = ((uint64_t)iopmp->iopmp_srcmds.srcmd_table[rrid].srcmd_enh.mdh << 31) |
+              iopmp->iopmp_srcmds.srcmd_table[rrid].srcmd_en.md;
+        break;
+    case 1:
+        // RRID i associates exclusively with MD i
+        mds = 1ULL << rrid;
+        break;
+    case 2:
+        // Every MD is associated with all RRIDs
+        mds = UINT64_MAX;
+        break;
+    default:
+        break;
+    }
+
+    changed = iopmp->md_cache.rrid_mds[rrid] ^ mds;
+    iopmp->md_cache.rrid_mds[rrid] = mds;
+    CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_mds, rrid, 1);
+
+    // Keep the RRID bitsets of the MDs in sync for rrid_stall_update()
+    if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0) {
+        uint32_t rrid_words = RRID_WORDS(iopmp->reg_file.hwcfg1.rrid_num);
+
+        for (; changed; changed &= changed - 1) {
+            uint64_t *md_rrids = &iopmp->md_cache.md_rrids[__builtin_ctzll(changed) * rrid_words];
+
+            md_rrids[rrid / 64] ^= (1ULL << (rrid % 64));
+            CHECKPOINT_DIRTY(iopmp, md_rrids, rrid / 64, 1);
+        }
+    }
+}
+
+/**
+  * @brief Recomputes the SRCMD table permissions in the MD cache.
+  *
+  * In SRCMD table format 0 the SRCMD table is indexed by RRID, so only the
+  * permissions of RRID srcmd_idx change. In format 2 it is indexed by MD, and
+  * the permissions of every RRID in MD srcmd_idx change.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param srcmd_idx The index of the SRCMD table entry which has changed.
+ **/
+void md_cache_update_perms(iopmp_dev_t *iopmp, uint32_t srcmd_idx)
+{
+    srcmd_table_t srcmd = iopmp->iopmp_srcmds.srcmd_table[srcmd_idx];
+
+    switch (iopmp->reg_file.hwcfg3.srcmd_fmt) {
+    case 0:
+        // Bit m+1 of SRCMD_{R,W,X}(H) holds the permission in MD m
+        iopmp->md_cache.rrid_r_mds[srcmd_idx] = CONCAT32(srcmd.srcmd_rh.raw, srcmd.srcmd_r.raw) >> 1;
+        iopmp->md_cache.rrid_w_mds[srcmd_idx] = CONCAT32(srcmd.srcmd_wh.raw, srcmd.srcmd_w.raw) >> 1;
+        iopmp->md_cache.rrid_x_mds[srcmd_idx] = CONCAT32(srcmd.srcmd_xh.raw, srcmd.srcmd_x.raw) >> 1;
+        CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_r_mds, srcmd_idx, 1);
+        CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_w_mds, srcmd_idx, 1);
+        CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_x_mds, srcmd_idx, 1);
+        break;
+    case 2: {
+        // Bits 2s and 2s+1 of SRCMD_PERM(H) hold the permissions of RRID s
+        uint64_t perm = CONCAT32(srcmd.srcmd_permh.raw, srcmd.srcmd_perm.raw);
+        uint64_t md_bit = 1ULL << srcmd_idx;
+        uint32_t rrid_num = (iopmp->reg_file.hwcfg1.rrid_num < 32) ? iopmp->reg_file.hwcfg1.rrid_num : 32;
+
+        for (uint32_t rrid = 0; rrid < rrid_num; rrid++) {
+            bool r = GET_BIT(perm, (rrid * 2));
+            bool w = GET_BIT(perm, ((rrid * 2) + 1));
+
+            iopmp->md_cache.rrid_r_mds[rrid] = (iopmp->md_cache.rrid_r_mds[rrid] & ~md_bit) | (r ? md_bit : 0);
+            iopmp->md_cache.rrid_w_mds[rrid] = (iopmp->md_cache.rrid_w_mds[rrid] & ~md_bit) | (w ? md_bit : 0);
+            iopmp->md_cache.rrid_x_mds[rrid] = iopmp->md_cache.rrid_r_mds[rrid];
+        }
+        CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_r_mds, 0, rrid_num);
+        CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_w_mds, 0, rrid_num);
+        CHECKPOINT_DIRTY(iopmp, iopmp->md_cache.rrid_x_mds, 0, rrid_num);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/**
+  * @brief Recomputes the entry span of every MD in the MD cache.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void md_cache_update_spans(iopmp_dev_t *iopmp)
+{
+    uint32_t entry_num = iopmp->reg_file.hwcfg1.entry_num;
+    uint32_t lwr_entry, upr_entry;
+
+    iopmp->md_cache.nonempty_mds  = 0;
+    iopmp->md_cache.spans_ordered = true;
+    for (int m = 0; m < iopmp->reg_file.hwcfg0.md_num; m++) {
+        if (iopmp->reg_file.hwcfg3.mdcfg_fmt == 0) {
+            lwr_entry = (m == 0) ? 0 : iopmp->reg_file.mdcfg[m - 1].t;
+            upr_entry = iopmp->reg_file.mdcfg[m].t;
+        } else {
+            lwr_entry = m * (iopmp->reg_file.hwcfg3.md_entry_num + 1);
+            upr_entry = (m + 1) * (iopmp->reg_file.hwcfg3.md_entry_num + 1);
+        }
+
+        // Any entry with index >= HWCFG1.entry_num is not available
+        if (upr_entry > entry_num)
+            upr_entry = entry_num;
+
+        iopmp->md_cache.lwr_entry[m] = lwr_entry;
+        iopmp->md_cache.upr_entry[m] = upr_entry;
+        // An improper MDCFG table may let MDs overlap or go backwards
+        if ((m > 0) && (upr_entry < iopmp->md_cache.upr_entry[m - 1]))
+            iopmp->md_cache.spans_ordered = false;
+        if (lwr_entry < upr_entry)
+            iopmp->md_cache.nonempty_mds |= (1ULL << m);
+    }
+}
+
+/**
+  * @brief Recomputes the whole MD cache.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void md_cache_rebuild(iopmp_dev_t *iopmp)
+{
+    for (uint32_t i = 0; i < iopmp->reg_file.hwcfg1.rrid_num; i++) {
+        md_cache_update_rrid(iopmp, i);
+    }
+    if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0) {
+        for (uint32_t i = 0; i < iopmp->reg_file.hwcfg1.rrid_num; i++) {
+            md_cache_update_perms(iopmp, i);
+        }
+    } else if (iopmp->reg_file.hwcfg3.srcmd_fmt == 2) {
+        for (uint32_t i = 0; i < iopmp->reg_file.hwcfg0.md_num; i++) {
+            md_cache_update_perms(iopmp, i);
+        }
+    }
+    md_cache_update_spans(iopmp);
+}
+
+/**
+  * @brief Finds the MD an entry belongs to.
+  *
+  * The result is only meaningful when md_cache.spans_ordered is true, in
+  * which case every entry belongs to at most one MD.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_idx The index of the entry.
+  * @return The MD owning the entry, or -1 if no MD owns it.
+ **/
+int md_cache_entry_md(iopmp_dev_t *iopmp, uint32_t entry_idx)
+{
+    int lo = 0, hi = iopmp->reg_file.hwcfg0.md_num;
+
+    // Find the first MD whose span ends after the entry
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (iopmp->md_cache.upr_entry[mid] > entry_idx)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    if ((lo == iopmp->reg_file.hwcfg0.md_num) ||
+        (iopmp->md_cache.lwr_entry[lo] > entry_idx))
+        return -1;
+    return lo;
+}
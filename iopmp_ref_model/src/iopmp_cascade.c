@@ -0,0 +1,134 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Cascade
+// Cascaded IOPMPs check a transaction one after another. A stage tags the
+// transactions it grants with HWCFG3.rrid_transl, or keeps the RRID of the
+// transaction if it doesn't implement RRID translation, and the next stage
+// checks them with this RRID. A transaction which is faulted or stalled by a
+// stage doesn't reach the following stages.
+//
+// The batch path checks up to CASCADE_CHUNK requests at every stage before
+// moving to the next stage, and forwards only the granted requests. Every
+// stage is a separate instance, and sees the requests in the same order as
+// the single request path, so both give the same results.
+//
+// The main functions in this file include:
+// - iopmp_cascade_validate: Checks a request through all stages.
+// - iopmp_cascade_validate_batch: Checks a batch of requests through all
+//   stages.
+***************************************************************************/
+
+#include "iopmp.h"
+
+// Requests forwarded from one stage to the next at once by the batch path
+#define CASCADE_CHUNK   64
+
+/**
+  * @brief Checks a transaction request through the stages of a cascade.
+  *
+  * @param cascade The cascade of IOPMP instances.
+  * @param trans_req The transaction request entering the first stage.
+  * @param rsps Array of the responses of each stage.
+  * @param intrpts Array of the wired interrupt flags of each stage, see
+  *                iopmp_validate_access().
+  * @return The number of stages which checked the request. The request
+  *         passes the cascade if every stage checked it and the response of
+  *         the last stage is IOPMP_SUCCESS. Otherwise the response of the
+  *         last stage which checked it tells why it was stopped.
+ **/
+size_t iopmp_cascade_validate(const iopmp_cascade_t *cascade, const iopmp_trans_req_t *trans_req,
+                              iopmp_trans_rsp_t *rsps, uint8_t *intrpts)
+{
+    iopmp_trans_req_t req = *trans_req;
+    size_t s;
+
+    for (s = 0; s < cascade->num_stages; s++) {
+        iopmp_validate_access(cascade->stages[s], &req, &rsps[s], &intrpts[s]);
+        // Only the transactions granted by this stage reach the next one
+        if (rsps[s].status != IOPMP_SUCCESS)
+            return s + 1;
+        req.rrid = rsps[s].rrid_transl;
+    }
+    return s;
+}
+
+/**
+  * @brief Checks a batch of transaction requests through the stages of a cascade.
+  *
+  * The result is the same as calling iopmp_cascade_validate() on each request
+  * in order.
+  *
+  * @param cascade The cascade of IOPMP instances.
+  * @param reqs The transaction requests in structure-of-arrays layout.
+  * @param rsps Array of num_stages * n responses, rsps[s * n + i] is the
+  *             response of stage s to request i.
+  * @param intrpts Array of num_stages * n wired interrupt flags, in the same
+  *                layout as \p rsps.
+  * @param stages_checked Array of n numbers of stages which checked each
+  *                       request, see iopmp_cascade_validate(). The
+  *                       responses of the later stages are left unchanged.
+  * @param n Number of requests in the batch.
+ **/
+void iopmp_cascade_validate_batch(const iopmp_cascade_t *cascade, const iopmp_trans_req_batch_t *reqs,
+                                  iopmp_trans_rsp_t *rsps, uint8_t *intrpts,
+                                  uint32_t *stages_checked, size_t n)
+{
+    uint64_t addr[CASCADE_CHUNK]   __attribute__((aligned(64)));
+    uint32_t length[CASCADE_CHUNK] __attribute__((aligned(64)));
+    uint32_t size[CASCADE_CHUNK]   __attribute__((aligned(64)));
+    uint16_t rrid[CASCADE_CHUNK]   __attribute__((aligned(64)));
+    uint8_t  perm[CASCADE_CHUNK]   __attribute__((aligned(64)));
+    bool     is_amo[CASCADE_CHUNK] __attribute__((aligned(64)));
+    size_t   req_idx[CASCADE_CHUNK];
+    iopmp_trans_rsp_t chunk_rsps[CASCADE_CHUNK];
+    uint8_t chunk_intrpts[CASCADE_CHUNK];
+    iopmp_trans_req_batch_t fwd = { addr, length, size, rrid, perm, is_amo };
+
+    for (size_t base = 0; base < n; base += CASCADE_CHUNK) {
+        size_t live = ((n - base) < CASCADE_CHUNK) ? (n - base) : CASCADE_CHUNK;
+
+        for (size_t i = 0; i < live; i++) {
+            req_idx[i] = base + i;
+            addr[i]    = reqs->addr[base + i];
+            length[i]  = reqs->length[base + i];
+            size[i]    = reqs->size[base + i];
+            rrid[i]    = reqs->rrid[base + i];
+            perm[i]    = reqs->perm[base + i];
+            is_amo[i]  = reqs->is_amo[base + i];
+            stages_checked[base + i] = 0;
+        }
+
+        for (size_t s = 0; (s < cascade->num_stages) && live; s++) {
+            size_t next = 0;
+
+            // The batch check sets the interrupt flag of every request
+            memset(chunk_rsps, 0, live * sizeof(chunk_rsps[0]));
+            iopmp_validate_access_batch(cascade->stages[s], &fwd, chunk_rsps, chunk_intrpts, live);
+
+            // Keep the granted requests, in order, for the next stage
+            for (size_t i = 0; i < live; i++) {
+                size_t r = req_idx[i];
+
+                rsps[(s * n) + r]    = chunk_rsps[i];
+                intrpts[(s * n) + r] = chunk_intrpts[i];
+                stages_checked[r]    = s + 1;
+                if (chunk_rsps[i].status != IOPMP_SUCCESS)
+                    continue;
+
+                req_idx[next] = r;
+                addr[next]    = addr[i];
+                length[next]  = length[i];
+                size[next]    = size[i];
+                rrid[next]    = chunk_rsps[i].rrid_transl;
+                perm[next]    = perm[i];
+                is_amo[next]  = is_amo[i];
+                next++;
+            }
+            live = next;
+        }
+    }
+}
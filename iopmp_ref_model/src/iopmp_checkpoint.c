@@ -0,0 +1,218 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Checkpoint and Restore
+// A checkpoint holds the whole state of an IOPMP instance: the register file,
+// the SRCMD table, the entry array, the MFR windows, the stall state and the
+// lookup caches. It is one block made of the fields of iopmp_dev_t before
+// the epoch, followed by a copy of the tables of the instance.
+//
+// Restoring a checkpoint always copies the fields of iopmp_dev_t, which are
+// small. The tables are split into CHECKPOINT_CHUNKS chunks, and every write
+// to them is recorded in a bitmap while the instance is in sync with a
+// checkpoint. Restoring that checkpoint again only copies the chunks written
+// since then. Other restores copy the whole tables.
+//
+// The main functions in this file include:
+// - iopmp_checkpoint: Captures the state of an IOPMP instance.
+// - checkpoint_capture: Captures the state, optionally without tracking it.
+// - iopmp_restore: Restores the state of an IOPMP instance.
+// - iopmp_checkpoint_size: Returns the size of a checkpoint.
+// - iopmp_checkpoint_free: Releases a checkpoint.
+// - checkpoint_mark_dirty: Records a write to the tables.
+***************************************************************************/
+
+#include <stddef.h>
+#include "iopmp.h"
+
+// The fields of iopmp_dev_t captured by a checkpoint
+#define STATE_SIZE      offsetof(iopmp_dev_t, epoch)
+// Offset of the tables in a checkpoint
+#define TABLES_OFFSET   ALIGNUP(sizeof(iopmp_checkpoint_t) + STATE_SIZE, 64)
+// The smallest chunk tracked, in log2 bytes
+#define MIN_CHUNK_SHIFT 8
+
+struct iopmp_checkpoint_t {
+    uint64_t id;                        // Unique id, never 0
+    iopmp_allocator_t allocator;        // Allocator of the checkpoint
+    size_t size;                        // Size (in bytes) of the checkpoint
+    size_t tables_size;                 // Size (in bytes) of the tables
+    uint8_t state[];                    // STATE_SIZE bytes, then the tables at TABLES_OFFSET
+};
+
+static uint64_t checkpoint_next_id;
+
+static inline const uint8_t *checkpoint_tables(const iopmp_checkpoint_t *ckpt)
+{
+    return (const uint8_t *)ckpt + TABLES_OFFSET;
+}
+
+/* Starts tracking the writes to the tables against checkpoint id */
+static void checkpoint_track(iopmp_dev_t *iopmp, uint64_t id)
+{
+    checkpoint_track_t *track = &iopmp->checkpoint;
+    uint32_t shift = MIN_CHUNK_SHIFT;
+
+    while (((iopmp->storage.used + (1ULL << shift) - 1) >> shift) > CHECKPOINT_CHUNKS)
+        shift++;
+
+    track->synced      = id;
+    track->chunk_shift = shift;
+    memset(track->dirty, 0, sizeof(track->dirty));
+}
+
+/**
+  * @brief Records a write to the tables of an IOPMP instance.
+  *
+  * Use checkpoint_dirty(), which skips instances not in sync with a checkpoint.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param ptr The first byte written, in the tables of the instance.
+  * @param size The number of bytes written.
+ **/
+void checkpoint_mark_dirty(iopmp_dev_t *iopmp, const void *ptr, size_t size)
+{
+    checkpoint_track_t *track = &iopmp->checkpoint;
+    size_t offset = (const uint8_t *)ptr - (const uint8_t *)iopmp->storage.tables;
+    size_t first  = offset >> track->chunk_shift;
+    size_t last   = (offset + size - 1) >> track->chunk_shift;
+
+    if (!size)
+        return;
+
+    // Checks record violations concurrently
+    for (size_t c = first; c <= last; c++)
+        __atomic_fetch_or(&track->dirty[c / 64], 1ULL << (c % 64), __ATOMIC_RELAXED);
+}
+
+/**
+  * @brief Captures the whole state of an IOPMP instance.
+  *
+  * The checkpoint is allocated with the allocator of the instance. The
+  * instance is in sync with the checkpoint afterwards.
+  *
+  * @param iopmp The IOPMP instance.
+  * @return The checkpoint, or NULL if it can't be allocated.
+ **/
+iopmp_checkpoint_t *iopmp_checkpoint(iopmp_dev_t *iopmp)
+{
+    return checkpoint_capture(iopmp, true);
+}
+
+/**
+  * @brief Captures the whole state of an IOPMP instance.
+  *
+  * Without tracking, the writes to the tables of the instance keep being
+  * tracked against the checkpoint it was in sync with, so a snapshot taken
+  * for internal use doesn't change the cost of restoring the checkpoints of
+  * the caller.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param track The instance is in sync with the checkpoint afterwards.
+  * @return The checkpoint, or NULL if it can't be allocated.
+ **/
+iopmp_checkpoint_t *checkpoint_capture(iopmp_dev_t *iopmp, bool track)
+{
+    iopmp_allocator_t allocator = iopmp->storage.allocator;
+    iopmp_checkpoint_t *ckpt;
+    size_t size;
+
+    epoch_write_enter(iopmp);
+
+    size = TABLES_OFFSET + iopmp->storage.used;
+    ckpt = allocator.alloc(allocator.ctx, size, 64);
+    if (ckpt) {
+        ckpt->id          = __atomic_add_fetch(&checkpoint_next_id, 1, __ATOMIC_RELAXED);
+        ckpt->allocator   = allocator;
+        ckpt->size        = size;
+        ckpt->tables_size = iopmp->storage.used;
+        memcpy(ckpt->state, iopmp, STATE_SIZE);
+        memcpy((uint8_t *)ckpt + TABLES_OFFSET, iopmp->storage.tables, ckpt->tables_size);
+        if (track)
+            checkpoint_track(iopmp, ckpt->id);
+    }
+
+    epoch_write_exit(iopmp);
+    return ckpt;
+}
+
+/**
+  * @brief Restores the state of an IOPMP instance from a checkpoint.
+  *
+  * The checkpoint may come from another instance. Only the chunks of the
+  * tables written since the instance was last in sync with \p ckpt are
+  * copied; the whole tables are copied if it isn't in sync with \p ckpt.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param ckpt The checkpoint.
+  * @return 0 on success, -1 if the tables can't be allocated. The instance
+  *         is unchanged on failure.
+ **/
+int iopmp_restore(iopmp_dev_t *iopmp, const iopmp_checkpoint_t *ckpt)
+{
+    const uint8_t *tables = checkpoint_tables(ckpt);
+    checkpoint_track_t *track = &iopmp->checkpoint;
+    bool full;
+
+    epoch_write_enter(iopmp);
+
+    full = (track->synced != ckpt->id);
+
+    if (full && (iopmp_tables_grow(iopmp, ckpt->tables_size) < 0)) {
+        epoch_write_exit(iopmp);
+        return -1;
+    }
+
+    memcpy(iopmp, ckpt->state, STATE_SIZE);
+    iopmp_tables_relayout(iopmp);
+
+    if (full) {
+        memcpy(iopmp->storage.tables, tables, ckpt->tables_size);
+        checkpoint_track(iopmp, ckpt->id);
+    } else {
+        uint8_t *base = iopmp->storage.tables;
+        size_t chunk  = 1ULL << track->chunk_shift;
+
+        for (size_t w = 0; w < CHECKPOINT_CHUNKS / 64; w++) {
+            uint64_t bits = track->dirty[w];
+
+            while (bits) {
+                size_t offset = ((w * 64) + __builtin_ctzll(bits)) << track->chunk_shift;
+                size_t len    = (offset + chunk > ckpt->tables_size) ?
+                                (ckpt->tables_size - offset) : chunk;
+
+                memcpy(base + offset, tables + offset, len);
+                bits &= bits - 1;
+            }
+            track->dirty[w] = 0;
+        }
+    }
+
+    epoch_write_exit(iopmp);
+    return 0;
+}
+
+/**
+  * @brief Returns the size of a checkpoint.
+  *
+  * @param ckpt The checkpoint.
+  * @return The size (in bytes) of the checkpoint.
+ **/
+size_t iopmp_checkpoint_size(const iopmp_checkpoint_t *ckpt)
+{
+    return ckpt->size;
+}
+
+/**
+  * @brief Releases a checkpoint.
+  *
+  * @param ckpt The checkpoint, may be NULL.
+ **/
+void iopmp_checkpoint_free(iopmp_checkpoint_t *ckpt)
+{
+    if (ckpt && ckpt->allocator.free)
+        ckpt->allocator.free(ckpt->allocator.ctx, ckpt);
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Decision Cache
+// This file implements a direct-mapped cache of transaction decisions keyed
+// by (RRID, permission, AMO, address block). A decision is only cached when
+// no entry boundary falls inside its block, so every transaction within the
+// block gets the same decision, error type, entry index and suppression.
+//
+// Every write_register() which may change a decision starts a new
+// generation, which invalidates all cached decisions at once.
+//
+// Concurrent checks fill and read lines under a per-line sequence count, a
+// reader which sees the line change while copying it treats it as a miss.
+//
+// The main functions in this file include:
+// - decision_cache_reset: Empties the cache at reset.
+// - decision_cache_invalidate: Invalidates all cached decisions.
+// - decision_cache_fits: Checks if a transaction lies within one block.
+// - decision_cache_lookup: Looks up the decision of a transaction.
+// - decision_cache_insert: Caches the decision of a block.
+// - iopmp_get_decision_cache_stats: Reads the cache statistics.
+***************************************************************************/
+
+#include "iopmp.h"
+
+#if (DECISION_CACHE_EN == 1)
+
+/* Index of the cache line of a (RRID, permission, AMO, block) key */
+static inline uint32_t decision_cache_index(uint16_t rrid, uint8_t perm_key, uint64_t block)
+{
+    uint64_t h = (block * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)rrid << 2) ^ perm_key;
+
+    return (uint32_t)(h ^ (h >> 32)) & (DECISION_CACHE_SIZE - 1);
+}
+
+/**
+  * @brief Empties the decision cache.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void decision_cache_reset(iopmp_dev_t *iopmp)
+{
+    memset(&iopmp->decision_cache, 0, sizeof(iopmp->decision_cache));
+    // Lines with generation 0 are never valid
+    iopmp->decision_cache.gen = 1;
+}
+
+/**
+  * @brief Invalidates all cached decisions.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void decision_cache_invalidate(iopmp_dev_t *iopmp)
+{
+    iopmp->decision_cache.gen++;
+    if (iopmp->decision_cache.gen == 0) {
+        // The generation wrapped around, old lines may look valid again
+        memset(iopmp->decision_cache.lines, 0, sizeof(iopmp->decision_cache.lines));
+        iopmp->decision_cache.gen = 1;
+    }
+    iopmp->decision_cache.stats.invalidations++;
+}
+
+/**
+  * @brief Checks if a transaction lies within one address block.
+  *
+  * @param trans_start Start address of the transaction.
+  * @param trans_end End address of the transaction.
+  * @return true if the transaction can use the decision cache.
+ **/
+bool decision_cache_fits(uint64_t trans_start, uint64_t trans_end)
+{
+    // The last block is excluded since its end wraps around the address space
+    return (trans_start < trans_end) &&
+           ((trans_start | (DECISION_CACHE_BLOCK - 1)) != UINT64_MAX) &&
+           ((trans_start / DECISION_CACHE_BLOCK) == ((trans_end - 1) / DECISION_CACHE_BLOCK));
+}
+
+/**
+  * @brief Looks up the decision of a transaction.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param rrid Requester ID of the transaction.
+  * @param perm Type of permission requested.
+  * @param is_amo Indicates the AMO access.
+  * @param trans_start Start address of the transaction.
+  * @param trans_end End address of the transaction.
+  * @param d Output decision on a hit.
+  * @return true on a hit, otherwise false.
+ **/
+bool decision_cache_lookup(iopmp_dev_t *iopmp, uint16_t rrid, perm_type_e perm, bool is_amo,
+                           uint64_t trans_start, uint64_t trans_end, decision_t *d)
+{
+    decision_cache_line_t *line;
+    uint8_t perm_key = (perm << 1) | is_amo;
+    uint64_t block;
+    uint32_t seq;
+
+    if (!decision_cache_fits(trans_start, trans_end))
+        return false;
+
+    block = trans_start / DECISION_CACHE_BLOCK;
+    line  = &iopmp->decision_cache.lines[decision_cache_index(rrid, perm_key, block)];
+    seq   = __atomic_load_n(&line->seq, __ATOMIC_ACQUIRE);
+    if (!(seq & 1) &&
+        (line->gen == iopmp->decision_cache.gen) && (line->block == block) &&
+        (line->rrid == rrid) && (line->perm_key == perm_key)) {
+        *d = line->decision;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&line->seq, __ATOMIC_RELAXED) == seq) {
+            __atomic_fetch_add(&iopmp->decision_cache.stats.hits, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+
+    __atomic_fetch_add(&iopmp->decision_cache.stats.misses, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+/**
+  * @brief Caches the decision of an address block.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param rrid Requester ID of the transactions.
+  * @param perm Type of permission requested.
+  * @param is_amo Indicates the AMO access.
+  * @param block_start Start address of the block.
+  * @param d The decision of every transaction within the block.
+ **/
+void decision_cache_insert(iopmp_dev_t *iopmp, uint16_t rrid, perm_type_e perm, bool is_amo,
+                           uint64_t block_start, const decision_t *d)
+{
+    decision_cache_line_t *line;
+    uint8_t perm_key = (perm << 1) | is_amo;
+    uint64_t block = block_start / DECISION_CACHE_BLOCK;
+
+    uint32_t seq;
+
+    line = &iopmp->decision_cache.lines[decision_cache_index(rrid, perm_key, block)];
+    // Skip the fill if another check is filling the line
+    seq = __atomic_load_n(&line->seq, __ATOMIC_RELAXED);
+    if ((seq & 1) ||
+        !__atomic_compare_exchange_n(&line->seq, &seq, seq + 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+    line->block    = block;
+    line->gen      = iopmp->decision_cache.gen;
+    line->rrid     = rrid;
+    line->perm_key = perm_key;
+    line->decision = *d;
+    __atomic_store_n(&line->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+#endif
+
+/**
+  * @brief Reads the decision cache statistics.
+  *
+  * All counters read as 0 when the model is built without the decision cache.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param stats Output statistics.
+ **/
+void iopmp_get_decision_cache_stats(iopmp_dev_t *iopmp, iopmp_decision_cache_stats_t *stats)
+{
+#if (DECISION_CACHE_EN == 1)
+    *stats = iopmp->decision_cache.stats;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
@@ -0,0 +1,457 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Entry Advisor
+// A hardware IOPMP walks the entries of the MDs of a transaction in index
+// order until the first priority entry touching the transaction, or the
+// first non-priority entry granting it. The order of the non-priority entries
+// of an MD doesn't change the decision, but the deeper the granting entry,
+// the longer the walk. The entry advisor replays a trace of transactions on a
+// copy of an IOPMP instance and proposes a layout shortening the walk:
+// - The non-priority entries of each MD are sorted by the transactions they
+//   decide, per entry scanned. A TOR entry moves with the entry before it.
+// - With an MDCFG table, the non-priority OFF entries are moved out of the
+//   MDs, past the last MD, and MDCFG(m).t is lowered accordingly.
+// - With HWCFG2.prio_ent_prog, every lower HWCFG2.prio_entry is tried, the
+//   entries no longer priority being sorted too.
+// A layout is only proposed if the trace gets the same responses and
+// interrupts from it as from the current layout. The entries locked by
+// ENTRYLCK.f are never moved, and MDCFG(m).t is only proposed without
+// MDCFGLCK.f.
+//
+// The walk is estimated from the decoded entries, without the non-priority
+// entry index of the model. The proposed layout is emitted as an array of
+// struct iopmp_entry of libiopmp.
+//
+// The main functions in this file include:
+// - iopmp_advise_entries: Proposes an entry layout for a trace.
+// - iopmp_emit_entry_advice: Writes a proposed layout as C source.
+// - iopmp_entry_advice_free: Releases a proposed layout.
+***************************************************************************/
+
+#include <inttypes.h>
+#include "iopmp.h"
+
+// Entries moved together, an entry and the TOR entries after it
+typedef struct {
+    uint32_t first;                     // First entry of the group
+    uint32_t len;                       // Entries in the group
+    uint64_t hits;                      // Transactions decided by the group
+} entry_group_t;
+
+// Buffers of iopmp_advise_entries()
+typedef struct {
+    iopmp_dev_t *scratch;               // Copy of the instance the layouts are tried on
+    uint64_t *hits;                     // Transactions decided by each entry
+    uint32_t *order;                    // Layout being tried
+    uint32_t *spare;                    // Entries moved past the last MD
+    entry_group_t *groups;
+    entry_table_t *entries;             // Entry array of the current layout
+    iopmp_trans_rsp_t *rsps;            // Responses with the current layout
+    uint8_t *intrpts;                   // Interrupts with the current layout
+} advisor_t;
+
+/* Tells if an entry fully matching a transaction grants it, as iopmpCheckPerms() */
+static bool entry_grants(iopmp_dev_t *iopmp, const iopmp_trans_req_t *req, uint32_t md,
+                         entry_cfg_t cfg)
+{
+    uint8_t srcmd_r = GET_BIT(iopmp->md_cache.rrid_r_mds[req->rrid], md);
+    uint8_t srcmd_w = GET_BIT(iopmp->md_cache.rrid_w_mds[req->rrid], md);
+    uint8_t srcmd_x = GET_BIT(iopmp->md_cache.rrid_x_mds[req->rrid], md);
+    bool r = cfg.r, w = cfg.w, x = cfg.x;
+
+    if ((iopmp->reg_file.hwcfg3.srcmd_fmt == 0) && iopmp->reg_file.hwcfg2.sps_en) {
+        r = r && srcmd_r;
+        w = w && srcmd_w;
+        x = x && srcmd_x;
+    } else if (iopmp->reg_file.hwcfg3.srcmd_fmt == 2) {
+        r = r || srcmd_r;
+        w = w || srcmd_w;
+        x = x || srcmd_r;
+    }
+
+    switch (req->perm) {
+    case READ_ACCESS:
+        return r;
+    case WRITE_ACCESS:
+        return w && (r || !req->is_amo);
+    case INSTR_FETCH:
+        return iopmp->reg_file.hwcfg3.xinr ? r : x;
+    default:
+        return false;
+    }
+}
+
+/**
+  * @brief Counts the entries a hardware IOPMP walks to decide a trace.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param trace The transactions.
+  * @param n Number of transactions.
+  * @param hits Output transactions decided by each entry, or NULL.
+  * @return The entries walked by all transactions.
+ **/
+static uint64_t trace_scanned(iopmp_dev_t *iopmp, const iopmp_trans_req_t *trace, size_t n,
+                              uint64_t *hits)
+{
+    const md_cache_t *mc = &iopmp->md_cache;
+    const entry_cache_t *ec = &iopmp->entry_cache;
+    uint32_t prio_entry = iopmp->reg_file.hwcfg2.non_prio_en ?
+                          iopmp->reg_file.hwcfg2.prio_entry : UINT32_MAX;
+    uint64_t scanned = 0;
+
+    for (size_t t = 0; t < n; t++) {
+        const iopmp_trans_req_t *req = &trace[t];
+        uint64_t start = req->addr;
+        uint64_t end   = start + ((1ULL << req->size) * (req->length + 1));
+        uint64_t mds;
+        bool decided = false;
+
+        if (req->rrid >= iopmp->reg_file.hwcfg1.rrid_num)
+            continue;
+        mds = mc->rrid_mds[req->rrid] & mc->nonempty_mds;
+        for (; mds && !decided; mds &= (mds - 1)) {
+            uint32_t md = __builtin_ctzll(mds);
+
+            for (uint32_t i = mc->lwr_entry[md]; i < mc->upr_entry[md]; i++) {
+                bool touch = (ec->hi[i] >= ec->lo[i]) && (end > ec->lo[i]) && (start < ec->hi[i]);
+                bool full  = touch && (start >= ec->lo[i]) && (end <= ec->hi[i]);
+                entry_cfg_t cfg = { .raw = ec->cfg[i] };
+
+                scanned++;
+                if ((i < prio_entry) ? touch : (full && entry_grants(iopmp, req, md, cfg))) {
+                    if (hits)
+                        hits[i]++;
+                    decided = true;
+                    break;
+                }
+            }
+        }
+    }
+    return scanned;
+}
+
+/**
+  * @brief Replays a trace and checks it gets the responses of the current layout.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param adv Buffers of the advisor.
+  * @param trace The transactions.
+  * @param n Number of transactions.
+  * @param record Records the responses instead of checking them.
+  * @return true if every transaction gets the same response and interrupt.
+ **/
+static bool trace_replay(iopmp_dev_t *iopmp, advisor_t *adv, const iopmp_trans_req_t *trace,
+                         size_t n, bool record)
+{
+    for (size_t t = 0; t < n; t++) {
+        iopmp_trans_req_t req = trace[t];
+        iopmp_trans_rsp_t rsp;
+        uint8_t intrpt = 0;
+
+        memset(&rsp, 0, sizeof(rsp));
+        iopmp_validate_access(iopmp, &req, &rsp, &intrpt);
+        if (record) {
+            adv->rsps[t]    = rsp;
+            adv->intrpts[t] = intrpt;
+        } else if (memcmp(&rsp, &adv->rsps[t], sizeof(rsp)) || (intrpt != adv->intrpts[t])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Orders groups by decided transactions per entry, then by index */
+static int group_compare(const void *a, const void *b)
+{
+    const entry_group_t *ga = a, *gb = b;
+    uint64_t ka = ga->hits * gb->len, kb = gb->hits * ga->len;
+
+    if (ka != kb)
+        return (ka > kb) ? -1 : 1;
+    return (ga->first < gb->first) ? -1 : 1;
+}
+
+/**
+  * @brief Proposes an entry layout for a priority entry split.
+  *
+  * @param iopmp The IOPMP instance with the current layout.
+  * @param adv Buffers of the advisor, adv->order receives the layout.
+  * @param prio_entry The number of priority entries.
+  * @param mdcfg_t Output MDCFG(m).t of the layout.
+ **/
+static void layout_propose(iopmp_dev_t *iopmp, advisor_t *adv, uint32_t prio_entry,
+                           uint32_t *mdcfg_t)
+{
+    const md_cache_t *mc = &iopmp->md_cache;
+    const entry_table_t *entries = adv->entries;
+    uint32_t entry_num = iopmp->reg_file.hwcfg1.entry_num;
+    uint32_t md_num    = iopmp->reg_file.hwcfg0.md_num;
+    uint32_t fixed     = iopmp->reg_file.hwcfg2.non_prio_en ? prio_entry : entry_num;
+    bool compact       = (iopmp->reg_file.hwcfg3.mdcfg_fmt == 0) &&
+                         (iopmp->reg_file.mdcfglck.f == 0);
+    uint32_t out = 0, next = 0, num_spare = 0;
+
+    if (fixed < iopmp->reg_file.entrylck.f)
+        fixed = iopmp->reg_file.entrylck.f;
+
+    for (uint32_t m = 0; m < md_num; m++) {
+        uint32_t lwr = mc->lwr_entry[m], upr = mc->upr_entry[m];
+        uint32_t s = (lwr > fixed) ? lwr : ((fixed < upr) ? fixed : upr);
+        uint32_t num_groups = 0, sort_lwr, sort_upr;
+
+        // Entries before the MD, then the entries of the MD which stay
+        for (; next < s; next++)
+            adv->order[out++] = next;
+
+        for (uint32_t i = s; i < upr;) {
+            entry_group_t *g = &adv->groups[num_groups++];
+
+            g->first = i;
+            g->hits  = adv->hits[i];
+            for (i++; (i < upr) && (entries[i].entry_cfg.a == IOPMP_TOR); i++)
+                g->hits += adv->hits[i];
+            g->len = i - g->first;
+        }
+
+        // A TOR entry first in the MD keeps the entry before it, and the
+        // entry before a TOR entry past the MD stays last
+        sort_lwr = ((s < upr) && (entries[s].entry_cfg.a == IOPMP_TOR)) ? 1 : 0;
+        sort_upr = num_groups;
+        if ((sort_upr > sort_lwr) && (upr < entry_num) && (entries[upr].entry_cfg.a == IOPMP_TOR))
+            sort_upr--;
+        if (sort_upr > sort_lwr)
+            qsort(&adv->groups[sort_lwr], sort_upr - sort_lwr, sizeof(entry_group_t), group_compare);
+
+        for (uint32_t g = 0; g < num_groups; g++) {
+            const entry_group_t *grp = &adv->groups[g];
+
+            if (compact && (g >= sort_lwr) && (g < sort_upr) && (grp->len == 1) &&
+                (entries[grp->first].entry_cfg.a == IOPMP_OFF)) {
+                adv->spare[num_spare++] = grp->first;
+                continue;
+            }
+            for (uint32_t i = 0; i < grp->len; i++)
+                adv->order[out++] = grp->first + i;
+        }
+        if (upr > next)
+            next = upr;
+        mdcfg_t[m] = compact ? out : iopmp->reg_file.mdcfg[m].t;
+    }
+
+    // The OFF entries moved out of the MDs, then the entries past the MDs
+    for (uint32_t i = 0; i < num_spare; i++)
+        adv->order[out++] = adv->spare[i];
+    for (; next < entry_num; next++)
+        adv->order[out++] = next;
+}
+
+/**
+  * @brief Programs an entry layout.
+  *
+  * @param iopmp The IOPMP instance with the current layout.
+  * @param adv Buffers of the advisor, adv->order holds the layout.
+  * @param prio_entry The number of priority entries.
+  * @param mdcfg_t MDCFG(m).t of the layout.
+ **/
+static void layout_apply(iopmp_dev_t *iopmp, const advisor_t *adv, uint32_t prio_entry,
+                         const uint32_t *mdcfg_t)
+{
+    uint64_t base = iopmp->reg_file.entryoffset.offset;
+
+    iopmp_program_begin(iopmp);
+    for (uint32_t i = 0; i < iopmp->reg_file.hwcfg1.entry_num; i++) {
+        const entry_table_t *e = &adv->entries[adv->order[i]];
+        uint64_t offset = base + ((uint64_t)i * ENTRY_REG_STRIDE);
+
+        if (adv->order[i] == i)
+            continue;
+        write_register(iopmp, offset, e->entry_addr.addr, 4);
+        if (iopmp->reg_file.hwcfg0.addrh_en)
+            write_register(iopmp, offset + 4, e->entry_addrh.addrh, 4);
+        write_register(iopmp, offset + 8, e->entry_cfg.raw, 4);
+        write_register(iopmp, offset + 12, e->entry_user_cfg.raw, 4);
+    }
+    // MDCFG(m).t only decreases, the table stays proper after each write
+    if (iopmp->reg_file.hwcfg3.mdcfg_fmt == 0) {
+        for (uint32_t m = 0; m < iopmp->reg_file.hwcfg0.md_num; m++) {
+            if (iopmp->reg_file.mdcfg[m].t != mdcfg_t[m])
+                write_register(iopmp, MDCFG_TABLE_BASE_OFFSET + (m * 4), mdcfg_t[m], 4);
+        }
+    }
+    if (iopmp->reg_file.hwcfg2.prio_entry != prio_entry) {
+        hwcfg2_t hwcfg2 = iopmp->reg_file.hwcfg2;
+
+        hwcfg2.prio_entry    = prio_entry;
+        hwcfg2.prio_ent_prog = 0;
+        write_register(iopmp, HWCFG2_OFFSET, hwcfg2.raw, 4);
+    }
+    iopmp_program_commit(iopmp);
+}
+
+/* Releases the buffers of the advisor */
+static void advisor_free(const iopmp_allocator_t *allocator, advisor_t *adv)
+{
+    void *bufs[] = { adv->hits, adv->order, adv->spare, adv->groups, adv->entries,
+                     adv->rsps, adv->intrpts };
+
+    if (adv->scratch)
+        iopmp_destroy(adv->scratch);
+    for (size_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); i++) {
+        if (bufs[i] && allocator->free)
+            allocator->free(allocator->ctx, bufs[i]);
+    }
+}
+
+/**
+  * @brief Proposes an entry layout which shortens the entry walk of a trace.
+  *
+  * The trace is replayed on a copy of the instance, the instance itself is
+  * unchanged. The current layout is proposed if no layout shortens the walk
+  * and keeps the responses of the trace. Every lower HWCFG2.prio_entry
+  * costs a replay of the trace.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param trace The transactions.
+  * @param n Number of transactions.
+  * @param advice Output layout, released by iopmp_entry_advice_free().
+  * @return 0 on success, -1 if the buffers can't be allocated.
+ **/
+int iopmp_advise_entries(iopmp_dev_t *iopmp, const iopmp_trans_req_t *trace, size_t n,
+                         iopmp_entry_advice_t *advice)
+{
+    const iopmp_allocator_t *allocator = &iopmp->storage.allocator;
+    uint32_t entry_num = iopmp->reg_file.hwcfg1.entry_num;
+    uint32_t mdcfg_t[IOPMP_MAX_MD_NUM];
+    uint32_t prio_entry, lowest_prio;
+    iopmp_checkpoint_t *ckpt;
+    advisor_t adv = { 0 };
+    int ret = -1;
+
+    memset(advice, 0, sizeof(*advice));
+    advice->allocator = *allocator;
+
+    // The writes the caller tracks against its own checkpoint are kept
+    ckpt = checkpoint_capture(iopmp, false);
+    if (!ckpt)
+        return -1;
+
+    adv.scratch = allocator->alloc(allocator->ctx, sizeof(iopmp_dev_t), 64);
+    if (adv.scratch) {
+        memset(adv.scratch, 0, sizeof(iopmp_dev_t));
+        adv.scratch->storage.allocator = *allocator;
+        adv.scratch->storage.owned     = true;
+    }
+    adv.hits    = allocator->alloc(allocator->ctx, (entry_num + 1) * sizeof(uint64_t), 64);
+    adv.order   = allocator->alloc(allocator->ctx, (entry_num + 1) * sizeof(uint32_t), 64);
+    adv.spare   = allocator->alloc(allocator->ctx, (entry_num + 1) * sizeof(uint32_t), 64);
+    adv.groups  = allocator->alloc(allocator->ctx, (entry_num + 1) * sizeof(entry_group_t), 64);
+    adv.entries = allocator->alloc(allocator->ctx, (entry_num + 1) * sizeof(entry_table_t), 64);
+    adv.rsps    = allocator->alloc(allocator->ctx, (n + 1) * sizeof(iopmp_trans_rsp_t), 64);
+    adv.intrpts = allocator->alloc(allocator->ctx, n + 1, 64);
+    advice->order = allocator->alloc(allocator->ctx, (entry_num + 1) * sizeof(uint32_t), 64);
+    if (!adv.scratch || !adv.hits || !adv.order || !adv.spare || !adv.groups || !adv.entries ||
+        !adv.rsps || !adv.intrpts || !advice->order || (iopmp_restore(adv.scratch, ckpt) < 0))
+        goto out;
+
+    // The current layout, its entry walk and responses
+    memcpy(adv.entries, adv.scratch->iopmp_entries.entry_table, entry_num * sizeof(entry_table_t));
+    memset(adv.hits, 0, entry_num * sizeof(uint64_t));
+    advice->entry_num  = entry_num;
+    advice->prio_entry = prio_entry = adv.scratch->reg_file.hwcfg2.prio_entry;
+    advice->md_num     = (adv.scratch->reg_file.hwcfg3.mdcfg_fmt == 0) ?
+                         adv.scratch->reg_file.hwcfg0.md_num : 0;
+    for (uint32_t m = 0; m < advice->md_num; m++)
+        advice->mdcfg_t[m] = adv.scratch->reg_file.mdcfg[m].t;
+    for (uint32_t i = 0; i < entry_num; i++)
+        advice->order[i] = i;
+    advice->scanned = advice->scanned_advised = trace_scanned(adv.scratch, trace, n, adv.hits);
+    trace_replay(adv.scratch, &adv, trace, n, true);
+
+    // The spans of the MDs must be in entry order to move entries between them
+    ret = 0;
+    if (!adv.scratch->md_cache.spans_ordered)
+        goto out;
+
+    lowest_prio = (adv.scratch->reg_file.hwcfg2.non_prio_en &&
+                   adv.scratch->reg_file.hwcfg2.prio_ent_prog) ? 0 : prio_entry;
+    for (uint32_t p = prio_entry + 1; p-- > lowest_prio;) {
+        uint64_t scanned;
+
+        iopmp_restore(adv.scratch, ckpt);
+        layout_propose(adv.scratch, &adv, p, mdcfg_t);
+        layout_apply(adv.scratch, &adv, p, mdcfg_t);
+        scanned = trace_scanned(adv.scratch, trace, n, NULL);
+        if ((scanned >= advice->scanned_advised) || !trace_replay(adv.scratch, &adv, trace, n, false))
+            continue;
+
+        advice->scanned_advised = scanned;
+        advice->prio_entry      = p;
+        memcpy(advice->order, adv.order, entry_num * sizeof(uint32_t));
+        memcpy(advice->mdcfg_t, mdcfg_t, advice->md_num * sizeof(uint32_t));
+    }
+
+out:
+    advisor_free(allocator, &adv);
+    iopmp_checkpoint_free(ckpt);
+    if (ret < 0)
+        iopmp_entry_advice_free(advice);
+    return ret;
+}
+
+/**
+  * @brief Writes a proposed entry layout as an array of struct iopmp_entry.
+  *
+  * The array initializes the entry array of libiopmp in the proposed order,
+  * with the entries read from the instance. A comment before it gives the
+  * proposed HWCFG2.prio_entry and MDCFG table.
+  *
+  * @param iopmp The IOPMP instance the layout was proposed for.
+  * @param advice The proposed layout.
+  * @param file The output file.
+  * @param name Name of the array.
+  * @return 0 on success, -1 if the file can't be written.
+ **/
+int iopmp_emit_entry_advice(iopmp_dev_t *iopmp, const iopmp_entry_advice_t *advice,
+                            FILE *file, const char *name)
+{
+    bool non_prio_en = iopmp->reg_file.hwcfg2.non_prio_en;
+
+    if (fprintf(file, "/* HWCFG2.prio_entry = %u, entries scanned by the trace: %" PRIu64 " -> %" PRIu64 " */\n",
+                advice->prio_entry, advice->scanned, advice->scanned_advised) < 0)
+        return -1;
+    if (advice->md_num) {
+        fprintf(file, "/* MDCFG(0..%u).t =", advice->md_num - 1);
+        for (uint32_t m = 0; m < advice->md_num; m++)
+            fprintf(file, "%s %u", m ? "," : "", advice->mdcfg_t[m]);
+        fprintf(file, " */\n");
+    }
+
+    fprintf(file, "struct iopmp_entry %s[] = {\n", name);
+    for (uint32_t i = 0; i < advice->entry_num; i++) {
+        const entry_table_t *e = &iopmp->iopmp_entries.entry_table[advice->order[i]];
+        uint64_t addr = ((uint64_t)e->entry_addrh.addrh << 32) | e->entry_addr.addr;
+        bool prio = !non_prio_en || (i < advice->prio_entry);
+
+        fprintf(file, "    { .addr = 0x%" PRIx64 ", .cfg = 0x%x, .prient_flag = %s },\n",
+                addr, e->entry_cfg.raw, prio ? "IOPMP_PRIENT_PRIORITY" : "IOPMP_PRIENT_NON_PRIORITY");
+    }
+    if (fprintf(file, "};\n") < 0)
+        return -1;
+    return 0;
+}
+
+/**
+  * @brief Releases a proposed entry layout.
+  *
+  * @param advice The proposed layout.
+ **/
+void iopmp_entry_advice_free(iopmp_entry_advice_t *advice)
+{
+    if (advice->order && advice->allocator.free)
+        advice->allocator.free(advice->allocator.ctx, advice->order);
+    advice->order = NULL;
+}
@@ -0,0 +1,144 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Configuration Epoch
+// This file lets several threads check transactions on one IOPMP instance
+// while another thread programs its registers. Every check runs inside a
+// read section and sees a configuration which doesn't change until the
+// check completes. Every register write runs inside a write section, which
+// starts a new configuration epoch and waits until the checks started in
+// the previous epoch have drained before it modifies the configuration.
+//
+// A thread entering a read section only writes its own reader slot, so
+// checks from different threads don't contend on a shared cache line.
+// Register writes are expected to be rare compared to checks.
+//
+// The state a check updates (error capture record, MFR windows, stall
+// buffer counter and decision cache) is updated with atomic operations.
+//
+// The main functions in this file include:
+// - epoch_read_enter: Enters a read section.
+// - epoch_read_exit: Exits a read section.
+// - epoch_write_enter: Enters a write section.
+// - epoch_write_exit: Exits a write section.
+// - epoch_lock: Serializes register reads with register writes.
+// - epoch_unlock: Releases epoch_lock().
+***************************************************************************/
+
+#include <sched.h>
+#include "iopmp.h"
+
+#if (CONCURRENT_CHECK_EN == 1)
+
+// Reader slot of the calling thread
+static __thread int epoch_slot = -1;
+// Next reader slot to hand out
+static uint32_t epoch_next_slot;
+
+/* Returns the reader slot of the calling thread */
+static inline epoch_slot_t *epoch_reader(iopmp_dev_t *iopmp)
+{
+    if (epoch_slot < 0) {
+        // Threads share a slot when there are more threads than slots, the
+        // slot counts nested read sections so this is still correct
+        epoch_slot = __atomic_fetch_add(&epoch_next_slot, 1, __ATOMIC_RELAXED) % EPOCH_READER_SLOTS;
+    }
+    return &iopmp->epoch.readers[epoch_slot];
+}
+
+/**
+  * @brief Enters a read section, in which the configuration doesn't change.
+  *
+  * A thread must not write registers inside a read section.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void epoch_read_enter(iopmp_dev_t *iopmp)
+{
+    epoch_slot_t *slot = epoch_reader(iopmp);
+
+    for (;;) {
+        __atomic_add_fetch(&slot->active, 1, __ATOMIC_SEQ_CST);
+        // An even epoch means no write section is in progress
+        if (!(__atomic_load_n(&iopmp->epoch.epoch, __ATOMIC_SEQ_CST) & 1))
+            return;
+        // Back off until the write section completes
+        __atomic_sub_fetch(&slot->active, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&iopmp->epoch.epoch, __ATOMIC_ACQUIRE) & 1)
+            sched_yield();
+    }
+}
+
+/**
+  * @brief Exits a read section.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void epoch_read_exit(iopmp_dev_t *iopmp)
+{
+    __atomic_sub_fetch(&epoch_reader(iopmp)->active, 1, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief Serializes register reads with register writes.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void epoch_lock(iopmp_dev_t *iopmp)
+{
+    while (__atomic_test_and_set(&iopmp->epoch.write_lock, __ATOMIC_ACQUIRE))
+        sched_yield();
+}
+
+/**
+  * @brief Releases epoch_lock().
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void epoch_unlock(iopmp_dev_t *iopmp)
+{
+    __atomic_clear(&iopmp->epoch.write_lock, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief Enters a write section, in which no check is in progress.
+  *
+  * It starts a new epoch and waits for the checks of the previous epoch.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void epoch_write_enter(iopmp_dev_t *iopmp)
+{
+    epoch_lock(iopmp);
+    // Odd epoch, new checks wait until epoch_write_exit()
+    __atomic_add_fetch(&iopmp->epoch.epoch, 1, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < EPOCH_READER_SLOTS; i++) {
+        while (__atomic_load_n(&iopmp->epoch.readers[i].active, __ATOMIC_ACQUIRE))
+            sched_yield();
+    }
+}
+
+/**
+  * @brief Exits a write section and publishes the new configuration.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void epoch_write_exit(iopmp_dev_t *iopmp)
+{
+    __atomic_add_fetch(&iopmp->epoch.epoch, 1, __ATOMIC_RELEASE);
+    epoch_unlock(iopmp);
+}
+
+#else
+
+void epoch_read_enter(iopmp_dev_t *iopmp) {}
+void epoch_read_exit(iopmp_dev_t *iopmp) {}
+void epoch_lock(iopmp_dev_t *iopmp) {}
+void epoch_unlock(iopmp_dev_t *iopmp) {}
+void epoch_write_enter(iopmp_dev_t *iopmp) {}
+void epoch_write_exit(iopmp_dev_t *iopmp) {}
+
+#endif
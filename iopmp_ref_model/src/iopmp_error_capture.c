@@ -14,7 +14,12 @@
 // stores details such as transaction type, error type, request ID, entry ID,
 // and the address where the error occurred. Additionally, the function
 // detects and flags subsequent violations and can trigger an interrupt if
-// necessary.
+// necessary. The record is updated atomically since several threads may
+// capture errors at the same time.
+//
+// The windows of subsequent violations are summarized by a two-level bitmap,
+// so reads of ERR_MFR find the next window holding a violation without
+// scanning the empty ones.
 ***************************************************************************/
 
 #include "iopmp.h"
@@ -26,7 +31,115 @@
   * @param rrid Resource Record ID (RRID) whose corresponding bit needs to be set in the SV structure.
   */
 static void setRridSv(iopmp_dev_t *iopmp, uint16_t rrid) {
-    iopmp->err_svs.sv[rrid/16].svw |= (1 << (rrid % 16));
+    err_mfrs_t *svs = &iopmp->err_svs;
+    uint32_t w = rrid / 16;
+    uint64_t bit = 1ULL << (w % 64);
+    err_mfr_t sv = { .raw = 0 };
+
+    sv.svw = 1 << (rrid % 16);
+    __atomic_fetch_or(&svs->sv[w].raw, sv.raw, __ATOMIC_SEQ_CST);
+    CHECKPOINT_DIRTY(iopmp, svs->sv, w, 1);
+
+    // Mark the window in the summary bitmap, from the bottom level up. The
+    // bits are only written if they are clear, so a storm of violations
+    // doesn't bounce the summary between the capturing threads.
+    if (!(__atomic_load_n(&svs->summary[w / 64], __ATOMIC_SEQ_CST) & bit)) {
+        __atomic_fetch_or(&svs->summary[w / 64], bit, __ATOMIC_SEQ_CST);
+        CHECKPOINT_DIRTY(iopmp, svs->summary, w / 64, 1);
+    }
+    if (!(__atomic_load_n(&svs->top, __ATOMIC_SEQ_CST) & (1ULL << (w / 64))))
+        __atomic_fetch_or(&svs->top, 1ULL << (w / 64), __ATOMIC_SEQ_CST);
+}
+
+/**
+  * @brief Clears the summary bits of a window which was taken.
+  *
+  * A summary bit is set again if a concurrent capture records a violation
+  * meanwhile, so every window holding a violation stays marked.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param w Index of the window.
+  */
+static void sv_summary_clear(iopmp_dev_t *iopmp, uint32_t w)
+{
+    err_mfrs_t *svs = &iopmp->err_svs;
+    uint64_t *word = &svs->summary[w / 64];
+    uint64_t bit = 1ULL << (w % 64);
+
+    __atomic_fetch_and(word, ~bit, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&svs->sv[w].raw, __ATOMIC_SEQ_CST))
+        __atomic_fetch_or(word, bit, __ATOMIC_SEQ_CST);
+    CHECKPOINT_DIRTY(iopmp, svs->summary, w / 64, 1);
+    if (__atomic_load_n(word, __ATOMIC_SEQ_CST))
+        return;
+
+    __atomic_fetch_and(&svs->top, ~(1ULL << (w / 64)), __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(word, __ATOMIC_SEQ_CST))
+        __atomic_fetch_or(&svs->top, 1ULL << (w / 64), __ATOMIC_SEQ_CST);
+}
+
+/**
+  * @brief Finds the first window marked in the summary bitmap in [from, to).
+  *
+  * @param svs The windows of subsequent violations.
+  * @return The index of the window, or -1 if there is none.
+  */
+static int sv_window_find(const err_mfrs_t *svs, uint32_t from, uint32_t to)
+{
+    while (from < to) {
+        uint32_t j = from / 64;
+        uint64_t bits = __atomic_load_n(&svs->summary[j], __ATOMIC_SEQ_CST) &
+                        (UINT64_MAX << (from % 64));
+        uint64_t top;
+
+        if (bits) {
+            uint32_t w = (j * 64) + __builtin_ctzll(bits);
+            return (w < to) ? (int)w : -1;
+        }
+        // Skip the summary words without any marked window
+        top = (j < 63) ? (__atomic_load_n(&svs->top, __ATOMIC_SEQ_CST) & (UINT64_MAX << (j + 1))) : 0;
+        if (!top)
+            return -1;
+        from = __builtin_ctzll(top) * 64;
+    }
+    return -1;
+}
+
+/**
+  * @brief Takes the next window holding a subsequent violation.
+  *
+  * The windows are searched from \p start, wrapping around, and the window
+  * found is cleared. It is called by reads of ERR_MFR.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param start Index of the first window to search.
+  * @param svw Output subsequent violations of the window.
+  * @return The index of the window, or -1 if no window holds a violation.
+  */
+int sv_window_take(iopmp_dev_t *iopmp, uint32_t start, uint16_t *svw)
+{
+    err_mfrs_t *svs = &iopmp->err_svs;
+
+    start %= svs->num;
+    for (;;) {
+        int w = sv_window_find(svs, start, svs->num);
+        err_mfr_t sv;
+
+        if (w < 0)
+            w = sv_window_find(svs, 0, start);
+        if (w < 0)
+            return -1;
+
+        // Take the window and clear it at once, concurrent checks may record
+        // new violations in it
+        sv.raw = __atomic_exchange_n(&svs->sv[w].raw, 0, __ATOMIC_SEQ_CST);
+        CHECKPOINT_DIRTY(iopmp, svs->sv, w, 1);
+        sv_summary_clear(iopmp, w);
+        if (sv.svw) {
+            *svw = sv.svw;
+            return w;
+        }
+    }
 }
 
 /**
@@ -56,49 +169,72 @@ void errorCapture(iopmp_dev_t *iopmp, perm_type_e trans_type, uint8_t error_type
                   uint16_t rrid, uint16_t entry_id, uint64_t err_addr,
                   bool gen_intrpt, bool gen_buserr, uint8_t *intrpt) {
 
-    // Current value of ERR_INFO.v
-    int err_reqinfo_v = iopmp->reg_file.err_info.v;
-
-    // First error capture occurs when the following conditions are true:
-    //   - An interrupt is triggered, or a bus error is returned
-    //   - There is no pending error capture, that is, current ERR_INFO.v = '0'
-    bool first_record = (gen_intrpt || gen_buserr) && !err_reqinfo_v;
-
-    if (first_record) {
-        iopmp->reg_file.err_info.v = 1;               // Mark error as captured
-        // Set error status and transaction details
-        iopmp->reg_file.err_info.ttype = trans_type;  // Transaction type (read/write)
-        iopmp->reg_file.err_info.etype = error_type;  // Specific error type
-
-        // Capture lower and upper parts of error address
-        iopmp->reg_file.err_reqaddr.addr   = (uint32_t)((err_addr >> 2) & UINT32_MAX);         // Error address [33:2]
-        iopmp->reg_file.err_reqaddrh.addrh = (uint32_t)((err_addr >> 34) & UINT32_MAX);        // Error address [65:34]
-
-        // Record Request ID and Entry ID details
-        iopmp->reg_file.err_reqid.rrid = rrid;
-        if (iopmp->imp_err_reqid_eid) {
-            // One can implement the error capture record, but doesn't implement
-            // the error entry index record (ERR_REQID.eid).
-            // If IOPMP doesn't implement ERR_REQID.eid it won't be updated.
-            iopmp->reg_file.err_reqid.eid = entry_id;
-        }
+    uint32_t *err_info_word = REG_WORD(iopmp, ERR_INFO_OFFSET);
+    err_info_t err_info, err_info_new;
+    err_reqid_t err_reqid;
+    uint32_t claim = 0;
+
+    // An error is captured only when an interrupt is triggered, or a bus
+    // error is returned
+    if (!gen_intrpt && !gen_buserr)
+        return;
 
-        generate_interrupt(iopmp, gen_intrpt, intrpt);
+    // First error capture occurs when there is no pending error capture, that
+    // is, current ERR_INFO.v = '0'. Only one of the concurrent captures claims
+    // the record. It fills the record before ERR_INFO.v is set, so a reader
+    // seeing ERR_INFO.v = '1' sees the whole record. ERR_INFO.v is set before
+    // the claim is dropped, so a later claim finds it set.
+    err_info.raw = __atomic_load_n(err_info_word, __ATOMIC_ACQUIRE);
+    if (!err_info.v &&
+        __atomic_compare_exchange_n(&iopmp->err_rec_claim, &claim, 1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        err_info.raw = __atomic_load_n(err_info_word, __ATOMIC_ACQUIRE);
+        if (!err_info.v) {
+            // Capture lower and upper parts of error address
+            __atomic_store_n(REG_WORD(iopmp, ERR_REQADDR_OFFSET),
+                             (uint32_t)((err_addr >> 2) & UINT32_MAX), __ATOMIC_RELAXED);   // Error address [33:2]
+            __atomic_store_n(REG_WORD(iopmp, ERR_REQADDRH_OFFSET),
+                             (uint32_t)((err_addr >> 34) & UINT32_MAX), __ATOMIC_RELAXED);  // Error address [65:34]
+
+            // Record Request ID and Entry ID details
+            err_reqid.raw  = iopmp->reg_file.err_reqid.raw;
+            err_reqid.rrid = rrid;
+            if (iopmp->imp_err_reqid_eid) {
+                // One can implement the error capture record, but doesn't implement
+                // the error entry index record (ERR_REQID.eid).
+                // If IOPMP doesn't implement ERR_REQID.eid it won't be updated.
+                err_reqid.eid = entry_id;
+            }
+            __atomic_store_n(REG_WORD(iopmp, ERR_REQID_OFFSET), err_reqid.raw, __ATOMIC_RELAXED);
+
+            // Publish the record. ERR_INFO.svc and ERR_INFO.msi_werr may be
+            // updated concurrently.
+            do {
+                err_info_new       = err_info;
+                err_info_new.v     = 1;                   // Mark error as captured
+                // Set error status and transaction details
+                err_info_new.ttype = trans_type;          // Transaction type (read/write)
+                err_info_new.etype = error_type;          // Specific error type
+            } while (!__atomic_compare_exchange_n(err_info_word, &err_info.raw, err_info_new.raw,
+                                                  true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            __atomic_store_n(&iopmp->err_rec_claim, 0, __ATOMIC_RELEASE);
+
+            generate_interrupt(iopmp, gen_intrpt, intrpt);
+            return;
+        }
+        __atomic_store_n(&iopmp->err_rec_claim, 0, __ATOMIC_RELEASE);
     }
 
-    // If IOPMP implements Multi-Faults Record extension, IOPMP has ability to
-    // record subsequent violations when the primary error capture registers
-    // recorded last violation and software have not invalidated them yet.
+    // Otherwise the record is pending, or being filled by a concurrent
+    // capture. If IOPMP implements Multi-Faults Record extension, IOPMP has
+    // ability to record subsequent violations when the primary error capture
+    // registers recorded last violation and software have not invalidated
+    // them yet.
     if (iopmp->reg_file.hwcfg2.mfr_en) {
-        // Subsequent error capture occurs when the following conditions are true:
-        //   - An interrupt is triggered or a bus error is returned
-        //   - There is a pending error capture, that is, current ERR_INFO.v = '1'
-        bool subsq_record = (gen_intrpt || gen_buserr) && err_reqinfo_v;
-
-        if (subsq_record) {
-            // Update violation window
-            setRridSv(iopmp, rrid);
-            iopmp->reg_file.err_info.svc = 1;
-        }
+        // Update violation window before ERR_INFO.svc, see read_register()
+        setRridSv(iopmp, rrid);
+        err_info_new.raw = 0;
+        err_info_new.svc = 1;
+        __atomic_fetch_or(err_info_word, err_info_new.raw, __ATOMIC_RELEASE);
     }
 }
@@ -0,0 +1,402 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Fabric
+// A fabric checks transactions with several IOPMP instances in parallel,
+// each of them owning a set of RRIDs or a range of addresses. It lets a
+// system have more requesters than one IOPMP implements, and spreads the
+// checks over several threads.
+//
+// Every transaction is routed by its RRID and address to the first
+// matching route, and checked by the instance of the route with an RRID
+// local to the instance. In a threaded fabric, every instance has a worker
+// thread fed by a single-producer single-consumer ring of requests. The
+// worker writes the responses in place and publishes how many requests it
+// completed. Every instance sees its requests in batch order and the
+// responses are merged by request index, so the results don't depend on
+// the scheduling of the threads and match an unthreaded fabric. A thread
+// waiting for the other side polls for a bounded time, then blocks on a
+// futex, so an idle fabric doesn't keep a core busy.
+//
+// The main functions in this file include:
+// - iopmp_fabric_create: Creates a fabric over IOPMP instances.
+// - iopmp_fabric_destroy: Stops the worker threads and releases a fabric.
+// - iopmp_fabric_validate_batch: Checks a batch of requests.
+***************************************************************************/
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "iopmp.h"
+
+// Requests a worker checks at once
+#define FABRIC_CHUNK        64
+// A ring entry is the request index above the local RRID
+#define RING_ENTRY(idx, rrid)   (((uint64_t)(idx) << 16) | (rrid))
+#define RING_IDX(entry)         ((entry) >> 16)
+#define RING_RRID(entry)        ((uint16_t)(entry))
+// Polls of a waiting thread before it blocks
+#define FABRIC_SPIN         256
+
+// Event a thread blocks on, see fabric_wait()
+typedef struct {
+    uint32_t seq;                   // Bumped by every wake-up
+    uint32_t waiters;               // Threads blocked, or about to block
+} fabric_event_t;
+
+// Worker thread of an instance
+typedef struct {
+    struct iopmp_fabric_t *fabric;
+    iopmp_dev_t *iopmp;
+    pthread_t thread;
+    uint64_t head __attribute__((aligned(64)));     // Next entry the worker reads
+    uint64_t tail __attribute__((aligned(64)));     // Next entry the caller writes
+    uint64_t done __attribute__((aligned(64)));     // Requests completed
+    fabric_event_t work __attribute__((aligned(64)));   // Requests queued or stop, wakes the worker
+    fabric_event_t progress;                        // Requests gathered or completed, wakes the caller
+    uint64_t submitted;                             // Requests queued, caller only
+    bool started;                                   // The thread is running
+    bool stop;                                      // The fabric is destroyed
+    uint64_t ring[FABRIC_QUEUE_DEPTH];
+} fabric_worker_t;
+
+struct iopmp_fabric_t {
+    iopmp_dev_t **instances;
+    size_t num_instances;
+    iopmp_fabric_route_t *routes;
+    size_t num_routes;
+    fabric_worker_t *workers;               // One per instance, NULL if unthreaded
+    // Batch in progress, published to the workers by the ring tails
+    const iopmp_trans_req_batch_t *reqs;
+    iopmp_trans_rsp_t *rsps;
+    uint8_t *intrpts;
+};
+
+/* Returns the route of a request, or NULL if no route matches it */
+static const iopmp_fabric_route_t *fabric_route(const iopmp_fabric_t *fabric,
+                                                uint16_t rrid, uint64_t addr)
+{
+    for (size_t r = 0; r < fabric->num_routes; r++) {
+        const iopmp_fabric_route_t *route = &fabric->routes[r];
+
+        if ((rrid >= route->rrid_lo) && (rrid < route->rrid_hi) &&
+            (addr >= route->addr_lo) && (addr < route->addr_hi))
+            return route;
+    }
+    return NULL;
+}
+
+/**
+  * @brief Waits until a condition of a worker holds.
+  *
+  * The condition is polled FABRIC_SPIN times, then the thread blocks on the
+  * event until fabric_wake() is called after the condition changed.
+  *
+  * @param ev The event signaled when the condition changes.
+  * @param ready The condition.
+  * @param w The worker.
+ **/
+static void fabric_wait(fabric_event_t *ev, bool (*ready)(fabric_worker_t *), fabric_worker_t *w)
+{
+    for (int i = 0; i < FABRIC_SPIN; i++) {
+        if (ready(w))
+            return;
+        sched_yield();
+    }
+
+    while (!ready(w)) {
+        uint32_t seq = __atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE);
+
+        // Either the waker sees the waiter, or the waiter sees the new
+        // condition. A wake-up between the check and the futex call bumps
+        // seq, so the futex returns at once.
+        __atomic_add_fetch(&ev->waiters, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!ready(w))
+            syscall(SYS_futex, &ev->seq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+        __atomic_sub_fetch(&ev->waiters, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+  * @brief Wakes the threads blocked on an event, after the condition changed.
+  *
+  * @param ev The event.
+ **/
+static void fabric_wake(fabric_event_t *ev)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ev->waiters, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&ev->seq, 1, __ATOMIC_RELEASE);
+        syscall(SYS_futex, &ev->seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+/* The worker has requests queued, or is stopped */
+static bool fabric_has_work(fabric_worker_t *w)
+{
+    return (__atomic_load_n(&w->tail, __ATOMIC_ACQUIRE) != w->head) ||
+           __atomic_load_n(&w->stop, __ATOMIC_ACQUIRE);
+}
+
+/* The ring of the worker has a free slot, called by the caller */
+static bool fabric_has_space(fabric_worker_t *w)
+{
+    return (w->tail - __atomic_load_n(&w->head, __ATOMIC_ACQUIRE)) != FABRIC_QUEUE_DEPTH;
+}
+
+/* The worker completed all requests queued, called by the caller */
+static bool fabric_is_done(fabric_worker_t *w)
+{
+    return __atomic_load_n(&w->done, __ATOMIC_ACQUIRE) == w->submitted;
+}
+
+static void *fabric_worker(void *arg)
+{
+    fabric_worker_t *w = arg;
+    iopmp_fabric_t *fabric = w->fabric;
+    uint64_t addr[FABRIC_CHUNK]   __attribute__((aligned(64)));
+    uint32_t length[FABRIC_CHUNK] __attribute__((aligned(64)));
+    uint32_t size[FABRIC_CHUNK]   __attribute__((aligned(64)));
+    uint16_t rrid[FABRIC_CHUNK]   __attribute__((aligned(64)));
+    uint8_t  perm[FABRIC_CHUNK]   __attribute__((aligned(64)));
+    bool     is_amo[FABRIC_CHUNK] __attribute__((aligned(64)));
+    size_t   req_idx[FABRIC_CHUNK];
+    iopmp_trans_rsp_t chunk_rsps[FABRIC_CHUNK];
+    uint8_t chunk_intrpts[FABRIC_CHUNK];
+    iopmp_trans_req_batch_t chunk = { addr, length, size, rrid, perm, is_amo };
+
+    for (;;) {
+        uint64_t head = w->head;
+        uint64_t tail = __atomic_load_n(&w->tail, __ATOMIC_ACQUIRE);
+        const iopmp_trans_req_batch_t *reqs;
+        size_t cnt;
+
+        if (head == tail) {
+            if (__atomic_load_n(&w->stop, __ATOMIC_ACQUIRE))
+                return NULL;
+            fabric_wait(&w->work, fabric_has_work, w);
+            continue;
+        }
+
+        cnt  = ((tail - head) < FABRIC_CHUNK) ? (tail - head) : FABRIC_CHUNK;
+        reqs = fabric->reqs;
+        for (size_t k = 0; k < cnt; k++) {
+            uint64_t entry = w->ring[(head + k) % FABRIC_QUEUE_DEPTH];
+            size_t i = RING_IDX(entry);
+
+            req_idx[k] = i;
+            addr[k]    = reqs->addr[i];
+            length[k]  = reqs->length[i];
+            size[k]    = reqs->size[i];
+            rrid[k]    = RING_RRID(entry);
+            perm[k]    = reqs->perm[i];
+            is_amo[k]  = reqs->is_amo[i];
+        }
+        // The ring slots can be reused once the requests are gathered
+        __atomic_store_n(&w->head, head + cnt, __ATOMIC_RELEASE);
+        fabric_wake(&w->progress);
+
+        // The batch check sets the interrupt flag of every request
+        memset(chunk_rsps, 0, cnt * sizeof(chunk_rsps[0]));
+        iopmp_validate_access_batch(w->iopmp, &chunk, chunk_rsps, chunk_intrpts, cnt);
+        for (size_t k = 0; k < cnt; k++) {
+            // Report the global RRID of the request
+            chunk_rsps[k].rrid = reqs->rrid[req_idx[k]];
+            fabric->rsps[req_idx[k]]    = chunk_rsps[k];
+            fabric->intrpts[req_idx[k]] = chunk_intrpts[k];
+        }
+        __atomic_add_fetch(&w->done, cnt, __ATOMIC_RELEASE);
+        fabric_wake(&w->progress);
+    }
+}
+
+/* Queues request i with its local RRID to a worker */
+static void fabric_submit(fabric_worker_t *w, size_t i, uint16_t local_rrid)
+{
+    uint64_t tail = w->tail;
+
+    // Wait for a free slot if the worker falls behind
+    fabric_wait(&w->progress, fabric_has_space, w);
+
+    w->ring[tail % FABRIC_QUEUE_DEPTH] = RING_ENTRY(i, local_rrid);
+    __atomic_store_n(&w->tail, tail + 1, __ATOMIC_RELEASE);
+    w->submitted++;
+    fabric_wake(&w->work);
+}
+
+/**
+  * @brief Releases a fabric, after stopping its worker threads.
+  *
+  * The instances aren't released.
+  *
+  * @param fabric The fabric, may be NULL.
+ **/
+void iopmp_fabric_destroy(iopmp_fabric_t *fabric)
+{
+    if (!fabric)
+        return;
+
+    if (fabric->workers) {
+        for (size_t s = 0; s < fabric->num_instances; s++) {
+            fabric_worker_t *w = &fabric->workers[s];
+
+            if (!w->started)
+                continue;
+            __atomic_store_n(&w->stop, true, __ATOMIC_RELEASE);
+            fabric_wake(&w->work);
+            pthread_join(w->thread, NULL);
+        }
+        free(fabric->workers);
+    }
+    free(fabric->routes);
+    free(fabric->instances);
+    free(fabric);
+}
+
+/**
+  * @brief Creates a fabric checking transactions with several IOPMP instances.
+  *
+  * In a threaded fabric, every instance is checked by its own worker thread,
+  * and the instances must be distinct. Registers may still be written while
+  * a batch is checked if CONCURRENT_CHECK_EN is 1.
+  *
+  * @param instances The IOPMP instances.
+  * @param num_instances Number of instances.
+  * @param routes The routes, the first route matching a transaction is used.
+  * @param num_routes Number of routes.
+  * @param threaded Check every instance on a worker thread.
+  * @return The fabric, or NULL if a route is invalid, an instance is listed
+  *         twice in a threaded fabric, or on allocation failure.
+ **/
+iopmp_fabric_t *iopmp_fabric_create(iopmp_dev_t **instances, size_t num_instances,
+                                    const iopmp_fabric_route_t *routes, size_t num_routes,
+                                    bool threaded)
+{
+    iopmp_fabric_t *fabric;
+
+    for (size_t r = 0; r < num_routes; r++) {
+        if ((routes[r].instance >= num_instances) || (routes[r].rrid_base > routes[r].rrid_lo))
+            return NULL;
+    }
+    // Two workers must not check the same instance
+    for (size_t s = 0; threaded && (s < num_instances); s++) {
+        for (size_t t = s + 1; t < num_instances; t++) {
+            if (instances[s] == instances[t])
+                return NULL;
+        }
+    }
+
+    fabric = calloc(1, sizeof(*fabric));
+    if (!fabric)
+        return NULL;
+    fabric->num_instances = num_instances;
+    fabric->num_routes    = num_routes;
+    fabric->instances     = malloc((num_instances ? num_instances : 1) * sizeof(*instances));
+    fabric->routes        = malloc((num_routes ? num_routes : 1) * sizeof(*routes));
+    if (!fabric->instances || !fabric->routes) {
+        iopmp_fabric_destroy(fabric);
+        return NULL;
+    }
+    memcpy(fabric->instances, instances, num_instances * sizeof(*instances));
+    memcpy(fabric->routes, routes, num_routes * sizeof(*routes));
+
+    if (threaded && num_instances) {
+        fabric->workers = aligned_alloc(64, ALIGNUP(num_instances * sizeof(fabric_worker_t), 64));
+        if (!fabric->workers) {
+            iopmp_fabric_destroy(fabric);
+            return NULL;
+        }
+        memset(fabric->workers, 0, num_instances * sizeof(fabric_worker_t));
+        for (size_t s = 0; s < num_instances; s++) {
+            fabric_worker_t *w = &fabric->workers[s];
+
+            w->fabric = fabric;
+            w->iopmp  = instances[s];
+            if (pthread_create(&w->thread, NULL, fabric_worker, w) != 0) {
+                iopmp_fabric_destroy(fabric);
+                return NULL;
+            }
+            w->started = true;
+        }
+    }
+    return fabric;
+}
+
+/**
+  * @brief Checks a batch of transaction requests with the instances of a fabric.
+  *
+  * Every instance checks its requests in batch order, so the results,
+  * including the error capture and stall state of each instance, are the
+  * same for a threaded and an unthreaded fabric. Requests without a route
+  * fail, and no instance records them.
+  *
+  * @param fabric The fabric.
+  * @param reqs The transaction requests in structure-of-arrays layout.
+  * @param rsps Array of n responses. rsps[i].rrid is the RRID of request i,
+  *             and an untranslated rsps[i].rrid_transl is local to the
+  *             instance.
+  * @param intrpts Array of n wired interrupt flags, see iopmp_validate_access().
+  * @param routed_to Array of n indexes of the instance which checked each
+  *                  request, -1 if none, or NULL.
+  * @param n Number of requests in the batch.
+ **/
+void iopmp_fabric_validate_batch(iopmp_fabric_t *fabric, const iopmp_trans_req_batch_t *reqs,
+                                 iopmp_trans_rsp_t *rsps, uint8_t *intrpts,
+                                 int32_t *routed_to, size_t n)
+{
+    fabric->reqs    = reqs;
+    fabric->rsps    = rsps;
+    fabric->intrpts = intrpts;
+
+    for (size_t i = 0; i < n; i++) {
+        const iopmp_fabric_route_t *route = fabric_route(fabric, reqs->rrid[i], reqs->addr[i]);
+        uint16_t local_rrid;
+
+        if (routed_to)
+            routed_to[i] = route ? (int32_t)route->instance : -1;
+
+        if (!route) {
+            memset(&rsps[i], 0, sizeof(rsps[i]));
+            rsps[i].rrid        = reqs->rrid[i];
+            rsps[i].rrid_transl = reqs->rrid[i];
+            rsps[i].status      = IOPMP_ERROR;
+            intrpts[i]          = 0;
+            continue;
+        }
+
+        local_rrid = reqs->rrid[i] - route->rrid_base;
+        if (fabric->workers) {
+            fabric_submit(&fabric->workers[route->instance], i, local_rrid);
+        } else {
+            iopmp_trans_req_t trans_req = {
+                .rrid   = local_rrid,
+                .addr   = reqs->addr[i],
+                .length = reqs->length[i],
+                .size   = reqs->size[i],
+                .perm   = (perm_type_e)reqs->perm[i],
+                .is_amo = reqs->is_amo[i],
+            };
+
+            memset(&rsps[i], 0, sizeof(rsps[i]));
+            intrpts[i] = 0;
+            iopmp_validate_access(fabric->instances[route->instance], &trans_req, &rsps[i], &intrpts[i]);
+            rsps[i].rrid = reqs->rrid[i];
+        }
+    }
+
+    // Wait for the workers to complete the batch
+    if (fabric->workers) {
+        for (size_t s = 0; s < fabric->num_instances; s++) {
+            fabric_worker_t *w = &fabric->workers[s];
+
+            fabric_wait(&w->progress, fabric_is_done, w);
+        }
+    }
+}
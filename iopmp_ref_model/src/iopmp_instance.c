@@ -0,0 +1,262 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Instance Memory
+// This file sizes the tables of an IOPMP instance (SRCMD table, entry array,
+// MFR windows, stall state and the lookup caches) from its configuration.
+// All tables live in one block allocated by the allocator of the instance,
+// so a small IOPMP only occupies the memory its RRIDs and entries need.
+// The registers keep their offsets, see read_register() and write_register().
+//
+// An instance is either created by iopmp_create(), or declared by the caller
+// and zeroized, in which case reset_iopmp() allocates its tables with the
+// default allocator.
+//
+// The main functions in this file include:
+// - iopmp_create: Allocates and resets an IOPMP instance.
+// - iopmp_destroy: Releases an IOPMP instance.
+// - iopmp_tables_reserve: Lays out the tables for a configuration.
+// - iopmp_tables_grow: Makes room for the tables of a checkpoint.
+// - iopmp_tables_relayout: Points the instance at its tables after a restore.
+***************************************************************************/
+
+#include "iopmp.h"
+
+// Alignment of the block and of each table in it
+#define TABLE_ALIGN     64
+
+static void *default_alloc(void *ctx, size_t size, size_t align)
+{
+    void *ptr;
+
+    if (posix_memalign(&ptr, align, size))
+        return NULL;
+    return ptr;
+}
+
+static void default_free(void *ctx, void *ptr)
+{
+    free(ptr);
+}
+
+static const iopmp_allocator_t default_allocator = {
+    .alloc = default_alloc,
+    .free  = default_free,
+    .ctx   = NULL,
+};
+
+/* Places a table of size bytes at *offset and returns its address in the block */
+static void *table_place(uint8_t *base, size_t *offset, size_t size)
+{
+    void *table = base ? (base + *offset) : NULL;
+
+    *offset = ALIGNUP(*offset + size, TABLE_ALIGN);
+    return table;
+}
+
+/**
+  * @brief Lays out the tables of a configuration.
+  *
+  * @param iopmp The IOPMP instance, its table pointers are set if base isn't NULL.
+  * @param rrid_num The number of RRIDs.
+  * @param entry_num The number of entries.
+  * @param md_num The number of MDs.
+  * @param srcmd_fmt The SRCMD table format.
+  * @param base The block holding the tables, or NULL to only compute the size.
+  * @return The size (in bytes) of the block.
+ **/
+static size_t tables_layout(iopmp_dev_t *iopmp, size_t rrid_num, size_t entry_num,
+                            size_t md_num, uint32_t srcmd_fmt, uint8_t *base)
+{
+    // The SRCMD table is indexed by MD in SRCMD table format 2
+    size_t srcmd_num = (srcmd_fmt == 2) ? md_num : rrid_num;
+    size_t rrid_words = RRID_WORDS(rrid_num);
+    // SRCMD_EN(H) may associate an RRID with any of the 63 MDs
+    size_t md_rrids_num = (srcmd_fmt == 0) ? (IOPMP_MAX_MD_NUM * rrid_words) : 0;
+    size_t num_svw   = ALIGNUP(rrid_num, 16) / 16;
+    size_t offset    = 0;
+    void *t;
+
+    t = table_place(base, &offset, srcmd_num * sizeof(srcmd_table_t));
+    if (base) iopmp->iopmp_srcmds.srcmd_table = t;
+    t = table_place(base, &offset, entry_num * sizeof(entry_table_t));
+    if (base) iopmp->iopmp_entries.entry_table = t;
+    t = table_place(base, &offset, num_svw * sizeof(err_mfr_t));
+    if (base) {
+        iopmp->err_svs.sv  = t;
+        iopmp->err_svs.num = num_svw;
+    }
+    t = table_place(base, &offset, (ALIGNUP(num_svw, 64) / 64) * sizeof(uint64_t));
+    if (base) iopmp->err_svs.summary = t;
+    t = table_place(base, &offset, rrid_words * sizeof(uint64_t));
+    if (base) iopmp->rrid_stall = t;
+    t = table_place(base, &offset, rrid_words * sizeof(uint64_t));
+    if (base) iopmp->rridscp_unselectable = t;
+
+    t = table_place(base, &offset, entry_num * sizeof(uint64_t));
+    if (base) iopmp->entry_cache.lo = t;
+    t = table_place(base, &offset, entry_num * sizeof(uint64_t));
+    if (base) iopmp->entry_cache.hi = t;
+    t = table_place(base, &offset, entry_num * sizeof(uint16_t));
+    if (base) iopmp->entry_cache.cfg = t;
+    t = table_place(base, &offset, entry_num * sizeof(uint64_t));
+    if (base) iopmp->entry_cache.addr = t;
+
+    t = table_place(base, &offset, rrid_num * sizeof(uint64_t));
+    if (base) iopmp->md_cache.rrid_mds = t;
+    t = table_place(base, &offset, rrid_num * sizeof(uint64_t));
+    if (base) iopmp->md_cache.rrid_r_mds = t;
+    t = table_place(base, &offset, rrid_num * sizeof(uint64_t));
+    if (base) iopmp->md_cache.rrid_w_mds = t;
+    t = table_place(base, &offset, rrid_num * sizeof(uint64_t));
+    if (base) iopmp->md_cache.rrid_x_mds = t;
+    t = table_place(base, &offset, md_rrids_num * sizeof(uint64_t));
+    if (base) iopmp->md_cache.md_rrids = t;
+
+    t = table_place(base, &offset, entry_num * sizeof(uint16_t));
+    if (base) iopmp->nonprio_index.left = t;
+    t = table_place(base, &offset, entry_num * sizeof(uint16_t));
+    if (base) iopmp->nonprio_index.right = t;
+    t = table_place(base, &offset, entry_num * sizeof(uint64_t));
+    if (base) iopmp->nonprio_index.max_hi = t;
+    t = table_place(base, &offset, (ALIGNUP(entry_num, 64) / 64) * sizeof(uint64_t));
+    if (base) iopmp->nonprio_index.indexed = t;
+
+    return offset;
+}
+
+/**
+  * @brief Lays out the zeroized tables of a configuration.
+  *
+  * The block of the instance is reused if it is large enough, otherwise it
+  * is replaced with a larger one. It is called by reset_iopmp() after the
+  * instance is zeroized, with iopmp->storage preserved.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param cfg The hardware configurations of IOPMP instance.
+  * @return 0 on success, -1 if the tables can't be allocated.
+ **/
+int iopmp_tables_reserve(iopmp_dev_t *iopmp, const iopmp_cfg_t *cfg)
+{
+    size_t size = tables_layout(iopmp, cfg->rrid_num, cfg->entry_num, cfg->md_num,
+                                cfg->srcmd_fmt, NULL);
+
+    if (iopmp_tables_grow(iopmp, size) < 0)
+        return -1;
+
+    tables_layout(iopmp, cfg->rrid_num, cfg->entry_num, cfg->md_num, cfg->srcmd_fmt,
+                  iopmp->storage.tables);
+    iopmp->storage.used = size;
+    memset(iopmp->storage.tables, 0, size);
+    return 0;
+}
+
+/**
+  * @brief Makes the block of an instance hold at least size bytes.
+  *
+  * A block which is replaced loses its contents, and the table pointers of
+  * the instance must be laid out again.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param size The size (in bytes) needed.
+  * @return 0 on success, -1 if the block can't be allocated.
+ **/
+int iopmp_tables_grow(iopmp_dev_t *iopmp, size_t size)
+{
+    iopmp_storage_t *storage = &iopmp->storage;
+
+    if (!storage->allocator.alloc)
+        storage->allocator = default_allocator;
+
+    if (size > storage->size) {
+        if (storage->tables && storage->allocator.free)
+            storage->allocator.free(storage->allocator.ctx, storage->tables);
+        storage->tables = storage->allocator.alloc(storage->allocator.ctx, size, TABLE_ALIGN);
+        storage->size   = storage->tables ? size : 0;
+        if (!storage->tables)
+            return -1;
+    }
+    return 0;
+}
+
+/**
+  * @brief Lays out the tables of an instance in its block from its registers.
+  *
+  * It is used after the state of another instance, or of a checkpoint, is
+  * copied into the instance. The block must already be large enough, see
+  * iopmp_tables_grow().
+  *
+  * @param iopmp The IOPMP instance.
+  * @return The size (in bytes) of the tables.
+ **/
+size_t iopmp_tables_relayout(iopmp_dev_t *iopmp)
+{
+    iopmp->storage.used = tables_layout(iopmp, iopmp->reg_file.hwcfg1.rrid_num,
+                                        iopmp->reg_file.hwcfg1.entry_num,
+                                        iopmp->reg_file.hwcfg0.md_num,
+                                        iopmp->reg_file.hwcfg3.srcmd_fmt,
+                                        iopmp->storage.tables);
+    return iopmp->storage.used;
+}
+
+/**
+  * @brief Allocates an IOPMP instance sized for a configuration and resets it.
+  *
+  * The instance can be reset with any configuration later. Its tables grow
+  * if a configuration needs more memory.
+  *
+  * @param cfg The hardware configurations of IOPMP instance when reset.
+  * @param allocator Allocates the instance and its tables, NULL for malloc.
+  * @return The IOPMP instance, or NULL if \p cfg is invalid or allocation fails.
+ **/
+iopmp_dev_t *iopmp_create(iopmp_cfg_t *cfg, const iopmp_allocator_t *allocator)
+{
+    iopmp_dev_t *iopmp;
+
+    if (!allocator)
+        allocator = &default_allocator;
+
+    iopmp = allocator->alloc(allocator->ctx, sizeof(*iopmp), TABLE_ALIGN);
+    if (!iopmp)
+        return NULL;
+    memset(iopmp, 0, sizeof(*iopmp));
+    iopmp->storage.allocator = *allocator;
+    iopmp->storage.owned     = true;
+
+    if (reset_iopmp(iopmp, cfg) < 0) {
+        iopmp_destroy(iopmp);
+        return NULL;
+    }
+    return iopmp;
+}
+
+/**
+  * @brief Releases the tables of an IOPMP instance.
+  *
+  * The instance itself is released only if it was allocated by iopmp_create(),
+  * a zeroized instance declared by the caller can be reset again afterwards.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void iopmp_destroy(iopmp_dev_t *iopmp)
+{
+    iopmp_storage_t storage;
+
+    if (!iopmp)
+        return;
+
+    stats_release(iopmp);
+    storage = iopmp->storage;
+    if (storage.tables && storage.allocator.free)
+        storage.allocator.free(storage.allocator.ctx, storage.tables);
+
+    if (storage.owned) {
+        if (storage.allocator.free)
+            storage.allocator.free(storage.allocator.ctx, iopmp);
+    } else {
+        memset(&iopmp->storage, 0, sizeof(iopmp->storage));
+    }
+}
@@ -0,0 +1,248 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Non-Priority Entry Index
+// This file implements an interval tree over the decoded ranges of the
+// non-priority entries. A transaction is decided by non-priority entries only
+// through entries covering all of its bytes, and the order of non-priority
+// entries doesn't affect the result. The index finds these entries in
+// O(log n + k) instead of scanning every non-priority entry.
+//
+// The tree is a treap keyed by (lo, entry index). Every node is augmented
+// with the maximum end address of its subtree. Entries are inserted and
+// removed as the entry cache decodes them.
+//
+// The main functions in this file include:
+// - nonprio_index_insert: Adds an entry to the index if it qualifies.
+// - nonprio_index_remove: Removes an entry from the index.
+// - nonprio_index_rebuild: Rebuilds the index from the entry cache.
+// - nonprio_index_query: Visits the entries covering a transaction.
+***************************************************************************/
+
+#include "iopmp.h"
+
+#define NIL NONPRIO_INDEX_NIL
+
+#define IS_INDEXED(index, i)    (((index)->indexed[(i) / 64] >> ((i) % 64)) & 1)
+
+/* Heap priority of a node, a hash of the entry index */
+static inline uint32_t node_prio(uint16_t i)
+{
+    uint32_t h = i;
+
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Orders nodes by start address, then by entry index */
+static inline bool node_less(iopmp_dev_t *iopmp, uint16_t a, uint16_t b)
+{
+    uint64_t lo_a = iopmp->entry_cache.lo[a];
+    uint64_t lo_b = iopmp->entry_cache.lo[b];
+
+    return (lo_a < lo_b) || ((lo_a == lo_b) && (a < b));
+}
+
+/* Recomputes the maximum end address of the subtree rooted at node t */
+static inline void node_pull(iopmp_dev_t *iopmp, uint16_t t)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+    uint64_t max_hi = iopmp->entry_cache.hi[t];
+
+    if ((index->left[t] != NIL) && (index->max_hi[index->left[t]] > max_hi))
+        max_hi = index->max_hi[index->left[t]];
+    if ((index->right[t] != NIL) && (index->max_hi[index->right[t]] > max_hi))
+        max_hi = index->max_hi[index->right[t]];
+    index->max_hi[t] = max_hi;
+    // Every node whose children change is pulled
+    CHECKPOINT_DIRTY(iopmp, index->left, t, 1);
+    CHECKPOINT_DIRTY(iopmp, index->right, t, 1);
+    CHECKPOINT_DIRTY(iopmp, index->max_hi, t, 1);
+}
+
+static uint16_t node_insert(iopmp_dev_t *iopmp, uint16_t t, uint16_t x)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+
+    if (t == NIL) {
+        index->left[x]  = NIL;
+        index->right[x] = NIL;
+        node_pull(iopmp, x);
+        return x;
+    }
+
+    if (node_less(iopmp, x, t)) {
+        index->left[t] = node_insert(iopmp, index->left[t], x);
+        if (node_prio(index->left[t]) > node_prio(t)) {
+            // Rotate right
+            uint16_t l = index->left[t];
+            index->left[t] = index->right[l];
+            index->right[l] = t;
+            node_pull(iopmp, t);
+            t = l;
+        }
+    } else {
+        index->right[t] = node_insert(iopmp, index->right[t], x);
+        if (node_prio(index->right[t]) > node_prio(t)) {
+            // Rotate left
+            uint16_t r = index->right[t];
+            index->right[t] = index->left[r];
+            index->left[r] = t;
+            node_pull(iopmp, t);
+            t = r;
+        }
+    }
+    node_pull(iopmp, t);
+    return t;
+}
+
+/* Merges two treaps, where all keys of a are less than all keys of b */
+static uint16_t node_merge(iopmp_dev_t *iopmp, uint16_t a, uint16_t b)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+
+    if (a == NIL) return b;
+    if (b == NIL) return a;
+
+    if (node_prio(a) > node_prio(b)) {
+        index->right[a] = node_merge(iopmp, index->right[a], b);
+        node_pull(iopmp, a);
+        return a;
+    }
+    index->left[b] = node_merge(iopmp, a, index->left[b]);
+    node_pull(iopmp, b);
+    return b;
+}
+
+static uint16_t node_remove(iopmp_dev_t *iopmp, uint16_t t, uint16_t x)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+
+    if (t == NIL) return NIL;
+
+    if (t == x)
+        return node_merge(iopmp, index->left[t], index->right[t]);
+
+    if (node_less(iopmp, x, t))
+        index->left[t] = node_remove(iopmp, index->left[t], x);
+    else
+        index->right[t] = node_remove(iopmp, index->right[t], x);
+    node_pull(iopmp, t);
+    return t;
+}
+
+static bool node_query(iopmp_dev_t *iopmp, uint16_t t,
+                       uint64_t trans_start, uint64_t trans_end,
+                       nonprio_index_visitor_t visit, void *arg)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+
+    while (t != NIL) {
+        // No entry in this subtree ends at or after the transaction end
+        if (index->max_hi[t] < trans_end)
+            return false;
+
+        if (node_query(iopmp, index->left[t], trans_start, trans_end, visit, arg))
+            return true;
+
+        // Entries in the right subtree start at or after this one
+        if (iopmp->entry_cache.lo[t] > trans_start)
+            return false;
+
+        if ((iopmp->entry_cache.hi[t] >= trans_end) && visit(iopmp, t, arg))
+            return true;
+
+        t = index->right[t];
+    }
+
+    return false;
+}
+
+/**
+  * @brief Adds an entry to the non-priority entry index if it qualifies.
+  *
+  * An entry qualifies if it is a non-priority entry and its decoded range
+  * isn't empty. Entries with an empty or inverted range never cover all
+  * bytes of a transaction.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_idx The index of the entry.
+ **/
+void nonprio_index_insert(iopmp_dev_t *iopmp, uint32_t entry_idx)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+
+    if (!iopmp->reg_file.hwcfg2.non_prio_en ||
+        (entry_idx < iopmp->reg_file.hwcfg2.prio_entry) ||
+        (iopmp->entry_cache.lo[entry_idx] >= iopmp->entry_cache.hi[entry_idx]) ||
+        IS_INDEXED(index, entry_idx))
+        return;
+
+    index->root = node_insert(iopmp, index->root, entry_idx);
+    index->indexed[entry_idx / 64] |= (1ULL << (entry_idx % 64));
+    CHECKPOINT_DIRTY(iopmp, index->indexed, entry_idx / 64, 1);
+}
+
+/**
+  * @brief Removes an entry from the non-priority entry index.
+  *
+  * It must be called before the decoded range of the entry changes.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_idx The index of the entry.
+ **/
+void nonprio_index_remove(iopmp_dev_t *iopmp, uint32_t entry_idx)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+
+    if (!IS_INDEXED(index, entry_idx))
+        return;
+
+    index->root = node_remove(iopmp, index->root, entry_idx);
+    index->indexed[entry_idx / 64] &= ~(1ULL << (entry_idx % 64));
+    CHECKPOINT_DIRTY(iopmp, index->indexed, entry_idx / 64, 1);
+}
+
+/**
+  * @brief Rebuilds the non-priority entry index from the entry cache.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void nonprio_index_rebuild(iopmp_dev_t *iopmp)
+{
+    nonprio_index_t *index = &iopmp->nonprio_index;
+    size_t words = ALIGNUP(iopmp->reg_file.hwcfg1.entry_num, 64) / 64;
+
+    index->root = NIL;
+    memset(index->indexed, 0, words * sizeof(uint64_t));
+    CHECKPOINT_DIRTY(iopmp, index->indexed, 0, words);
+    for (uint32_t i = 0; i < iopmp->reg_file.hwcfg1.entry_num; i++) {
+        nonprio_index_insert(iopmp, i);
+    }
+}
+
+/**
+  * @brief Visits the non-priority entries covering all bytes of a transaction.
+  *
+  * Entries are visited in an unspecified order until the visitor returns true.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param trans_start Start address of the transaction.
+  * @param trans_end End address of the transaction.
+  * @param visit Function called for each entry.
+  * @param arg Argument passed to \p visit.
+  * @return true if \p visit returned true for an entry, otherwise false.
+ **/
+bool nonprio_index_query(iopmp_dev_t *iopmp, uint64_t trans_start, uint64_t trans_end,
+                         nonprio_index_visitor_t visit, void *arg)
+{
+    return node_query(iopmp, iopmp->nonprio_index.root, trans_start, trans_end,
+                      visit, arg);
+}
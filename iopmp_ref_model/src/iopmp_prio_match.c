@@ -0,0 +1,142 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Priority Entry Matching Kernels
+// Priority entries are checked in index order and the first priority entry
+// covering any byte of a transaction decides it: a full match grants or
+// denies the transaction and a partial match faults it. Whether an entry
+// covers a byte only depends on its decoded range, so this file compares the
+// ranges of several entries at once and picks the lowest index from the
+// resulting bit mask.
+//
+// The kernel is selected once from the features of the host CPU. The scalar
+// kernel is used on other hosts or when PRIO_MATCH_SIMD_EN is 0.
+//
+// The main functions in this file include:
+// - prio_match_first: Finds the first entry of a span touching a transaction.
+***************************************************************************/
+
+#include "iopmp.h"
+
+#if (PRIO_MATCH_SIMD_EN == 1) && defined(__x86_64__)
+#include <immintrin.h>
+#define PRIO_MATCH_X86
+#endif
+
+typedef uint32_t (*prio_match_fn_t)(const uint64_t *lo, const uint64_t *hi,
+                                    uint32_t lwr_entry, uint32_t upr_entry,
+                                    uint64_t trans_start, uint64_t trans_end);
+
+/* Complement of ENTRY_NOTMATCH in iopmpMatchAddr() */
+static inline bool range_touches(uint64_t lo, uint64_t hi,
+                                 uint64_t trans_start, uint64_t trans_end)
+{
+    return (hi >= lo) && (trans_end > lo) && (trans_start < hi);
+}
+
+static uint32_t prio_match_scalar(const uint64_t *lo, const uint64_t *hi,
+                                  uint32_t lwr_entry, uint32_t upr_entry,
+                                  uint64_t trans_start, uint64_t trans_end)
+{
+    uint32_t i;
+
+    for (i = lwr_entry; i < upr_entry; i++) {
+        if (range_touches(lo[i], hi[i], trans_start, trans_end))
+            break;
+    }
+    return i;
+}
+
+#ifdef PRIO_MATCH_X86
+__attribute__((target("avx2")))
+static uint32_t prio_match_avx2(const uint64_t *lo, const uint64_t *hi,
+                                uint32_t lwr_entry, uint32_t upr_entry,
+                                uint64_t trans_start, uint64_t trans_end)
+{
+    // AVX2 only compares signed integers, so flip the sign bit of both sides
+    const __m256i bias = _mm256_set1_epi64x((long long)(1ULL << 63));
+    const __m256i ts   = _mm256_xor_si256(_mm256_set1_epi64x((long long)trans_start), bias);
+    const __m256i te   = _mm256_xor_si256(_mm256_set1_epi64x((long long)trans_end), bias);
+    uint32_t i = lwr_entry;
+
+    for (; i + 4 <= upr_entry; i += 4) {
+        __m256i l = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&lo[i]), bias);
+        __m256i h = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&hi[i]), bias);
+        __m256i inverted = _mm256_cmpgt_epi64(l, h);
+        __m256i overlap  = _mm256_and_si256(_mm256_cmpgt_epi64(te, l),
+                                            _mm256_cmpgt_epi64(h, ts));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_andnot_si256(inverted, overlap)));
+
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return prio_match_scalar(lo, hi, i, upr_entry, trans_start, trans_end);
+}
+
+__attribute__((target("avx512f")))
+static uint32_t prio_match_avx512(const uint64_t *lo, const uint64_t *hi,
+                                  uint32_t lwr_entry, uint32_t upr_entry,
+                                  uint64_t trans_start, uint64_t trans_end)
+{
+    const __m512i ts = _mm512_set1_epi64((long long)trans_start);
+    const __m512i te = _mm512_set1_epi64((long long)trans_end);
+
+    for (uint32_t i = lwr_entry; i < upr_entry; i += 8) {
+        __mmask8 valid = (upr_entry - i >= 8) ? 0xFF : (__mmask8)((1U << (upr_entry - i)) - 1);
+        __m512i l = _mm512_maskz_loadu_epi64(valid, &lo[i]);
+        __m512i h = _mm512_maskz_loadu_epi64(valid, &hi[i]);
+        __mmask8 mask = valid;
+
+        mask = _mm512_mask_cmp_epu64_mask(mask, h, l, _MM_CMPINT_NLT);
+        mask = _mm512_mask_cmp_epu64_mask(mask, l, te, _MM_CMPINT_LT);
+        mask = _mm512_mask_cmp_epu64_mask(mask, ts, h, _MM_CMPINT_LT);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return upr_entry;
+}
+#endif
+
+static prio_match_fn_t prio_match_select(void)
+{
+#ifdef PRIO_MATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return prio_match_avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return prio_match_avx2;
+#endif
+    return prio_match_scalar;
+}
+
+/**
+  * @brief Finds the first entry of a span which covers any byte of a transaction.
+  *
+  * It gives the same result as checking iopmpMatchAddr() != ENTRY_NOTMATCH
+  * on each entry of the span in index order.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param lwr_entry First entry of the span.
+  * @param upr_entry One past the last entry of the span.
+  * @param trans_start Start address of the transaction.
+  * @param trans_end End address of the transaction.
+  * @return The index of the first touching entry, or upr_entry if there is none.
+ **/
+uint32_t prio_match_first(iopmp_dev_t *iopmp, uint32_t lwr_entry, uint32_t upr_entry,
+                          uint64_t trans_start, uint64_t trans_end)
+{
+    static prio_match_fn_t prio_match_fn;
+    prio_match_fn_t fn = __atomic_load_n(&prio_match_fn, __ATOMIC_RELAXED);
+
+    if (!fn) {
+        // Threads racing here select the same kernel
+        fn = prio_match_select();
+        __atomic_store_n(&prio_match_fn, fn, __ATOMIC_RELAXED);
+    }
+
+    return fn(iopmp->entry_cache.lo, iopmp->entry_cache.hi,
+              lwr_entry, upr_entry, trans_start, trans_end);
+}
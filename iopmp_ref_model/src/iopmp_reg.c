@@ -13,13 +13,16 @@
 // The main functions in this file include:
 // - reset_iopmp: Resets the I/O Physical Memory Protection (IOPMP)
 //   configuration registers to default values.
-// - is_access_valid: Checks if the access to a given offset and number
-//   of bytes is valid.
+// - reg_decode: Decodes the offset of a register access with the decode
+//   table built by reset_iopmp.
 // - read_register: Reads a register based on the given offset and byte size.
 // - rrid_stall_update: Updates the stall status for each RRID based on
 //   memory domain stall conditions.
 // - write_register: Writes data to a memory-mapped register identified
 //   by the specified offset.
+// - write_register_block: Writes consecutive registers.
+// - iopmp_program_begin: Starts a programming session, which defers the
+//   updates of derived state until iopmp_program_commit.
 ***************************************************************************/
 
 #include "iopmp.h"
@@ -32,6 +35,9 @@
 #define GENMASK_64(h, l) \
     (((~(uint64_t)0) - ((uint64_t)1 << (l)) + 1) & (~(uint64_t)0 >> (64-1-(h))))
 
+// Instance the calling thread is programming, see iopmp_program_begin()
+static __thread iopmp_dev_t *program_thread_session;
+
 uint64_t gen_granularity_tor_mask(uint8_t G)
 {
     return GENMASK_64(G - 1, 0);
@@ -42,6 +48,98 @@ uint64_t gen_granularity_napot_mask(uint8_t G)
     return GENMASK_64(G - 2, 0);
 }
 
+/**
+ * @brief Builds the register decode table of an IOPMP instance.
+ *
+ * The location of the MDCFG table, the SRCMD table and the entry array, and
+ * the implemented MD bits only depend on read-only fields, so an offset is
+ * decoded with one table lookup or range check instead of checking every
+ * table on each access.
+ *
+ * @param iopmp The IOPMP instance.
+ */
+static void reg_decode_build(iopmp_dev_t *iopmp)
+{
+    reg_decode_t *dec = &iopmp->reg_decode;
+    uint32_t md_num    = iopmp->reg_file.hwcfg0.md_num;
+    // The SRCMD table is indexed by MD in SRCMD table format 2
+    uint32_t srcmd_num = (iopmp->reg_file.hwcfg3.srcmd_fmt == 2) ? md_num :
+                         iopmp->reg_file.hwcfg1.rrid_num;
+
+    memset(dec->cls, REG_CLASS_CTRL, sizeof(dec->cls));
+
+    // Only baseline MDCFG table format implements MDCFG table
+    if (iopmp->reg_file.hwcfg3.mdcfg_fmt == 0) {
+        memset(&dec->cls[MDCFG_TABLE_BASE_OFFSET / MIN_REG_WIDTH], REG_CLASS_MDCFG, md_num);
+    }
+
+    // Only the error record and stall registers never change a decision
+    dec->cls[ERR_INFO_OFFSET / MIN_REG_WIDTH] |= REG_KEEPS_DECISIONS;
+    dec->cls[ERR_MFR_OFFSET / MIN_REG_WIDTH]  |= REG_KEEPS_DECISIONS;
+    dec->cls[MDSTALL_OFFSET / MIN_REG_WIDTH]  |= REG_KEEPS_DECISIONS;
+    dec->cls[MDSTALLH_OFFSET / MIN_REG_WIDTH] |= REG_KEEPS_DECISIONS;
+    dec->cls[RRIDSCP_OFFSET / MIN_REG_WIDTH]  |= REG_KEEPS_DECISIONS;
+
+    dec->srcmd_end   = SRCMD_TABLE_BASE_OFFSET + ((uint64_t)srcmd_num * SRCMD_REG_STRIDE);
+    dec->entry_start = iopmp->reg_file.entryoffset.offset;
+    dec->entry_end   = dec->entry_start +
+                       ((uint64_t)iopmp->reg_file.hwcfg1.entry_num * ENTRY_REG_STRIDE);
+
+    // Bit 0 of SRCMD_{EN,R,W,X} and MDSTALL isn't an MD bit
+    dec->md_mask      = (md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num, 0);
+    dec->mdh_mask     = (md_num < 32) ? 0 : GENMASK_32(md_num - 32, 0);
+    dec->mdstall_mask = (md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num - 1, 0);
+}
+
+/**
+ * @brief Decodes the offset of a register access.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param offset The offset within the memory map.
+ * @param num_bytes The number of bytes requested for the access.
+ * @param acc Receives the table index and register of MDCFG, SRCMD table and
+ *            entry array accesses.
+ *
+ * @return The class of the register with REG_KEEPS_DECISIONS, or
+ *         REG_CLASS_NONE if the access is invalid.
+ */
+static inline uint8_t reg_decode(iopmp_dev_t *iopmp, uint64_t offset, uint8_t num_bytes,
+                                 reg_access_t *acc)
+{
+    const reg_decode_t *dec = &iopmp->reg_decode;
+
+    // The requested byte size must be either 4 or 8, within the bus width,
+    // and the offset must be aligned with it.
+    if ((num_bytes != 4 && num_bytes != 8) ||
+        (num_bytes > REG_INTF_BUS_WIDTH) ||
+        ((offset & (num_bytes - 1)) != 0)) {
+        return REG_CLASS_NONE;
+    }
+
+    // All registers except SRCMD Table and Entry Array
+    if (offset < SRCMD_TABLE_BASE_OFFSET) {
+        uint8_t cls = dec->cls[offset / MIN_REG_WIDTH];
+
+        if (REG_CLASS(cls) == REG_CLASS_MDCFG)
+            acc->idx = MDCFG_TABLE_INDEX(offset);
+        return cls;
+    }
+
+    if (offset < dec->srcmd_end) {
+        acc->idx = SRCMD_TABLE_INDEX(offset);
+        acc->reg = SRCMD_REG_INDEX(offset);
+        return REG_CLASS_SRCMD;
+    }
+
+    if ((offset >= dec->entry_start) && (offset < dec->entry_end)) {
+        acc->idx = (offset - dec->entry_start) / ENTRY_REG_STRIDE;
+        acc->reg = ((offset - dec->entry_start) % ENTRY_REG_STRIDE) / MIN_REG_WIDTH;
+        return REG_CLASS_ENTRY;
+    }
+
+    return REG_CLASS_NONE;
+}
+
 /**
  * @brief Resets the I/O Physical Memory Protection (IOPMP) configuration
  * registers to default values.
@@ -111,8 +209,30 @@ int reset_iopmp(iopmp_dev_t *iopmp, iopmp_cfg_t *cfg)
     if ((cfg->granularity > UINT32_MAX) && !cfg->addrh_en)
         return -1;
 
-    // Zeroize all states
+    // Zeroize all states, and lay out the tables sized for this configuration
+    iopmp_storage_t storage = iopmp->storage;
+    iopmp_stall_release_fn_t stall_release = iopmp->stall_release;
+    void *stall_release_ctx = iopmp->stall_release_ctx;
+#if (HIT_STATS_EN == 1)
+    iopmp_stats_t stats = iopmp->stats;
+#endif
+#if (TRACE_EN == 1)
+    // A trace replays from the state its recording started from, so the
+    // recording ends at a reset
+    if (iopmp->trace)
+        iopmp_trace_record_stop(iopmp);
+#endif
     memset(iopmp, 0, sizeof(*iopmp));
+    iopmp->storage           = storage;
+    iopmp->stall_release     = stall_release;
+    iopmp->stall_release_ctx = stall_release_ctx;
+#if (HIT_STATS_EN == 1)
+    iopmp->stats             = stats;
+#endif
+    if (iopmp_tables_reserve(iopmp, cfg) < 0)
+        return -1;
+    if (stats_reserve(iopmp, cfg->entry_num, cfg->rrid_num) < 0)
+        return -1;
 
     // Reset all IOPMP registers
     iopmp->reg_file.version.vendor          = cfg->vendor;
@@ -173,114 +293,23 @@ int reset_iopmp(iopmp_dev_t *iopmp, iopmp_cfg_t *cfg)
     iopmp->imp_err_reqid_eid                = cfg->imp_err_reqid_eid;
     iopmp->imp_rridscp                      = cfg->imp_rridscp;
     if (cfg->imp_rridscp) {
-        memcpy(iopmp->rridscp_unselectable, cfg->rridscp_unselectable,
-               sizeof(cfg->rridscp_unselectable));
+        for (uint32_t i = 0; i < cfg->rrid_num; i++) {
+            if (cfg->rridscp_unselectable[i])
+                BITSET_SET(iopmp->rridscp_unselectable, i);
+        }
     }
     iopmp->imp_stall_buffer                 = cfg->imp_stall_buffer;
 
-    return 0;
-}
-
-/**
- * @brief Checks if the access to a given offset is within MDCFG table.
- *
- * @param iopmp The IOPMP instance.
- * @param offset The offset to be checked for access.
- *
- * @return true if the access is within MDCFG table, false if not.
- */
-static bool is_access_mdcfg_table(iopmp_dev_t *iopmp, uint64_t offset)
-{
-    // Only baseline MDCFG table format implements MDCFG table
-    if (iopmp->reg_file.hwcfg3.mdcfg_fmt != 0)
-        return false;
-
-    uint64_t start = MDCFG_TABLE_BASE_OFFSET;
-    uint64_t end   = MDCFG_TABLE_BASE_OFFSET +
-                     ((iopmp->reg_file.hwcfg0.md_num - 1) * 4);
-
-    return IS_IN_RANGE(offset, start, end);
-}
-
-/**
- * @brief Checks if the access to a given offset is within SRCMD table.
- *
- * @param iopmp The IOPMP instance.
- * @param offset The offset to be checked for access.
- *
- * @return true if the access is within SRCMD table, false if not.
- */
-static bool is_access_srcmd_table(iopmp_dev_t *iopmp, uint64_t offset)
-{
-    uint64_t start = SRCMD_TABLE_BASE_OFFSET;
-    uint64_t end   = SRCMD_TABLE_BASE_OFFSET;
-
-    switch (iopmp->reg_file.hwcfg3.srcmd_fmt) {
-    case 0:
-    case 1:
-        end = SRCMD_TABLE_BASE_OFFSET +
-              ((iopmp->reg_file.hwcfg1.rrid_num - 1) * SRCMD_REG_STRIDE) +
-              (SRCMD_REG_STRIDE - 4);
-        break;
-    case 2:
-        end = SRCMD_TABLE_BASE_OFFSET +
-              ((iopmp->reg_file.hwcfg0.md_num - 1) * SRCMD_REG_STRIDE) +
-              (SRCMD_REG_STRIDE - 4);
-        break;
-    default:
-        return false;
-    }
-
-    return IS_IN_RANGE(offset, start, end);
-}
-
-/**
- * @brief Checks if the access to a given offset is within entry array.
- *
- * @param iopmp The IOPMP instance.
- * @param offset The offset to be checked for access.
- *
- * @return true if the access is within entry array, false if not.
- */
-static bool is_access_entry_array(iopmp_dev_t *iopmp, uint64_t offset)
-{
-    uint64_t start = iopmp->reg_file.entryoffset.offset;
-    uint64_t end   = iopmp->reg_file.entryoffset.offset +
-                     ((iopmp->reg_file.hwcfg1.entry_num - 1) * ENTRY_REG_STRIDE) +
-                     (ENTRY_REG_STRIDE - 4);    // Last ENTRY_USER_CFG
-
-    return IS_IN_RANGE(offset, start, end);
-}
-
-/**
-  * @brief Checks if the access to a given offset and number of bytes is valid.
-  *
-  * @param iopmp The IOPMP instance.
-  * @param offset     The offset within the memory map to check for access.
-  * @param num_bytes  The number of bytes requested for the access.
-  * @return bool   Returns 1 if access is valid, 0 if invalid.
- **/
-static bool is_access_valid(iopmp_dev_t *iopmp, uint64_t offset, uint8_t num_bytes) {
-    // Validate the access by checking:
-    // 1. If the requested byte size is either 4 or 8.
-    // 2. If the offset is within the allowable range for valid RRIDs,
-    //    and if it is outside the range, ensure it falls within the IOPMP rule range.
-    // 3. If the offset is aligned with the requested byte size.
-    if ((num_bytes != 4 && num_bytes != 8) ||
-        (num_bytes > REG_INTF_BUS_WIDTH) ||
-        ((offset & (num_bytes - 1)) != 0)) {
-        return 0; // Access is invalid
-    }
-
-    if (offset < SRCMD_TABLE_BASE_OFFSET)   // All registers except SRCMD Table and Entry Array
-        return 1;
-
-    if (is_access_srcmd_table(iopmp, offset))
-        return 1;
-    if (is_access_entry_array(iopmp, offset))
-        return 1;
+    // Build the lookup caches for the check path
+    reg_decode_build(iopmp);
+    entry_cache_rebuild(iopmp);
+    md_cache_rebuild(iopmp);
+    validate_select(iopmp);
+#if (DECISION_CACHE_EN == 1)
+    decision_cache_reset(iopmp);
+#endif
 
-    return 0; // Access is valid
+    return 0;
 }
 
 /**
@@ -344,71 +373,106 @@ static uint32_t read_entry_addr(iopmp_dev_t *iopmp, uint16_t entry_idx,
  *
  * @return The value of the register in the appropriate size (4 or 8 bytes).
  */
-reg_intf_dw read_register(iopmp_dev_t *iopmp, uint64_t offset, uint8_t num_bytes) {
+static reg_intf_dw read_register_locked(iopmp_dev_t *iopmp, uint64_t offset, uint8_t num_bytes) {
+    reg_access_t acc;
+    uint8_t cls = REG_CLASS(reg_decode(iopmp, offset, num_bytes, &acc));
 
-    if (!is_access_valid(iopmp, offset, num_bytes)) return 0;
+    if (cls == REG_CLASS_NONE) return 0;
 
     // If the requested offset corresponds to the error MFR (ERR_MFR_OFFSET)
     // handle reading from the error register.
     if (offset == ERR_MFR_OFFSET && iopmp->reg_file.hwcfg2.mfr_en) {
+        uint32_t *err_info_word = REG_WORD(iopmp, ERR_INFO_OFFSET);
+        err_info_t err_info = { .raw = __atomic_load_n(err_info_word, __ATOMIC_ACQUIRE) };
+        err_info_t svc = { .raw = 0 };
+
         // ERR_INFO.svc=0 indicates there is no subsequent violation.
-        if (iopmp->reg_file.err_info.svc == 0)
+        if (err_info.svc == 0)
             return 0;
+        svc.svc = 1;
 
         // Clear the error flags for error register.
         iopmp->reg_file.err_mfr.svs = 0;
         iopmp->reg_file.err_mfr.svw = 0;
 
-        // Start searching for errors from the current error index.
-        int start_index = iopmp->reg_file.err_mfr.svi;
-
-        // Loop over the RRIDs to find any error state.
-        for (int i = 0; i < NUM_SVW; i++) {
-            // Calculate the current index, with wrap-around using modulo.
-            int current_index = (start_index + i) % NUM_SVW;
-
-            // If an error is found (svw is non-zero), update the error status.
-            if (iopmp->err_svs.sv[current_index].svw) {
-                iopmp->reg_file.err_mfr.svw = iopmp->err_svs.sv[current_index].svw;   // Subsequent violation window
-                iopmp->reg_file.err_mfr.svi = current_index;                          // Update the error index.
-                iopmp->reg_file.err_mfr.svs = 1;                                      // Subsequent Violation Status
+        // Jump to the next window holding a violation from the current
+        // error index, see sv_window_take()
+        uint16_t svw;
+        int index = sv_window_take(iopmp, iopmp->reg_file.err_mfr.svi, &svw);
 
-                // Clear the error flag after processing.
-                iopmp->err_svs.sv[current_index].svw = 0;
-                break;
-            }
+        if (index >= 0) {
+            iopmp->reg_file.err_mfr.svw = svw;                      // Subsequent violation window
+            iopmp->reg_file.err_mfr.svi = index;                    // Update the error index.
+            iopmp->reg_file.err_mfr.svs = 1;                        // Subsequent Violation Status
         }
 
-        // Clear ERR_INFO.svc if there is no subsequent violation.
-        iopmp->reg_file.err_info.svc = 0;
-        for (int i = 0; i < NUM_SVW; i++) {
-            if (iopmp->err_svs.sv[i].svw) {
-                iopmp->reg_file.err_info.svc = 1;
-                break;
-            }
-        }
+        // Clear ERR_INFO.svc if there is no subsequent violation. It is
+        // cleared before the check, so a violation recorded meanwhile either
+        // is seen by the check or sets ERR_INFO.svc again.
+        __atomic_fetch_and(err_info_word, ~svc.raw, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&iopmp->err_svs.top, __ATOMIC_SEQ_CST))
+            __atomic_fetch_or(err_info_word, svc.raw, __ATOMIC_RELAXED);
 
         return iopmp->reg_file.err_mfr.raw;
     }
 
     // If the offset is within the valid range for entry registers, return the appropriate value.
-    if (is_access_entry_array(iopmp, offset)) {
-        uint32_t entry_reg = ENTRY_REG_INDEX(iopmp, offset);
-        uint16_t entry_idx = ENTRY_TABLE_INDEX(iopmp, offset);
-
-        if (entry_reg == 0 || entry_reg == 1)
-            return read_entry_addr(iopmp, entry_idx, (entry_reg == 1));
+    if (cls == REG_CLASS_ENTRY) {
+        if (acc.reg == 0 || acc.reg == 1)
+            return read_entry_addr(iopmp, acc.idx, (acc.reg == 1));
 
         // Return 4-byte or 8-byte register value based on num_bytes.
         return iopmp->iopmp_entries.regs4[(offset - iopmp->reg_file.entryoffset.offset) / num_bytes];
     }
 
+    // The SRCMD table is held apart from the other registers
+    if (cls == REG_CLASS_SRCMD)
+        return iopmp->iopmp_srcmds.regs4[(offset - SRCMD_TABLE_BASE_OFFSET) / num_bytes];
+
     // For all other offsets, return the corresponding register value.
     // If num_bytes is 4, return a 4-byte value, otherwise return an 8-byte value.
-    return iopmp->reg_file.regs4[offset / num_bytes];
+    // Acquire pairs with the release of ERR_INFO.v by errorCapture()
+    return __atomic_load_n(&iopmp->reg_file.regs4[offset / num_bytes], __ATOMIC_ACQUIRE);
 }
 
-static void handle_mdcfg_improper_settings(iopmp_dev_t *iopmp)
+/**
+ * @brief Reads a register based on the given offset and byte size.
+ *
+ * It may be called while other threads check transactions, see
+ * read_register_locked() for the register semantics.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param offset The offset of the register to be read.
+ * @param num_bytes The number of bytes to read (either 4 or 8 bytes).
+ *
+ * @return The value of the register in the appropriate size (4 or 8 bytes).
+ */
+reg_intf_dw read_register(iopmp_dev_t *iopmp, uint64_t offset, uint8_t num_bytes) {
+    // The session of the calling thread already holds the lock
+    bool in_session = (program_thread_session == iopmp);
+    reg_intf_dw data;
+
+    if (!in_session)
+        epoch_lock(iopmp);
+    data = read_register_locked(iopmp, offset, num_bytes);
+#if (TRACE_EN == 1)
+    if (iopmp->trace)
+        trace_record_reg(iopmp, IOPMP_TRACE_READ, offset, data, num_bytes);
+#endif
+    if (!in_session)
+        epoch_unlock(iopmp);
+    return data;
+}
+
+/**
+ * @brief Fixes an MDCFG table which isn't monotonically incremental.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param written The MDCFG written in a table which was proper before the
+ *                write, or -1 to fix the whole table. Only the MDCFGs from
+ *                \p written up to the first proper one are fixed then.
+ */
+static void handle_mdcfg_improper_settings(iopmp_dev_t *iopmp, int written)
 {
 #if (MDCFG_TABLE_IMPROPER_SETTING_BEHAVIOR == 0)
     /*
@@ -423,9 +487,11 @@ static void handle_mdcfg_improper_settings(iopmp_dev_t *iopmp)
      * - For any m >= 1, if (MDCFG(m).t < MDCFG(m-1).t):
      *                       MDCFG(m).t = MDCFG(m-1).t
      */
-    for (int m = 1; m < iopmp->reg_file.hwcfg0.md_num; m++) {
+    for (int m = (written > 1) ? written : 1; m < iopmp->reg_file.hwcfg0.md_num; m++) {
         if (iopmp->reg_file.mdcfg[m].t < iopmp->reg_file.mdcfg[m - 1].t) {
             iopmp->reg_file.mdcfg[m].t = iopmp->reg_file.mdcfg[m - 1].t;
+        } else if ((written >= 0) && (m > written)) {
+            break;  // The MDCFGs after m were already proper
         }
     }
 #endif
@@ -439,116 +505,97 @@ static void handle_mdcfg_improper_settings(iopmp_dev_t *iopmp)
  */
 void rrid_stall_update(iopmp_dev_t *iopmp, uint8_t exempt) {
     uint64_t stall_by_md;
+    uint32_t rrid_num   = iopmp->reg_file.hwcfg1.rrid_num;
+    uint32_t rrid_words = RRID_WORDS(rrid_num);
+    uint64_t *rrid_stall = iopmp->rrid_stall;
 
     // Combine the high and low parts of the 'mdstall' register to create a full 64-bit stall mask.
     stall_by_md = ((uint64_t)iopmp->reg_file.mdstallh.mdh << 31) | iopmp->reg_file.mdstall.md;
 
-    // Iterate through all RRIDs to update the stall status.
-    for (int i = 0; i < iopmp->reg_file.hwcfg1.rrid_num; i++) {
-        switch (iopmp->reg_file.hwcfg3.srcmd_fmt) {
-        case 0: {
-            uint64_t srcmd_md;
-            // Format 0: Combine srcmd_enh and srcmd_en fields to evaluate stall conditions.
-            // This forms a 64-bit value representing memory domain stall conditions.
-            srcmd_md = ((uint64_t)iopmp->reg_file.srcmd_table[i].srcmd_enh.mdh << 31) | iopmp->reg_file.srcmd_table[i].srcmd_en.md;
-            // Update the rrid_stall array based on the combined stall conditions, considering the exempt flag.
-            iopmp->rrid_stall[i] = exempt ^ ((srcmd_md & stall_by_md) != 0);
-            break;
-        }
-        case 1:
-            // Format 1: Directly use the bit at position `i` in the `stall_by_md` mask for the RRID stall condition.
-            // Because in format 1. RRID i is directly mapped with MD i.
-            iopmp->rrid_stall[i] = exempt ^ (((stall_by_md >> i) & 1) != 0);
-            break;
-        case 2: {
-            uint64_t srcmd_md;
-            srcmd_md = (1ULL << iopmp->reg_file.hwcfg0.md_num) - 1;
-            // Update rrid_stall based on the accumulated permissions and the stall conditions.
-            iopmp->rrid_stall[i] = exempt ^ ((srcmd_md & stall_by_md) != 0);
-            break;
-        }
-        default:
-            break;
+    switch (iopmp->reg_file.hwcfg3.srcmd_fmt) {
+    case 0:
+        // Format 0: An RRID is stalled if any MD in its SRCMD_EN(H) is stalled,
+        // so OR the RRID bitsets of the stalled MDs.
+        memset(rrid_stall, 0, rrid_words * sizeof(uint64_t));
+        for (uint64_t mds = stall_by_md; mds; mds &= mds - 1) {
+            const uint64_t *md_rrids = &iopmp->md_cache.md_rrids[__builtin_ctzll(mds) * rrid_words];
+
+            for (uint32_t w = 0; w < rrid_words; w++) {
+                rrid_stall[w] |= md_rrids[w];
+            }
         }
+        break;
+    case 1:
+        // Format 1: RRID i is directly mapped with MD i.
+        memset(rrid_stall, 0, rrid_words * sizeof(uint64_t));
+        rrid_stall[0] = stall_by_md;
+        break;
+    case 2: {
+        // Format 2: Every RRID is associated with all MDs.
+        uint64_t srcmd_md = (1ULL << iopmp->reg_file.hwcfg0.md_num) - 1;
+        memset(rrid_stall, ((srcmd_md & stall_by_md) != 0) ? 0xFF : 0, rrid_words * sizeof(uint64_t));
+        break;
     }
+    default:
+        return;
+    }
+
+    // Invert the stall status of all RRIDs if they are exempted, then clear
+    // the bits of unimplemented RRIDs.
+    for (uint32_t w = 0; w < rrid_words; w++) {
+        rrid_stall[w] ^= exempt ? UINT64_MAX : 0;
+    }
+    if (rrid_num % 64) {
+        rrid_stall[rrid_words - 1] &= (1ULL << (rrid_num % 64)) - 1;
+    }
+    CHECKPOINT_DIRTY(iopmp, rrid_stall, 0, rrid_words);
 }
 
 /**
- * @brief Writes data to a memory-mapped register identified by the specified offset.
+ * @brief Runs the updates of derived state deferred by register writes.
  *
- * The data type `reg_intf_dw` depends on the configuration in the `config.h` file
- *  (e.g., `uint32_t` for 4-byte width, `uint64_t` for 8-byte width).
+ * A register write records the derived state it changes in
+ * program.pending. The updates run at the end of the write, or when the
+ * programming session is committed.
  *
  * @param iopmp The IOPMP instance.
- * @param offset The offset of the register to be written.
- * @param data It contains the data that need to be written.
- * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
- *
+ * @param what The DEFER_* updates to run if they are pending.
  */
-void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8_t num_bytes) {
-
-  // Extract lower and upper 32-bits of data based on bus width
-    uint32_t lwr_data4, upr_data4;
-#if (REG_INTF_BUS_WIDTH == 8)
-    lwr_data4 = data & UINT32_MAX;
-    upr_data4 = (data >> 32) & UINT32_MAX;  // Using 32 bits for upper part
-#else
-    lwr_data4 = data;
-    upr_data4 = data;         // Upper part is same as lower part
+static void program_flush(iopmp_dev_t *iopmp, uint32_t what)
+{
+    uint32_t pending = iopmp->program.pending & what;
+
+    iopmp->program.pending &= ~what;
+    if (pending & DEFER_NONPRIO_INDEX)
+        nonprio_index_rebuild(iopmp);
+    if (pending & DEFER_MD_SPANS)
+        md_cache_update_spans(iopmp);
+    if (pending & DEFER_RRID_STALL)
+        rrid_stall_update(iopmp, iopmp->reg_file.mdstall.exempt);
+    if (pending & DEFER_VALIDATOR)
+        validate_select(iopmp);
+#if (DECISION_CACHE_EN == 1)
+    if (pending & DEFER_DECISIONS)
+        decision_cache_invalidate(iopmp);
 #endif
+    // Checks the released transactions with the new configuration
+    if (pending & DEFER_STALL_REPLAY)
+        stall_buffer_replay(iopmp);
+}
 
-  // Initialize temporary registers
-    hwcfg0_t         hwcfg0_temp         = { .raw = lwr_data4 };
-    hwcfg2_t         hwcfg2_temp         = { .raw = lwr_data4 };
-    hwcfg3_t         hwcfg3_temp         = { .raw = lwr_data4 };
-    entrylck_t       entrylck_temp       = { .raw = upr_data4 };
-    err_cfg_t        err_cfg_temp        = { .raw = lwr_data4 };
-    entry_addr_t     entry_addr_temp     = { .raw = lwr_data4 };
-    entry_addrh_t    entry_addrh_temp    = { .raw = upr_data4 };
-    entry_cfg_t      entry_cfg_temp      = { .raw = lwr_data4 };
-    entry_user_cfg_t entry_user_cfg_temp = { .raw = upr_data4 };
-
-// Conditional block for error capture
-    err_info_t err_info_temp = { .raw = upr_data4 };
-
-// Conditional block for msi addr
-    err_msiaddr_t    err_msiaddr_temp    = { .raw = lwr_data4 };
-    err_msiaddrh_t   err_msiaddrh_temp   = { .raw = upr_data4 };
-
-// Conditional block for SRCMD format
-    mdlck_t  mdlck_temp  = { .raw = lwr_data4 };
-    mdlckh_t mdlckh_temp = { .raw = upr_data4 };
-
-// MDCFG format check
-    mdcfglck_t mdcfglck_temp = { .raw = lwr_data4 };
-    mdcfg_t    mdcfg_temp    = { .raw = data };
-
-    uint32_t md_num = iopmp->reg_file.hwcfg0.md_num;
-
-// SRCMD format handling
-    srcmd_en_t  srcmd_en_temp  = { .raw = lwr_data4 & ((md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num, 0)) };
-    srcmd_enh_t srcmd_enh_temp = { .raw = (md_num < 32) ? 0 : upr_data4 & GENMASK_32(md_num - 32, 0) };
-    srcmd_r_t   srcmd_r_temp   = { .raw = lwr_data4 & ((md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num, 0)) };
-    srcmd_rh_t  srcmd_rh_temp  = { .raw = (md_num < 32) ? 0 : upr_data4 & GENMASK_32(md_num - 32, 0) };
-    srcmd_w_t   srcmd_w_temp   = { .raw = lwr_data4 & ((md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num, 0)) };
-    srcmd_wh_t  srcmd_wh_temp  = { .raw = (md_num < 32) ? 0 : upr_data4 & GENMASK_32(md_num - 32, 0) };
-    srcmd_x_t   srcmd_x_temp   = { .raw = lwr_data4 & ((md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num, 0)) };
-    srcmd_xh_t  srcmd_xh_temp  = { .raw = (md_num < 32) ? 0 : upr_data4 & GENMASK_32(md_num - 32, 0) };
-    srcmd_perm_t  srcmd_perm_temp  = { .raw = lwr_data4 };
-    srcmd_permh_t srcmd_permh_temp = { .raw = upr_data4 };
-
-// IOPMP Stall configuration
-    mdstall_t  mdstall_temp  = { .raw = lwr_data4 & ((md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num, 0)) };
-    mdstallh_t mdstallh_temp = { .raw = (md_num < 32) ? 0 : upr_data4 & GENMASK_32(md_num - 32, 0) };
-    rridscp_t  rridscp_temp  = { .raw = lwr_data4 };
-    rridscp_temp.op          = (lwr_data4 >> 30) & MASK_BIT_POS(2);
-    mdstall_temp.md          = (lwr_data4 >> 1) & ((md_num >= 31) ? UINT32_MAX : GENMASK_32(md_num - 1, 0));
-    mdstall_temp.exempt      = GET_BIT(lwr_data4, 0);
-
-// IOPMP MFR configuration
-    err_mfr_t err_mfr_temp = { .raw = upr_data4 };
-
-    if (!is_access_valid(iopmp, offset, num_bytes)) return;
+/**
+ * @brief Writes a control, status or error register.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param offset The offset of the register to be written.
+ * @param lwr_data4 The lower 32 bits of the data.
+ * @param upr_data4 The upper 32 bits of the data.
+ * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
+ */
+static void write_ctrl_register(iopmp_dev_t *iopmp, uint64_t offset, uint32_t lwr_data4,
+                                uint32_t upr_data4, uint8_t num_bytes)
+{
+    const reg_decode_t *dec = &iopmp->reg_decode;
 
     switch (offset) {
     case VERSION_OFFSET:
@@ -559,34 +606,46 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
       // This register is read only
       return;
 
-    case HWCFG0_OFFSET:
+    case HWCFG0_OFFSET: {
+        hwcfg0_t hwcfg0_temp = { .raw = lwr_data4 };
+
         // HWCFG0.enable is W1SS
         if (hwcfg0_temp.enable && !iopmp->reg_file.hwcfg0.enable) {
             iopmp->reg_file.hwcfg0.enable = true;
-            handle_mdcfg_improper_settings(iopmp);
+            handle_mdcfg_improper_settings(iopmp, -1);
+            iopmp->program.pending |= DEFER_MD_SPANS;
         }
         break;
+    }
 
     case HWCFG1_OFFSET:
         // This register is read only
         return;
 
-    case HWCFG2_OFFSET:
+    case HWCFG2_OFFSET: {
+        hwcfg2_t hwcfg2_temp = { .raw = lwr_data4 };
+
         if (iopmp->reg_file.hwcfg0.HWCFG2_en) {
             if (iopmp->reg_file.hwcfg2.non_prio_en) {
                 if (iopmp->reg_file.hwcfg2.prio_ent_prog) {
                     iopmp->reg_file.hwcfg2.prio_entry = hwcfg2_temp.prio_entry;
+                    iopmp->program.pending |= DEFER_NONPRIO_INDEX;
                 }
                 iopmp->reg_file.hwcfg2.prio_ent_prog &= ~hwcfg2_temp.prio_ent_prog;
             }
+            iopmp->program.pending |= DEFER_VALIDATOR;
         }
         break;
+    }
+
+    case HWCFG3_OFFSET: {
+        hwcfg3_t hwcfg3_temp = { .raw = lwr_data4 };
 
-    case HWCFG3_OFFSET:
         if (iopmp->reg_file.hwcfg0.HWCFG3_en) {
             if (iopmp->reg_file.hwcfg3.mdcfg_fmt == 2) {
                 if (!iopmp->reg_file.hwcfg0.enable) {
                     iopmp->reg_file.hwcfg3.md_entry_num = hwcfg3_temp.md_entry_num;
+                    iopmp->program.pending |= DEFER_MD_SPANS;
                 }
             }
             if (iopmp->reg_file.hwcfg3.rrid_transl_en) {
@@ -595,44 +654,57 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
                 }
                 iopmp->reg_file.hwcfg3.rrid_transl_prog &= ~hwcfg3_temp.rrid_transl_prog;
             }
+            iopmp->program.pending |= DEFER_VALIDATOR;
         }
         break;
+    }
 
     case ENTRYOFFSET_OFFSET:
         // This register is read only
         return;
 
-    case MDSTALL_OFFSET:
+    case MDSTALL_OFFSET: {
+        mdstall_t mdstall_temp = { .raw = lwr_data4 & dec->md_mask };
+
+        mdstall_temp.md     = (lwr_data4 >> 1) & dec->mdstall_mask;
+        mdstall_temp.exempt = GET_BIT(lwr_data4, 0);
         if (iopmp->reg_file.hwcfg2.stall_en) {
             iopmp->reg_file.mdstall.exempt = mdstall_temp.exempt;
             iopmp->reg_file.mdstall.md     = mdstall_temp.md;
-            rrid_stall_update(iopmp, iopmp->reg_file.mdstall.exempt);
-            if ((mdstall_temp.raw == 0) && (iopmp->reg_file.mdstall.raw == 0)) {
-                // The stalled transactions are resumed. If IOPMP implements a
-                // stall buffer, IOPMP flushes all the stalled transactions in
-                // the buffer. The reference model just zerorize the counter to
-                // simulate this behavior.
-                if (iopmp->imp_stall_buffer) {
-                    iopmp->stall_cntr = 0;
-                }
+            iopmp->program.pending |= DEFER_RRID_STALL;
+            // The transactions of the resumed RRIDs leave the stall buffer
+            if (iopmp->imp_stall_buffer) {
+                iopmp->program.pending |= DEFER_STALL_REPLAY;
             }
         }
         if (num_bytes == 4) break;
+    }
+    // fall through
+
+    case MDSTALLH_OFFSET: {
+        mdstallh_t mdstallh_temp = { .raw = upr_data4 & dec->mdh_mask };
 
-    case MDSTALLH_OFFSET:
         if (iopmp->reg_file.hwcfg2.stall_en) {
+            // The stall status follows MDSTALLH from the next MDSTALL write
+            program_flush(iopmp, DEFER_RRID_STALL);
             iopmp->reg_file.mdstallh.mdh = mdstallh_temp.mdh;
         }
         break;
+    }
 
-    case RRIDSCP_OFFSET:
+    case RRIDSCP_OFFSET: {
+        rridscp_t rridscp_temp = { .raw = lwr_data4 };
+
+        rridscp_temp.op = (lwr_data4 >> 30) & MASK_BIT_POS(2);
         if (iopmp->imp_rridscp) {
+            // RRIDSCP updates the stall status of the last MDSTALL write
+            program_flush(iopmp, DEFER_RRID_STALL);
             iopmp->reg_file.rridscp.rsv = 0;
             iopmp->reg_file.rridscp.op  = rridscp_temp.op;
 
             if (rridscp_temp.rrid < iopmp->reg_file.hwcfg1.rrid_num) {
                 iopmp->reg_file.rridscp.rrid = rridscp_temp.rrid;
-                if (iopmp->rridscp_unselectable[rridscp_temp.rrid]) {
+                if (BITSET_GET(iopmp->rridscp_unselectable, rridscp_temp.rrid)) {
                     iopmp->reg_file.rridscp.stat = 3;   // Unselectable RRID
                     break;
                 }
@@ -640,15 +712,20 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
                 switch (rridscp_temp.op) {
                 case 0: // Query
                     // Query stalled state from rrid_stall
-                    iopmp->reg_file.rridscp.stat = 2 - iopmp->rrid_stall[rridscp_temp.rrid];
+                    iopmp->reg_file.rridscp.stat = 2 - BITSET_GET(iopmp->rrid_stall, rridscp_temp.rrid);
                     break;
                 case 1: // Stall transactions associated with selected RRID
-                    iopmp->rrid_stall[rridscp_temp.rrid] = 1;
+                    CHECKPOINT_DIRTY(iopmp, iopmp->rrid_stall, rridscp_temp.rrid / 64, 1);
+                    BITSET_SET(iopmp->rrid_stall, rridscp_temp.rrid);
                     iopmp->reg_file.rridscp.stat = 1;   // Set stat as stalled
                     break;
                 case 2: // Don't stall transactions associated with selected RRID
-                    iopmp->rrid_stall[rridscp_temp.rrid] = 0;
+                    CHECKPOINT_DIRTY(iopmp, iopmp->rrid_stall, rridscp_temp.rrid / 64, 1);
+                    BITSET_CLR(iopmp->rrid_stall, rridscp_temp.rrid);
                     iopmp->reg_file.rridscp.stat = 2;   // Set stat as not stalled
+                    if (iopmp->imp_stall_buffer) {
+                        iopmp->program.pending |= DEFER_STALL_REPLAY;
+                    }
                     break;
                 default:// Write op=3
                     break;
@@ -658,22 +735,32 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
             }
         }
         break;
+    }
+
+    case MDLCK_OFFSET: {
+        mdlck_t mdlck_temp = { .raw = lwr_data4 };
 
-    case MDLCK_OFFSET:
         if (iopmp->imp_mdlck && !iopmp->reg_file.mdlck.l) {
             iopmp->reg_file.mdlck.l  |= mdlck_temp.l;
             iopmp->reg_file.mdlck.md |= mdlck_temp.md;
         }
         if (num_bytes) break;
+    }
+    // fall through
+
+    case MDLCKH_OFFSET: {
+        mdlckh_t mdlckh_temp = { .raw = upr_data4 };
 
-    case MDLCKH_OFFSET:
         if (iopmp->imp_mdlck && (iopmp->reg_file.hwcfg0.md_num > 31) &&
             !iopmp->reg_file.mdlck.l) {
             iopmp->reg_file.mdlckh.mdh |= mdlckh_temp.mdh;
         }
         break;
+    }
+
+    case MDCFGLCK_OFFSET: {
+        mdcfglck_t mdcfglck_temp = { .raw = lwr_data4 };
 
-    case MDCFGLCK_OFFSET:
         if (iopmp->reg_file.hwcfg3.mdcfg_fmt == 0) {
             if (!iopmp->reg_file.mdcfglck.l) {
                 iopmp->reg_file.mdcfglck.l |= mdcfglck_temp.l;
@@ -684,8 +771,11 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
             }
         }
         break;
+    }
+
+    case ENTRYLCK_OFFSET: {
+        entrylck_t entrylck_temp = { .raw = upr_data4 };
 
-    case ENTRYLCK_OFFSET:
         if (!iopmp->reg_file.entrylck.l) {
             iopmp->reg_file.entrylck.l |= entrylck_temp.l;
             if (entrylck_temp.f > iopmp->reg_file.entrylck.f) {
@@ -695,8 +785,11 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
         }
         iopmp->reg_file.entrylck.rsv = 0;
         break;
+    }
+
+    case ERR_CFG_OFFSET: {
+        err_cfg_t err_cfg_temp = { .raw = lwr_data4 };
 
-    case ERR_CFG_OFFSET:
         if (!iopmp->reg_file.err_cfg.l) {
             iopmp->reg_file.err_cfg.l                 |= err_cfg_temp.l;
             iopmp->reg_file.err_cfg.ie                 = err_cfg_temp.ie;
@@ -712,14 +805,18 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
             iopmp->reg_file.err_cfg.rsv2               = 0;
         }
         break;
+    }
+
+    case ERR_INFO_OFFSET: {
+        err_info_t err_info_temp = { .raw = upr_data4 };
 
-    case ERR_INFO_OFFSET:
         if (!iopmp->reg_file.hwcfg0.no_err_rec) {
             iopmp->reg_file.err_info.v        &= ~err_info_temp.v;
             iopmp->reg_file.err_info.msi_werr &= ~err_info_temp.msi_werr;
             iopmp->reg_file.err_info.rsv       = 0;
         }
         break;
+    }
 
     case ERR_REQADDR_OFFSET:
         /* Read-only */
@@ -733,16 +830,19 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
         /* Read-only */
         return;
 
-    case ERR_MFR_OFFSET:
+    case ERR_MFR_OFFSET: {
+        err_mfr_t err_mfr_temp = { .raw = upr_data4 };
+
         if (iopmp->reg_file.hwcfg2.mfr_en) {
             iopmp->reg_file.err_mfr.svi = err_mfr_temp.svi;
         }
         break;
+    }
 
     case ERR_MSIADDR_OFFSET:
         if (iopmp->reg_file.hwcfg2.msi_en) {
             iopmp->reg_file.err_msiaddr.raw = (!iopmp->reg_file.err_cfg.l) ?
-                                              err_msiaddr_temp.raw :
+                                              lwr_data4 :
                                               iopmp->reg_file.err_msiaddr.raw;
         }
         break;
@@ -750,7 +850,7 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
     case ERR_MSIADDRH_OFFSET:
         if (iopmp->reg_file.hwcfg2.msi_en && iopmp->reg_file.hwcfg0.addrh_en) {
             iopmp->reg_file.err_msiaddrh.raw = (!iopmp->reg_file.err_cfg.l) ?
-                                               err_msiaddrh_temp.raw :
+                                               upr_data4 :
                                                iopmp->reg_file.err_msiaddrh.raw;
         }
         break;
@@ -768,200 +868,409 @@ void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8
     default:
         break;
     }
+}
 
-    if (is_access_mdcfg_table(iopmp, offset)) {
-        uint32_t mdcfg_idx = MDCFG_TABLE_INDEX(offset);
+/**
+ * @brief Writes MDCFG(m) of the MDCFG table.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param mdcfg_idx The index m of the register.
+ * @param data It contains the data that need to be written.
+ */
+static void write_mdcfg(iopmp_dev_t *iopmp, uint32_t mdcfg_idx, reg_intf_dw data)
+{
+    mdcfg_t mdcfg_temp = { .raw = data };
 
-        // MDCFG(m) is locked for m < MDCFGLCK.f
-        if (mdcfg_idx >= iopmp->reg_file.mdcfglck.f) {
-            iopmp->reg_file.mdcfg[mdcfg_idx].t = mdcfg_temp.t;
-            iopmp->reg_file.mdcfg[mdcfg_idx].rsv = 0;
+    // MDCFG(m) is locked for m < MDCFGLCK.f
+    if (mdcfg_idx >= iopmp->reg_file.mdcfglck.f) {
+        iopmp->reg_file.mdcfg[mdcfg_idx].t = mdcfg_temp.t;
+        iopmp->reg_file.mdcfg[mdcfg_idx].rsv = 0;
 
-            if (iopmp->reg_file.hwcfg0.enable) {
-                handle_mdcfg_improper_settings(iopmp);
-            }
+        // The table is proper while HWCFG0.enable is set
+        if (iopmp->reg_file.hwcfg0.enable) {
+            handle_mdcfg_improper_settings(iopmp, mdcfg_idx);
         }
+        iopmp->program.pending |= DEFER_MD_SPANS;
+    }
+}
+
+/**
+ * @brief Writes a register of the SRCMD table in SRCMD table format 0.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param acc The SRCMD(s) and register within it.
+ * @param lwr_data4 The lower 32 bits of the data.
+ * @param upr_data4 The upper 32 bits of the data.
+ * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
+ */
+static void write_srcmd_fmt0(iopmp_dev_t *iopmp, const reg_access_t *acc, uint32_t lwr_data4,
+                             uint32_t upr_data4, uint8_t num_bytes)
+{
+    srcmd_table_t *srcmd = &iopmp->iopmp_srcmds.srcmd_table[acc->idx];
+    // The lower registers hold bit 0 of SRCMD_EN or a reserved bit
+    uint32_t md  = lwr_data4 & iopmp->reg_decode.md_mask;
+    uint32_t mdh = upr_data4 & iopmp->reg_decode.mdh_mask;
+    srcmd_en_t  srcmd_lwr_temp = { .raw = md };
+    srcmd_enh_t srcmd_upr_temp = { .raw = mdh };
+    uint32_t lck  = iopmp->reg_file.mdlck.md;
+    uint32_t lckh = iopmp->reg_file.mdlckh.mdh;
+
+    // SRCMD(s) is locked by SRCMD_EN.l
+    if (srcmd->srcmd_en.l)
+        return;
+
+    // The stall status follows SRCMD_EN(H) from the next MDSTALL write
+    if (acc->reg <= 1)
+        program_flush(iopmp, DEFER_RRID_STALL);
+
+    switch (acc->reg) {
+    // SRCMD_EN Register
+    case 0:
+        srcmd->srcmd_en.l |= srcmd_lwr_temp.l;
+        srcmd->srcmd_en.md = (srcmd_lwr_temp.md & ~lck) | (srcmd->srcmd_en.md & lck);
+        if (num_bytes == 4) break;
+        // fall through
+
+    // SRCMD_ENH Register
+    case 1:
+        srcmd->srcmd_enh.mdh = (srcmd_upr_temp.mdh & ~lckh) | (srcmd->srcmd_enh.mdh & lckh);
+        break;
+
+    // SRCMD_R Register
+    case 2:
+        srcmd->srcmd_r.rsv = 0;
+        srcmd->srcmd_r.md  = (srcmd_lwr_temp.md & ~lck) | (srcmd->srcmd_r.md & lck);
+        if (num_bytes == 4) break;
+        // fall through
+
+    // SRCMD_RH Register
+    case 3:
+        srcmd->srcmd_rh.mdh = (srcmd_upr_temp.mdh & ~lckh) | (srcmd->srcmd_rh.mdh & lckh);
+        break;
+
+    // SRCMD_W Register
+    case 4:
+        srcmd->srcmd_w.rsv = 0;
+        srcmd->srcmd_w.md  = (srcmd_lwr_temp.md & ~lck) | (srcmd->srcmd_w.md & lck);
+        if (num_bytes == 4) break;
+        // fall through
+
+    // SRCMD_WH Register
+    case 5:
+        srcmd->srcmd_wh.mdh = (srcmd_upr_temp.mdh & ~lckh) | (srcmd->srcmd_wh.mdh & lckh);
+        break;
+
+    // SRCMD_X Register
+    case 6:
+        srcmd->srcmd_x.rsv = 0;
+        srcmd->srcmd_x.md  = (srcmd_lwr_temp.md & ~lck) | (srcmd->srcmd_x.md & lck);
+        if (num_bytes == 4) break;
+        // fall through
+
+    // SRCMD_XH Register
+    case 7:
+        srcmd->srcmd_xh.mdh = (srcmd_upr_temp.mdh & ~lckh) | (srcmd->srcmd_xh.mdh & lckh);
+        break;
+
+    default:
+        break;
+    }
+
+    CHECKPOINT_DIRTY(iopmp, iopmp->iopmp_srcmds.srcmd_table, acc->idx, 1);
+
+    // SRCMD_EN(H) determine the candidate entries of the RRID
+    if (acc->reg <= 1)
+        md_cache_update_rrid(iopmp, acc->idx);
+    else
+        md_cache_update_perms(iopmp, acc->idx);
+}
+
+/**
+ * @brief Writes a register of the SRCMD table in SRCMD table format 2.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param acc The SRCMD(m) and register within it.
+ * @param lwr_data4 The lower 32 bits of the data.
+ * @param upr_data4 The upper 32 bits of the data.
+ * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
+ */
+static void write_srcmd_fmt2(iopmp_dev_t *iopmp, const reg_access_t *acc, uint32_t lwr_data4,
+                             uint32_t upr_data4, uint8_t num_bytes)
+{
+    srcmd_table_t *srcmd = &iopmp->iopmp_srcmds.srcmd_table[acc->idx];
+    srcmd_perm_t  srcmd_perm_temp  = { .raw = lwr_data4 };
+    srcmd_permh_t srcmd_permh_temp = { .raw = upr_data4 };
+    bool is_srcmd_locked;
+
+    // SRCMD(m) is locked by MDLCK(H) bit m
+    if (acc->idx < 31) {
+        is_srcmd_locked = (iopmp->reg_file.mdlck.md >> acc->idx) & 1;
+    } else {
+        is_srcmd_locked = (iopmp->reg_file.mdlckh.mdh >> (acc->idx - 31)) & 1;
+    }
+    if (is_srcmd_locked)
+        return;
+
+    switch (acc->reg) {
+    // SRCMD_PERM Register
+    case 0:
+        srcmd->srcmd_perm.perm = srcmd_perm_temp.perm;
+        if (num_bytes == 4) break;
+        // fall through
+
+    // SRCMD_PERMH Register
+    case 1:
+        srcmd->srcmd_permh.permh = srcmd_permh_temp.permh;
+        break;
+
+    default:
+        break;
     }
+    CHECKPOINT_DIRTY(iopmp, iopmp->iopmp_srcmds.srcmd_table, acc->idx, 1);
+    md_cache_update_perms(iopmp, acc->idx);
+}
 
-    // Code block for handling SRCMD table accesses for SRCMD Table Format 0
-    if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0) {
-        bool srcmd_tbl_access = false;
-        bool is_srcmd_locked = false;   // Initialize as unlocked
+/**
+ * @brief Writes a register of the entry array.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param acc The entry and register within it.
+ * @param lwr_data4 The lower 32 bits of the data.
+ * @param upr_data4 The upper 32 bits of the data.
+ * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
+ */
+static void write_entry(iopmp_dev_t *iopmp, const reg_access_t *acc, uint32_t lwr_data4,
+                        uint32_t upr_data4, uint8_t num_bytes)
+{
+    uint32_t entry_idx = acc->idx;
+    entry_table_t *entry = &iopmp->iopmp_entries.entry_table[entry_idx];
+
+    // Entry i is locked for i < ENTRYLCK.f
+    if (entry_idx < iopmp->reg_file.entrylck.f)
+        return;
 
-        srcmd_tbl_access = is_access_srcmd_table(iopmp, offset);
-        if (srcmd_tbl_access) {
-            is_srcmd_locked = iopmp->reg_file.srcmd_table[SRCMD_TABLE_INDEX(offset)].srcmd_en.l;
+    switch (acc->reg) {
+    // Entry Addr Register
+    case 0:
+        entry->entry_addr.addr = lwr_data4;
+        if ((num_bytes == 4) || !iopmp->reg_file.hwcfg0.addrh_en) break;
+        // fall through
+
+    // Entry Addrh Register
+    case 1:
+        if (iopmp->reg_file.hwcfg0.addrh_en) {
+            entry->entry_addrh.addrh = upr_data4;
         }
+        break;
 
-        // Proceed only if within access range and not locked
-        if (srcmd_tbl_access && !is_srcmd_locked) {
-            uint32_t srcmd_reg = SRCMD_REG_INDEX(offset);
-            uint32_t srcmd_idx = SRCMD_TABLE_INDEX(offset);
-
-            switch (srcmd_reg) {
-            // SRCMD_EN Register
-            case 0:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_en.l |= srcmd_en_temp.l;
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_en.md =
-                    (srcmd_en_temp.md & ~iopmp->reg_file.mdlck.md) |
-                    (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_en.md & iopmp->reg_file.mdlck.md);
-                if (num_bytes == 4) break;
-
-            // SRCMD_ENH Register
-            case 1:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_enh.mdh =
-                    ((srcmd_enh_temp.mdh & ~iopmp->reg_file.mdlckh.mdh) |
-                     (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_enh.mdh & iopmp->reg_file.mdlckh.mdh));
-                break;
-
-            // SRCMD_R Register
-            case 2:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_r.rsv = 0;
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_r.md =
-                    (srcmd_r_temp.md & ~iopmp->reg_file.mdlck.md) |
-                    (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_r.md & iopmp->reg_file.mdlck.md);
-                if (num_bytes == 4) break;
-
-            // SRCMD_RH Register
-            case 3:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_rh.mdh =
-                    ((srcmd_rh_temp.mdh & ~iopmp->reg_file.mdlckh.mdh) |
-                     (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_rh.mdh & iopmp->reg_file.mdlckh.mdh));
-                break;
-
-            // SRCMD_W Register
-            case 4:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_w.rsv = 0;
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_w.md =
-                    (srcmd_w_temp.md & ~iopmp->reg_file.mdlck.md) |
-                    (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_w.md & iopmp->reg_file.mdlck.md);
-                if (num_bytes == 4) break;
-
-            // SRCMD_WH Register
-            case 5:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_wh.mdh =
-                    ((srcmd_wh_temp.mdh & ~iopmp->reg_file.mdlckh.mdh) |
-                     (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_wh.mdh & iopmp->reg_file.mdlckh.mdh));
-                break;
-
-            // SRCMD_X Register
-            case 6:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_x.rsv = 0;
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_x.md =
-                    (srcmd_x_temp.md & ~iopmp->reg_file.mdlck.md) |
-                    (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_x.md & iopmp->reg_file.mdlck.md);
-                if (num_bytes == 4) break;
-
-            // SRCMD_XH Register
-            case 7:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_xh.mdh =
-                    ((srcmd_xh_temp.mdh & ~iopmp->reg_file.mdlckh.mdh) |
-                     (iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_xh.mdh & iopmp->reg_file.mdlckh.mdh));
-                break;
-
-            default:
-                break;
+    // Entry Cfg Register
+    case 2: {
+        entry_cfg_t entry_cfg_temp = { .raw = lwr_data4 };
+
+        entry->entry_cfg.r = entry_cfg_temp.r;
+        entry->entry_cfg.w = entry_cfg_temp.w;
+        entry->entry_cfg.x = entry_cfg_temp.x;
+        if (entry_cfg_temp.a == IOPMP_TOR) {
+            // ENTRY_CFG.A is WARL, check tor_en before writing.
+            if (iopmp->reg_file.hwcfg0.tor_en) {
+                entry->entry_cfg.a = entry_cfg_temp.a;
+            }
+        } else if (entry_cfg_temp.a == IOPMP_NA4) {
+            // ENTRY_CFG.A is WARL, check granularity before writing.
+            if (iopmp->granularity == MIN_GRANULARITY) {
+                entry->entry_cfg.a = entry_cfg_temp.a;
             }
+        } else {
+            // Always legal to set OFF or NAPOT
+            entry->entry_cfg.a = entry_cfg_temp.a;
         }
-    // Code block for handling SRCMD table accesses for SRCMD Table Format 2
-    } else if (iopmp->reg_file.hwcfg3.srcmd_fmt == 2) {
-        bool srcmd_tbl_access = false;
-        bool is_srcmd_locked = false;   // Initialize as unlocked
 
-        srcmd_tbl_access = is_access_srcmd_table(iopmp, offset);
-        if (srcmd_tbl_access) {
-            int table_index = SRCMD_TABLE_INDEX(offset);
+        // Interrupt suppression bits are writeable, only if interrupt suppression is supported
+        if (iopmp->reg_file.hwcfg2.peis){
+            entry->entry_cfg.sire = entry_cfg_temp.sire;
+            entry->entry_cfg.siwe = entry_cfg_temp.siwe;
+            entry->entry_cfg.sixe = entry_cfg_temp.sixe;
+        }
 
-            if (table_index < 31) {
-                is_srcmd_locked = (iopmp->reg_file.mdlck.md >> table_index) & 1;
-            } else {
-                is_srcmd_locked = (iopmp->reg_file.mdlckh.mdh >> (table_index - 31)) & 1;
-            }
+        // Error suppression bits are writeable, only if error suppression is supported
+        if (iopmp->reg_file.hwcfg2.pees) {
+            entry->entry_cfg.sere = entry_cfg_temp.sere;
+            entry->entry_cfg.sewe = entry_cfg_temp.sewe;
+            entry->entry_cfg.sexe = entry_cfg_temp.sexe;
         }
+        entry->entry_cfg.rsv = 0;
+        break;
+    }
 
-        // Proceed only if within access range and not locked
-        if (srcmd_tbl_access && !is_srcmd_locked) {
-            uint32_t srcmd_reg = SRCMD_REG_INDEX(offset);
-            uint32_t srcmd_idx = SRCMD_TABLE_INDEX(offset);
+    case 3: {
+        entry_user_cfg_t entry_user_cfg_temp = { .raw = upr_data4 };
 
-            switch (srcmd_reg) {
-            // SRCMD_PERM Register
-            case 0:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_perm.perm = srcmd_perm_temp.perm;
-                if (num_bytes == 4) break;
+        entry->entry_user_cfg.im = entry_user_cfg_temp.im;
+        break;
+    }
+    default:
+        break;
+    }
 
-            // SRCMD_PERMH Register
-            case 1:
-                iopmp->reg_file.srcmd_table[srcmd_idx].srcmd_permh.permh = srcmd_permh_temp.permh;
-                break;
+    CHECKPOINT_DIRTY(iopmp, iopmp->iopmp_entries.entry_table, entry_idx, 1);
 
-            default:
-                break;
-            }
-        }
+    // Keep the decoded entry in sync. The address of this entry is
+    // also the start address of the next entry in TOR mode.
+    entry_cache_load(iopmp, entry_idx);
+    entry_cache_update(iopmp, entry_idx);
+    if ((acc->reg <= 1) && (entry_idx + 1 < iopmp->reg_file.hwcfg1.entry_num)) {
+        entry_cache_update(iopmp, entry_idx + 1);
     }
+}
+
+/**
+ * @brief Writes data to a memory-mapped register identified by the specified offset.
+ *
+ * The data type `reg_intf_dw` depends on the configuration in the `config.h` file
+ *  (e.g., `uint32_t` for 4-byte width, `uint64_t` for 8-byte width).
+ *
+ * @param iopmp The IOPMP instance.
+ * @param offset The offset of the register to be written.
+ * @param data It contains the data that need to be written.
+ * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
+ *
+ */
+static void write_register_locked(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8_t num_bytes) {
+    reg_access_t acc;
+    uint8_t cls = reg_decode(iopmp, offset, num_bytes, &acc);
 
-    if (is_access_entry_array(iopmp, offset)) {
-        uint32_t entry_reg = ENTRY_REG_INDEX(iopmp, offset);
-        uint32_t entry_idx = ENTRY_TABLE_INDEX(iopmp, offset);
+#if (TRACE_EN == 1)
+    if (iopmp->trace)
+        trace_record_reg(iopmp, IOPMP_TRACE_WRITE, offset, data, num_bytes);
+#endif
 
-        if (entry_idx >= iopmp->reg_file.entrylck.f) {
-            switch (entry_reg)
-            {
-                // Entry Addr Register
-                case 0:
-                    iopmp->iopmp_entries.entry_table[entry_idx].entry_addr.addr = entry_addr_temp.addr;
-                    if ((num_bytes == 4) || !iopmp->reg_file.hwcfg0.addrh_en) break;
+  // Extract lower and upper 32-bits of data based on bus width
+    uint32_t lwr_data4, upr_data4;
+#if (REG_INTF_BUS_WIDTH == 8)
+    lwr_data4 = data & UINT32_MAX;
+    upr_data4 = (data >> 32) & UINT32_MAX;  // Using 32 bits for upper part
+#else
+    lwr_data4 = data;
+    upr_data4 = data;         // Upper part is same as lower part
+#endif
 
-                // Entry Addrh Register
-                case 1:
-                    if (iopmp->reg_file.hwcfg0.addrh_en) {
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_addrh.addrh = entry_addrh_temp.addrh;
-                    }
-                    break;
+    if (cls == REG_CLASS_NONE) return;
 
-                // Entry Cfg Register
-                case 2:
-                    iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.r = entry_cfg_temp.r;
-                    iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.w = entry_cfg_temp.w;
-                    iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.x = entry_cfg_temp.x;
-                    if (entry_cfg_temp.a == IOPMP_TOR) {
-                        // ENTRY_CFG.A is WARL, check tor_en before writing.
-                        if (iopmp->reg_file.hwcfg0.tor_en) {
-                            iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.a = entry_cfg_temp.a;
-                        }
-                    } else if (entry_cfg_temp.a == IOPMP_NA4) {
-                        // ENTRY_CFG.A is WARL, check granularity before writing.
-                        if (iopmp->granularity == MIN_GRANULARITY) {
-                            iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.a = entry_cfg_temp.a;
-                        }
-                    } else {
-                        // Always legal to set OFF or NAPOT
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.a = entry_cfg_temp.a;
-                    }
+    if (!(cls & REG_KEEPS_DECISIONS)) {
+        iopmp->program.pending |= DEFER_DECISIONS;
+    }
 
-                    // Interrupt suppression bits are writeable, only if interrupt suppression is supported
-                    if (iopmp->reg_file.hwcfg2.peis){
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.sire = entry_cfg_temp.sire;
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.siwe = entry_cfg_temp.siwe;
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.sixe = entry_cfg_temp.sixe;
-                    }
+    switch (REG_CLASS(cls)) {
+    case REG_CLASS_CTRL:
+        write_ctrl_register(iopmp, offset, lwr_data4, upr_data4, num_bytes);
+        break;
 
-                    // Error suppression bits are writeable, only if error suppression is supported
-                    if (iopmp->reg_file.hwcfg2.pees) {
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.sere = entry_cfg_temp.sere;
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.sewe = entry_cfg_temp.sewe;
-                        iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.sexe = entry_cfg_temp.sexe;
-                    }
-                    iopmp->iopmp_entries.entry_table[entry_idx].entry_cfg.rsv = 0;
-                    break;
+    case REG_CLASS_MDCFG:
+        write_mdcfg(iopmp, acc.idx, data);
+        break;
 
-                case 3:
-                    iopmp->iopmp_entries.entry_table[entry_idx].entry_user_cfg.im = entry_user_cfg_temp.im;
-                    break;
-                default:
-                    break;
-            }
-        }
+    case REG_CLASS_SRCMD:
+        // SRCMD table format 1 doesn't implement SRCMD table
+        if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0)
+            write_srcmd_fmt0(iopmp, &acc, lwr_data4, upr_data4, num_bytes);
+        else if (iopmp->reg_file.hwcfg3.srcmd_fmt == 2)
+            write_srcmd_fmt2(iopmp, &acc, lwr_data4, upr_data4, num_bytes);
+        break;
+
+    case REG_CLASS_ENTRY:
+        write_entry(iopmp, &acc, lwr_data4, upr_data4, num_bytes);
+        break;
+
+    default:
+        break;
     }
+
+    if (!iopmp->program.active)
+        program_flush(iopmp, DEFER_ALL);
+}
+
+/**
+ * @brief Writes data to a memory-mapped register identified by the specified offset.
+ *
+ * It may be called while other threads check transactions. It waits for the
+ * checks in progress, and the checks started later see the new value, see
+ * iopmp_epoch.c. See write_register_locked() for the register semantics.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param offset The offset of the register to be written.
+ * @param data It contains the data that need to be written.
+ * @param num_bytes The number of bytes to write (either 4 or 8 bytes).
+ *
+ */
+void write_register(iopmp_dev_t *iopmp, uint64_t offset, reg_intf_dw data, uint8_t num_bytes) {
+    // The session of the calling thread already holds the write section
+    if (program_thread_session == iopmp) {
+        write_register_locked(iopmp, offset, data, num_bytes);
+        return;
+    }
+
+    epoch_write_enter(iopmp);
+    write_register_locked(iopmp, offset, data, num_bytes);
+    epoch_write_exit(iopmp);
+}
+
+/**
+ * @brief Writes consecutive registers starting at the specified offset.
+ *
+ * The registers are written in order, each with \p num_bytes bytes of
+ * \p data. The derived state is updated once after the last write, see
+ * iopmp_program_begin(), and the result is identical to calling
+ * write_register() for each of them.
+ *
+ * @param iopmp The IOPMP instance.
+ * @param offset The offset of the first register to be written.
+ * @param data The data of each register.
+ * @param count The number of registers to write.
+ * @param num_bytes The number of bytes of each write (either 4 or 8 bytes).
+ */
+void write_register_block(iopmp_dev_t *iopmp, uint64_t offset, const reg_intf_dw *data,
+                          size_t count, uint8_t num_bytes) {
+    bool in_session = (program_thread_session == iopmp);
+
+    if (!in_session)
+        iopmp_program_begin(iopmp);
+    for (size_t i = 0; i < count; i++) {
+        write_register_locked(iopmp, offset + (i * num_bytes), data[i], num_bytes);
+    }
+    if (!in_session)
+        iopmp_program_commit(iopmp);
+}
+
+/**
+ * @brief Starts a programming session of an IOPMP instance.
+ *
+ * Register writes of the calling thread in the session keep the register
+ * semantics, but the updates of derived state (MD spans, non-priority entry
+ * index, RRID stall status, transaction checker and decision cache) run once
+ * at iopmp_program_commit(). The registers after the commit are identical
+ * to writing them outside a session.
+ *
+ * Transaction checks and register accesses of other threads wait until the
+ * session is committed, and the calling thread must not check transactions
+ * in the session. Sessions don't nest, and reset_iopmp(),
+ * iopmp_checkpoint() and iopmp_restore() must not be called in a session.
+ *
+ * @param iopmp The IOPMP instance.
+ */
+void iopmp_program_begin(iopmp_dev_t *iopmp) {
+    epoch_write_enter(iopmp);
+    iopmp->program.active  = true;
+    program_thread_session = iopmp;
+}
+
+/**
+ * @brief Commits the programming session of an IOPMP instance.
+ *
+ * @param iopmp The IOPMP instance.
+ */
+void iopmp_program_commit(iopmp_dev_t *iopmp) {
+    program_flush(iopmp, DEFER_ALL);
+    iopmp->program.active  = false;
+    program_thread_session = NULL;
+    epoch_write_exit(iopmp);
 }
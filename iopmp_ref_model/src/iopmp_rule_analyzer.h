@@ -0,0 +1,166 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Author: Yazan Hussnain (yazan.hussain@10xengineers.ai)
+//         Gull Ahmed (gull.ahmed@10xengineers.ai)
+// Date: October 21, 2024
+// Description:
+// This file implements the IOPMP (I/O Physical Memory Protection)
+// Permission Check for RISC-V systems. It contains functions to compute
+// and validate address ranges, match transaction requests against IOPMP
+// entries, and enforce access permissions (Read, Write, Execute) based
+// on the IOPMP configuration and hardware restrictions. The IOPMP
+// protects memory regions for peripheral accesses, ensuring only
+// authorized transactions occur within specified address ranges and
+// permissions.
+//
+// This file is a template included by iopmp_validate_tmpl.h. The CHK_*
+// macros select the SRCMD table format and the features the functions are
+// specialized for, and CHK_FN() names them (see iopmp_validate.c).
+//
+// The main functions in this file include:
+// - iopmpMatchAddr: Matches transaction request addresses against the
+//   decoded byte range of an IOPMP entry (see iopmp_cache.c).
+// - iopmpCheckPerms: Verifies permissions against the IOPMP entry
+//   configuration and Requestor Role ID (RRID) to allow or deny access.
+// - iopmpRuleAnalyzer: Analyzes IOPMP rules to determine if a transaction
+//   matches an entry and has the required permissions, considering
+//   priority and configuration-specific conditions.
+//
+***************************************************************************/
+
+/**
+  * @brief Determine the matching status of transaction request address against IOPMP entry range.
+  *
+  * @param trans_start Start address of the transaction
+  * @param trans_end End address of the transaction
+  * @param lo Lower bound of the IOPMP range
+  * @param hi Upper bound of the IOPMP range
+  * @return iopmpMatchStatus_t Status of the match:
+  *         - ENTRY_MATCH: Entry matches all bytes of a transaction
+  *         - ENTRY_PARTIAL_MATCH: Entry matches partial bytes of a transation
+  *         - ENTRY_NOTMATCH: Entry doesn't cover any byte of the transaction
+ **/
+static inline iopmpMatchStatus_t CHK_FN(iopmpMatchAddr)(uint64_t trans_start,
+                                                        uint64_t trans_end,
+                                                        uint64_t lo, uint64_t hi) {
+    // Validate range
+    if (hi < lo) { return ENTRY_NOTMATCH; }  // Invalid range, no match
+
+    // Check if transaction falls outside the IOPMP entry range
+    if (trans_end <= lo || trans_start >= hi) { return ENTRY_NOTMATCH; } // No match, transaction outside range
+
+    // Determine if there's a full match
+    if (trans_start >= lo && trans_end <= hi) { return ENTRY_MATCH; }
+
+    return ENTRY_PARTIAL_MATCH;
+}
+
+/**
+  * @brief Checks IOPMP permissions based on request and configuration of a fully matching entry
+  *
+  * @param iopmp The IOPMP instance.
+  * @param rrid Requestor Role ID
+  * @param req_perm Requested permission type (Read, Write, Execute)
+  * @param iopmpcfg IOPMP configuration for the entry
+  * @param md Respective Memory Domain
+  * @param is_amo Indicates the AMO Access
+  * @param sie Output 0 if matched entry doesn't suppress the interrupt, otherwise output 1
+  * @param see Output 0 if matched entry doesn't suppress the bus error, otherwise output 1
+  * @return - true if entry grants transation permission
+  *         - false if entry doesn't grant transation permission
+ **/
+static inline bool CHK_FN(iopmpCheckPerms)(iopmp_dev_t *iopmp, uint16_t rrid, perm_type_e req_perm,
+                                           entry_cfg_t iopmpcfg, uint8_t md, bool is_amo,
+                                           bool *sie, bool *see) {
+    // Common permission checks
+    bool read_allowed    = false;
+    bool write_allowed   = false;
+    bool execute_allowed = false;
+
+    if (CHK_SRCMD_FMT == 0) {
+        uint8_t  srcmd_r_bit, srcmd_w_bit, srcmd_x_bit;
+        // SRCMD_{R,W,X}(H) of the RRID, see md_cache_update_perms()
+        srcmd_r_bit = GET_BIT(iopmp->md_cache.rrid_r_mds[rrid], md);
+        srcmd_w_bit = GET_BIT(iopmp->md_cache.rrid_w_mds[rrid], md);
+        srcmd_x_bit = GET_BIT(iopmp->md_cache.rrid_x_mds[rrid], md);
+
+        // CHK_SPS_EN: Software privilege separation enable
+        read_allowed    = CHK_SPS_EN ? (iopmpcfg.r & srcmd_r_bit) : iopmpcfg.r;
+        write_allowed   = CHK_SPS_EN ? (iopmpcfg.w & srcmd_w_bit & ((iopmpcfg.r & srcmd_r_bit) | !is_amo)) : (iopmpcfg.w & (iopmpcfg.r | !is_amo));
+        execute_allowed = CHK_SPS_EN ? (iopmpcfg.x & srcmd_x_bit) : iopmpcfg.x;
+    } else if (CHK_SRCMD_FMT == 1) {
+        read_allowed    = iopmpcfg.r;
+        write_allowed   = (iopmpcfg.w & (iopmpcfg.r | !is_amo));
+        execute_allowed = iopmpcfg.x;
+    } else if (CHK_SRCMD_FMT == 2) {
+        uint8_t  srcmd_perm_r, srcmd_perm_w;
+        // SRCMD_PERM(H) of the MD, see md_cache_update_perms()
+        srcmd_perm_r = GET_BIT(iopmp->md_cache.rrid_r_mds[rrid], md);
+        srcmd_perm_w = GET_BIT(iopmp->md_cache.rrid_w_mds[rrid], md);
+
+        read_allowed    = iopmpcfg.r || srcmd_perm_r;
+        write_allowed   = ((iopmpcfg.w || srcmd_perm_w) & ((iopmpcfg.r || srcmd_perm_r) | !is_amo));
+        execute_allowed = (iopmpcfg.x || srcmd_perm_r);
+    }
+
+    // Handle requested permission type
+    switch (req_perm) {
+    case READ_ACCESS:
+        if (!read_allowed) {
+            *sie = CHK_PEIS ? iopmpcfg.sire : false;
+            *see = CHK_PEES ? iopmpcfg.sere : false;
+        }
+        return read_allowed;
+
+    case WRITE_ACCESS:
+        if (!write_allowed) {
+            *sie = CHK_PEIS ? iopmpcfg.siwe : false;
+            *see = CHK_PEES ? iopmpcfg.sewe : false;
+        }
+        return write_allowed;
+
+    case INSTR_FETCH:
+        if (!iopmp->reg_file.hwcfg3.xinr) {
+            if (!execute_allowed) {
+                *sie = CHK_PEIS ? iopmpcfg.sixe : false;
+                *see = CHK_PEES ? iopmpcfg.sexe : false;
+            }
+            return execute_allowed;
+        }
+        return false;   // Instruction fetch check not implemented
+
+    default:
+        return false;   // Default case for invalid permission request
+    }
+}
+
+/**
+  * @brief Analyze the matching status and permissions of a transaction request
+  *
+  * @param iopmp The IOPMP instance.
+  * @param input All the information the analyzer needs.
+  * @param output Address matching status and permission grant result.
+ **/
+static inline void CHK_FN(iopmpRuleAnalyzer)(iopmp_dev_t *iopmp,
+                                             iopmp_rule_analyzer_input_t *input,
+                                             iopmp_rule_analyzer_output_t *output)
+{
+    // Match transaction address to the decoded IOPMP byte range. A disabled
+    // entry is decoded as an inverted range and never matches.
+    output->match_status = CHK_FN(iopmpMatchAddr)(input->trans_start, input->trans_end,
+                                                  input->lo, input->hi);
+    if (output->match_status == ENTRY_NOTMATCH ||
+        output->match_status == ENTRY_PARTIAL_MATCH) {
+        // It's unnecessary to check entry permissions in these two cases
+        return;
+    }
+
+    // iopmpMatchAddr() returns ENTRY_MATCH. Further checks entry permissions
+    output->grant_perm = CHK_FN(iopmpCheckPerms)(iopmp, input->rrid, input->perm,
+                                                 input->iopmpcfg, input->md,
+                                                 input->is_amo,
+                                                 &output->sie, &output->see);
+}
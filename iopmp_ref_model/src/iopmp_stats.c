@@ -0,0 +1,231 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Hit Counters
+// With HIT_STATS_EN set, the transaction checks count, per entry, the
+// transactions it matches and whether it grants them, and, per RRID, the
+// transactions checked, the entries scanned before the deciding entry and
+// the MDs visited. The counters show which entries decide the transactions
+// and how deep the checks go, to reorder entries and size HWCFG2.prio_entry.
+//
+// The counters are sized for the configuration at reset, in a block of
+// their own which isn't part of a checkpoint. Concurrent checks update them
+// atomically. Without HIT_STATS_EN the checks don't touch any counter, and
+// the functions below report that there is no counter.
+//
+// The main functions in this file include:
+// - stats_reserve: Allocates the zeroized counters of a configuration.
+// - stats_release: Releases the counters.
+// - iopmp_get_entry_stats: Reads the counters of an entry.
+// - iopmp_get_rrid_stats: Reads the counters of an RRID.
+// - iopmp_clear_stats: Zeroizes all counters.
+// - iopmp_dump_stats: Writes all counters as CSV or binary.
+***************************************************************************/
+
+#include <inttypes.h>
+#include "iopmp.h"
+
+#if (HIT_STATS_EN == 1)
+
+/**
+  * @brief Allocates the zeroized counters of a configuration.
+  *
+  * The block of the instance is reused if it is large enough. It is called
+  * by reset_iopmp() after the tables are laid out.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_num The number of entries.
+  * @param rrid_num The number of RRIDs.
+  * @return 0 on success, -1 if the counters can't be allocated.
+ **/
+int stats_reserve(iopmp_dev_t *iopmp, uint32_t entry_num, uint32_t rrid_num)
+{
+    iopmp_stats_t *stats = &iopmp->stats;
+    const iopmp_allocator_t *allocator = &iopmp->storage.allocator;
+    size_t entries_size = ALIGNUP(entry_num * sizeof(entry_counters_t), 64);
+    size_t size = entries_size + (rrid_num * sizeof(iopmp_rrid_stats_t));
+
+    if (size > stats->size) {
+        if (stats->block && allocator->free)
+            allocator->free(allocator->ctx, stats->block);
+        stats->block = allocator->alloc(allocator->ctx, size, 64);
+        stats->size  = stats->block ? size : 0;
+        if (!stats->block) {
+            stats->entry_num = 0;
+            stats->rrid_num  = 0;
+            return -1;
+        }
+    }
+
+    memset(stats->block, 0, size);
+    stats->entries   = stats->block;
+    stats->rrids     = (iopmp_rrid_stats_t *)((uint8_t *)stats->block + entries_size);
+    stats->entry_num = entry_num;
+    stats->rrid_num  = rrid_num;
+    return 0;
+}
+
+/**
+  * @brief Releases the counters of an IOPMP instance.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void stats_release(iopmp_dev_t *iopmp)
+{
+    const iopmp_allocator_t *allocator = &iopmp->storage.allocator;
+
+    if (iopmp->stats.block && allocator->free)
+        allocator->free(allocator->ctx, iopmp->stats.block);
+    memset(&iopmp->stats, 0, sizeof(iopmp->stats));
+}
+
+#else
+
+int stats_reserve(iopmp_dev_t *iopmp, uint32_t entry_num, uint32_t rrid_num) { return 0; }
+void stats_release(iopmp_dev_t *iopmp) {}
+
+#endif
+
+/**
+  * @brief Reads the hit counters of an entry.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param entry_idx Index of the entry.
+  * @param stats Output counters.
+  * @return 0 on success, -1 if the entry has no counters or the model is
+  *         built without HIT_STATS_EN.
+ **/
+int iopmp_get_entry_stats(iopmp_dev_t *iopmp, uint32_t entry_idx, iopmp_entry_stats_t *stats)
+{
+#if (HIT_STATS_EN == 1)
+    const entry_counters_t *c;
+
+    if (entry_idx >= iopmp->stats.entry_num)
+        return -1;
+    c = &iopmp->stats.entries[entry_idx];
+    stats->grants   = __atomic_load_n(&c->grants, __ATOMIC_RELAXED);
+    stats->denials  = __atomic_load_n(&c->denials, __ATOMIC_RELAXED);
+    stats->partials = __atomic_load_n(&c->partials, __ATOMIC_RELAXED);
+    stats->matches  = stats->grants + stats->denials;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/**
+  * @brief Reads the scan counters of an RRID.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param rrid The RRID.
+  * @param stats Output counters.
+  * @return 0 on success, -1 if the RRID has no counters or the model is
+  *         built without HIT_STATS_EN.
+ **/
+int iopmp_get_rrid_stats(iopmp_dev_t *iopmp, uint32_t rrid, iopmp_rrid_stats_t *stats)
+{
+#if (HIT_STATS_EN == 1)
+    const iopmp_rrid_stats_t *c;
+
+    if (rrid >= iopmp->stats.rrid_num)
+        return -1;
+    c = &iopmp->stats.rrids[rrid];
+    stats->transactions    = __atomic_load_n(&c->transactions, __ATOMIC_RELAXED);
+    stats->entries_scanned = __atomic_load_n(&c->entries_scanned, __ATOMIC_RELAXED);
+    stats->mds_visited     = __atomic_load_n(&c->mds_visited, __ATOMIC_RELAXED);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/**
+  * @brief Zeroizes all hit and scan counters.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void iopmp_clear_stats(iopmp_dev_t *iopmp)
+{
+#if (HIT_STATS_EN == 1)
+    // Checks may still count, the counters are only cleared under the
+    // exclusion of a register write
+    epoch_write_enter(iopmp);
+    memset(iopmp->stats.entries, 0, iopmp->stats.entry_num * sizeof(entry_counters_t));
+    memset(iopmp->stats.rrids, 0, iopmp->stats.rrid_num * sizeof(iopmp_rrid_stats_t));
+    epoch_write_exit(iopmp);
+#endif
+}
+
+/**
+  * @brief Writes all hit and scan counters to a file.
+  *
+  * The CSV dump has a section of the entries, with the columns entry,
+  * matches, grants, denials and partials, then a section of the RRIDs, with
+  * the columns rrid, transactions, entries_scanned and mds_visited. Only the
+  * rows with a non-zero counter are written. The binary dump is described
+  * by iopmp_stats_header_t.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param file The output file.
+  * @param format The format of the dump.
+  * @return 0 on success, -1 if the file can't be written or the model is
+  *         built without HIT_STATS_EN.
+ **/
+int iopmp_dump_stats(iopmp_dev_t *iopmp, FILE *file, iopmp_stats_format_e format)
+{
+#if (HIT_STATS_EN == 1)
+    const iopmp_stats_t *stats = &iopmp->stats;
+    iopmp_entry_stats_t e;
+    iopmp_rrid_stats_t r;
+
+    if (format == IOPMP_STATS_BINARY) {
+        iopmp_stats_header_t header = {
+            .magic     = {'I', 'O', 'P', 'M', 'P', 'H', 'I', 'T'},
+            .version   = 1,
+            .entry_num = stats->entry_num,
+            .rrid_num  = stats->rrid_num,
+        };
+
+        if (fwrite(&header, sizeof(header), 1, file) != 1)
+            return -1;
+        for (uint32_t i = 0; i < stats->entry_num; i++) {
+            iopmp_get_entry_stats(iopmp, i, &e);
+            if (fwrite(&e, sizeof(e), 1, file) != 1)
+                return -1;
+        }
+        for (uint32_t i = 0; i < stats->rrid_num; i++) {
+            iopmp_get_rrid_stats(iopmp, i, &r);
+            if (fwrite(&r, sizeof(r), 1, file) != 1)
+                return -1;
+        }
+        return 0;
+    }
+
+    if (fprintf(file, "entry,matches,grants,denials,partials\n") < 0)
+        return -1;
+    for (uint32_t i = 0; i < stats->entry_num; i++) {
+        iopmp_get_entry_stats(iopmp, i, &e);
+        if (!e.matches && !e.partials)
+            continue;
+        if (fprintf(file, "%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", i, e.matches,
+                    e.grants, e.denials, e.partials) < 0)
+            return -1;
+    }
+    if (fprintf(file, "\nrrid,transactions,entries_scanned,mds_visited\n") < 0)
+        return -1;
+    for (uint32_t i = 0; i < stats->rrid_num; i++) {
+        iopmp_get_rrid_stats(iopmp, i, &r);
+        if (!r.transactions)
+            continue;
+        if (fprintf(file, "%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", i, r.transactions,
+                    r.entries_scanned, r.mds_visited) < 0)
+            return -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
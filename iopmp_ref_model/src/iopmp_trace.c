@@ -0,0 +1,315 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Trace Record and Replay
+// A trace is the register accesses and transactions of an IOPMP instance in
+// the order they happened, with the data read and the response of each
+// transaction. It captures a workload, e.g. from an SoC simulator, to replay
+// it at full speed on the model and compare the results.
+//
+// A trace is an iopmp_trace_header_t followed by fixed-size records of
+// iopmp_trace_record_t, in host byte order, so a trace file can be mapped
+// and replayed in place. The recorder hooks write_register(),
+// read_register(), iopmp_validate_access() and
+// iopmp_validate_access_batch(). Concurrent checks append their records
+// atomically, in the order they complete. Replaying a trace expects the
+// instance in the state the recording started from, e.g. reset with the
+// same configuration, so reset_iopmp() stops the recording.
+//
+// The main functions in this file include:
+// - iopmp_trace_record_start: Starts recording the instance to a file.
+// - iopmp_trace_record_stop: Stops recording and completes the header.
+// - trace_record_reg: Records a register access.
+// - trace_record_trans: Records a transaction and its response.
+// - iopmp_trace_replay: Replays a trace in memory and compares the results.
+// - iopmp_trace_replay_file: Maps a trace file and replays it.
+***************************************************************************/
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "iopmp.h"
+
+static const char trace_magic[8] = {'I', 'O', 'P', 'M', 'P', 'T', 'R', 'C'};
+
+/* Fills the record of a transaction and its response */
+static void trace_fill_trans(iopmp_trace_record_t *rec, const iopmp_trans_req_t *req,
+                             const iopmp_trans_rsp_t *rsp, uint8_t intrpt)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->kind        = IOPMP_TRACE_TRANS;
+    rec->perm        = req->perm;
+    rec->rrid        = req->rrid;
+    rec->addr        = req->addr;
+    rec->length      = req->length;
+    rec->size        = req->size;
+    rec->user        = rsp->user;
+    rec->rsp_rrid    = rsp->rrid;
+    rec->rrid_transl = rsp->rrid_transl;
+    rec->flags       = (req->is_amo ? IOPMP_TRACE_AMO : 0) |
+                       ((rsp->status == IOPMP_ERROR) ? IOPMP_TRACE_ERROR : 0) |
+                       (intrpt ? IOPMP_TRACE_INTRPT : 0) |
+                       (rsp->rrid_stalled ? IOPMP_TRACE_STALLED : 0) |
+                       (rsp->rrid_stalled_no_available_buffer ? IOPMP_TRACE_NO_BUFFER : 0);
+}
+
+#if (TRACE_EN == 1)
+
+/* Appends a record, concurrent checks append theirs atomically */
+static void trace_append(trace_recorder_t *trace, const iopmp_trace_record_t *rec)
+{
+    if (fwrite(rec, sizeof(*rec), 1, trace->file) == 1)
+        __atomic_add_fetch(&trace->num_records, 1, __ATOMIC_RELAXED);
+}
+
+/**
+  * @brief Records a register access.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param kind IOPMP_TRACE_WRITE or IOPMP_TRACE_READ.
+  * @param offset The offset of the register.
+  * @param data The data written or read.
+  * @param num_bytes The number of bytes accessed.
+ **/
+void trace_record_reg(iopmp_dev_t *iopmp, uint8_t kind, uint64_t offset, reg_intf_dw data,
+                      uint8_t num_bytes)
+{
+    iopmp_trace_record_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.kind      = kind;
+    rec.num_bytes = num_bytes;
+    rec.addr      = offset;
+    rec.data      = data;
+    trace_append(iopmp->trace, &rec);
+}
+
+/**
+  * @brief Records a transaction and its response.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param req The transaction request.
+  * @param rsp The response to the transaction.
+  * @param intrpt The wired interrupt flag of the transaction.
+ **/
+void trace_record_trans(iopmp_dev_t *iopmp, const iopmp_trans_req_t *req,
+                        const iopmp_trans_rsp_t *rsp, uint8_t intrpt)
+{
+    iopmp_trace_record_t rec;
+
+    trace_fill_trans(&rec, req, rsp, intrpt);
+    trace_append(iopmp->trace, &rec);
+}
+
+#endif
+
+/**
+  * @brief Starts recording the register accesses and transactions of an instance.
+  *
+  * The header is written at the current position of \p file, and the
+  * records after it. reset_iopmp() stops the recording as
+  * iopmp_trace_record_stop() does.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param file The output file.
+  * @return 0 on success, -1 if the instance is already recording, the
+  *         header can't be written or the model is built without TRACE_EN.
+ **/
+int iopmp_trace_record_start(iopmp_dev_t *iopmp, FILE *file)
+{
+#if (TRACE_EN == 1)
+    const iopmp_allocator_t *allocator = &iopmp->storage.allocator;
+    iopmp_trace_header_t header = {
+        .version     = 1,
+        .record_size = sizeof(iopmp_trace_record_t),
+    };
+    trace_recorder_t *trace;
+    int ret = -1;
+
+    memcpy(header.magic, trace_magic, sizeof(header.magic));
+
+    // No access is in progress while the recorder is attached
+    epoch_write_enter(iopmp);
+    if (!iopmp->trace) {
+        trace = allocator->alloc(allocator->ctx, sizeof(*trace), 64);
+        if (trace) {
+            trace->file        = file;
+            trace->header      = ftell(file);
+            trace->num_records = 0;
+            trace->allocator   = *allocator;
+            if (fwrite(&header, sizeof(header), 1, file) == 1) {
+                iopmp->trace = trace;
+                ret = 0;
+            } else if (allocator->free) {
+                allocator->free(allocator->ctx, trace);
+            }
+        }
+    }
+    epoch_write_exit(iopmp);
+    return ret;
+#else
+    return -1;
+#endif
+}
+
+/**
+  * @brief Stops recording an instance.
+  *
+  * The number of records is written in the header if \p file can seek, and
+  * the file is flushed. It isn't closed.
+  *
+  * @param iopmp The IOPMP instance.
+  * @return 0 on success, -1 if the instance isn't recording or the trace
+  *         can't be written.
+ **/
+int iopmp_trace_record_stop(iopmp_dev_t *iopmp)
+{
+#if (TRACE_EN == 1)
+    trace_recorder_t *trace;
+    long end;
+    int ret = 0;
+
+    epoch_write_enter(iopmp);
+    trace = iopmp->trace;
+    iopmp->trace = NULL;
+    epoch_write_exit(iopmp);
+    if (!trace)
+        return -1;
+
+    // A pipe can't seek, the replay counts the records up to its end then
+    end = ftell(trace->file);
+    if ((trace->header >= 0) && (end >= 0) &&
+        (fseek(trace->file, trace->header + offsetof(iopmp_trace_header_t, num_records), SEEK_SET) == 0)) {
+        if (fwrite(&trace->num_records, sizeof(trace->num_records), 1, trace->file) != 1)
+            ret = -1;
+        fseek(trace->file, end, SEEK_SET);
+    }
+    if (fflush(trace->file) || ferror(trace->file))
+        ret = -1;
+
+    if (trace->allocator.free)
+        trace->allocator.free(trace->allocator.ctx, trace);
+    return ret;
+#else
+    return -1;
+#endif
+}
+
+/**
+  * @brief Replays a trace on an instance and compares the results.
+  *
+  * Register writes are replayed as they were recorded. The data of each
+  * register read and the response and interrupt of each transaction are
+  * compared with the recorded ones.
+  *
+  * @param iopmp The IOPMP instance, in the state the recording started from.
+  * @param trace The trace, aligned to 8 bytes.
+  * @param size The size (in bytes) of the trace.
+  * @param stats Output results of the replay.
+  * @return 0 on success, -1 if the trace is malformed. \p stats holds the
+  *         records replayed before a malformed record.
+ **/
+int iopmp_trace_replay(iopmp_dev_t *iopmp, const void *trace, size_t size,
+                       iopmp_trace_replay_stats_t *stats)
+{
+    const iopmp_trace_header_t *header = trace;
+    const iopmp_trace_record_t *records;
+    struct timespec start, end;
+    uint64_t num_records;
+    int ret = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->first_mismatch = UINT64_MAX;
+    if ((size < sizeof(*header)) || memcmp(header->magic, trace_magic, sizeof(trace_magic)) ||
+        (header->version != 1) || (header->record_size != sizeof(iopmp_trace_record_t)))
+        return -1;
+
+    records     = (const iopmp_trace_record_t *)(header + 1);
+    num_records = (size - sizeof(*header)) / sizeof(iopmp_trace_record_t);
+    if (header->num_records && (header->num_records < num_records))
+        num_records = header->num_records;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t i = 0; (i < num_records) && !ret; i++) {
+        const iopmp_trace_record_t *rec = &records[i];
+        bool match = true;
+
+        switch (rec->kind) {
+        case IOPMP_TRACE_WRITE:
+            write_register(iopmp, rec->addr, (reg_intf_dw)rec->data, rec->num_bytes);
+            stats->writes++;
+            break;
+
+        case IOPMP_TRACE_READ:
+            match = (read_register(iopmp, rec->addr, rec->num_bytes) == (reg_intf_dw)rec->data);
+            stats->reads++;
+            break;
+
+        case IOPMP_TRACE_TRANS: {
+            iopmp_trans_req_t req = {
+                .rrid   = rec->rrid,
+                .addr   = rec->addr,
+                .length = rec->length,
+                .size   = rec->size,
+                .perm   = (perm_type_e)rec->perm,
+                .is_amo = !!(rec->flags & IOPMP_TRACE_AMO),
+            };
+            iopmp_trans_rsp_t rsp;
+            iopmp_trace_record_t replayed;
+            uint8_t intrpt = 0;
+
+            memset(&rsp, 0, sizeof(rsp));
+            iopmp_validate_access(iopmp, &req, &rsp, &intrpt);
+            trace_fill_trans(&replayed, &req, &rsp, intrpt);
+            match = !memcmp(&replayed, rec, sizeof(replayed));
+            stats->transactions++;
+            break;
+        }
+
+        default:
+            ret = -1;
+            break;
+        }
+
+        if (!match && !stats->mismatches++)
+            stats->first_mismatch = i;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    stats->seconds = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1e9);
+    if (stats->seconds > 0)
+        stats->trans_per_sec = stats->transactions / stats->seconds;
+    return ret;
+}
+
+/**
+  * @brief Maps a trace file and replays it, see iopmp_trace_replay().
+  *
+  * @param iopmp The IOPMP instance, in the state the recording started from.
+  * @param file The trace file, the trace starts at its beginning.
+  * @param stats Output results of the replay.
+  * @return 0 on success, -1 if the file can't be mapped or the trace is
+  *         malformed.
+ **/
+int iopmp_trace_replay_file(iopmp_dev_t *iopmp, FILE *file, iopmp_trace_replay_stats_t *stats)
+{
+    struct stat st;
+    void *trace;
+    int ret;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->first_mismatch = UINT64_MAX;
+    if (fflush(file) || fstat(fileno(file), &st) || (st.st_size < (off_t)sizeof(iopmp_trace_header_t)))
+        return -1;
+
+    trace = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (trace == MAP_FAILED)
+        return -1;
+    ret = iopmp_trace_replay(iopmp, trace, st.st_size, stats);
+    munmap(trace, st.st_size);
+    return ret;
+}
@@ -9,7 +9,12 @@
 // Description: This file contains the iopmp_validate_access function that
 // Processes the IOPMP transaction request, traversing the SRCMD and MDCFG tables
 // and entry array to match address and permissions and return the response
-// structure based upon the transaction status.
+// structure based upon the transaction status. iopmp_validate_access_batch
+// processes a batch of requests in the same way.
+//
+// The checks are generated from iopmp_validate_tmpl.h for each supported
+// combination of SRCMD table format and features, and validate_select()
+// picks one of them for the configuration of the IOPMP.
 ***************************************************************************/
 
 #include "iopmp.h"
@@ -29,327 +34,475 @@ static iopmpErrorType_t perm_to_etype(perm_type_e perm)
     return ILLEGAL_READ_ACCESS;
 }
 
-/**
-  * @brief Processes the IOPMP transaction request, traversing the SRCMD and MDCFG tables
-  *        and entry array to match address and permissions.
-  *
-  * @param iopmp The IOPMP instance.
-  * @param trans_req The transaction request with required address, permissions, etc.
-  * @param intrpt Pointer to the variable to store wired interrupt flag.
-  *               This flag is set to 1 if the following conditions are true:
-  *                 - the transaction fails
-  *                 - a primary error capture occurs
-  *                 - the interrupts are not suppressed
-  *                 - IOPMP doesn't implement MSI extension, or MSI is not enabled
-  *               This flag is set to 0 if the following conditions are true:
-  *                 - this transaction fails
-  *                 - a primary error capture occurs
-  *                 - the interrupts are suppressed, or IOPMP implements MSI extension
-  *                   and triggers MSI instead of wired interrupt
-  * @return iopmp_trans_rsp_t Response structure with transaction status.
- **/
-void iopmp_validate_access(iopmp_dev_t *iopmp, iopmp_trans_req_t *trans_req, iopmp_trans_rsp_t* iopmp_trans_rsp, uint8_t *intrpt) {
-    iopmp_trans_rsp->rrid         = trans_req->rrid;
-    iopmp_trans_rsp->rrid_stalled = 0;
-    iopmp_trans_rsp->user         = 0;
-    iopmp_trans_rsp->status       = IOPMP_ERROR;
-    iopmp_trans_rsp->rrid_transl  = trans_req->rrid;
-
-    // Check to block invalid combination
-    if (trans_req->perm == INSTR_FETCH && trans_req->is_amo) {
-        fprintf(stderr, "Instruction Fetch transaction cannot be an Atomic Memory Operation (AMO)\n");
-        assert(trans_req->is_amo == 0);
-    }
+// Per-transaction state of the entry checks
+typedef struct {
+    iopmp_rule_analyzer_input_t rule_analyzer_i;
+    uint64_t md_mask;                       // MDs associated with the RRID
+    iopmpErrorType_t error_type;
+    uint16_t error_eid;
+    bool gen_intrpt;
+    bool gen_buserr;
+    bool gen_intrpt_nonPrio;
+    bool gen_buserr_nonPrio;
+    int firstIllegalAccess;
+    iopmpErrorType_t nonPrioRuleStatus;
+    int nonPrioRuleNum;
+    bool uniform;                           // Decided by an entry matching all bytes
+#if (HIT_STATS_EN == 1)
+    uint32_t entries_scanned;               // Entries before the deciding entry, and the deciding entry
+    uint32_t mds_visited;                   // MDs whose entries were scanned
+#endif
+} check_state_t;
+
+// The decision of an entry check
+typedef enum {
+    CHECK_NEXT,                             // Keep checking the next entry
+    CHECK_PASS,                             // The transaction is legal
+    CHECK_FAULT,                            // The transaction is illegal
+} check_result_t;
+
+// Configuration read once per call or batch. Checking a transaction only
+// updates the error capture and stall state, so it doesn't change any of it.
+typedef struct validate_ctx_t {
+    bool enable;                            // HWCFG0.enable
+    bool rrid_transl_en;                    // HWCFG3.rrid_transl_en
+    uint16_t rrid_transl;                   // HWCFG3.rrid_transl
+    uint32_t rrid_num;                      // HWCFG1.rrid_num
+    bool stall_en;                          // HWCFG2.stall_en
+    bool deny_write;                        // Deny all writes, HWCFG3.no_w
+    bool deny_fetch;                        // Deny all instruction fetches
+    bool fetch_as_read;                     // Check instruction fetches as reads
+    bool gen_intrpt;                        // ERR_CFG.ie
+    bool gen_buserr;                        // !ERR_CFG.rs
+    bool nonprio_index_en;                  // The non-priority entry index applies
+} validate_ctx_t;
 
-#if (SRC_ENFORCEMENT_EN == 1)
-    // Enforce RRID=0 for Source-Enforcement
-    const uint16_t rrid = 0;
-#else
-    const uint16_t rrid = trans_req->rrid;
+/**
+* @brief Initializes the state of the entry checks of a transaction.
+*
+* @param st State of the entry checks.
+* @param ctx Configuration read by validate_ctx_init().
+ */
+static inline void check_state_init(check_state_t *st, const validate_ctx_t *ctx)
+{
+    st->error_type         = NO_ERROR;
+    st->error_eid          = 0;
+    st->gen_intrpt         = ctx->gen_intrpt;
+    st->gen_buserr         = ctx->gen_buserr;
+    st->gen_intrpt_nonPrio = false;
+    st->gen_buserr_nonPrio = false;
+    st->firstIllegalAccess = 1;
+    st->nonPrioRuleStatus  = NOT_HIT_ANY_RULE;
+    st->nonPrioRuleNum     = 0;
+    st->uniform            = false;
+#if (HIT_STATS_EN == 1)
+    st->entries_scanned    = 0;
+    st->mds_visited        = 0;
 #endif
-    perm_type_e trans_perm = trans_req->perm;
-    iopmpErrorType_t error_type = NO_ERROR;
-    uint16_t error_eid = 0;
-    bool gen_intrpt = iopmp->reg_file.err_cfg.ie;
-    bool gen_buserr = !iopmp->reg_file.err_cfg.rs;
-
-    int lwr_entry, upr_entry;
-
-    srcmd_en_t  srcmd_en;
-    srcmd_enh_t srcmd_enh;
-
-    bool gen_intrpt_nonPrio = false;
-    bool gen_buserr_nonPrio = false;
-    int firstIllegalAccess = 1;
-    iopmpErrorType_t nonPrioRuleStatus = NOT_HIT_ANY_RULE;
-    int nonPrioRuleNum = 0;
-
-    // IOPMP always allow the transaction when enable = 0
-    if (!iopmp->reg_file.hwcfg0.enable) {
-        goto pass_checks;
-    }
+}
 
-    // Tag a new RRID which represents that the transaction has been checked.
-    // The RRID translation takes effect when IOPMP checker is enabled.
-    if (iopmp->reg_file.hwcfg3.rrid_transl_en) {
-        iopmp_trans_rsp->rrid_transl = iopmp->reg_file.hwcfg3.rrid_transl;
-    }
+#if (HIT_STATS_EN == 1)
+/**
+* @brief Counts the match of a transaction against an entry.
+*
+* @param iopmp The IOPMP instance.
+* @param entry_idx Index of the entry.
+* @param match_status Result of the address match.
+* @param grant The entry grants the transaction.
+ */
+static inline void entry_stats_count(iopmp_dev_t *iopmp, uint32_t entry_idx,
+                                     iopmpMatchStatus_t match_status, bool grant)
+{
+    entry_counters_t *c;
 
-    // Check for valid RRID; if invalid, capture error and return
-    if (rrid >= iopmp->reg_file.hwcfg1.rrid_num) {
-        error_type = UNKNOWN_RRID;
-        goto stop_and_report_fault;
-    }
+    // The counters are sized at reset, a restored checkpoint may have more entries
+    if (entry_idx >= iopmp->stats.entry_num)
+        return;
+    c = &iopmp->stats.entries[entry_idx];
+    if (match_status == ENTRY_PARTIAL_MATCH)
+        __atomic_add_fetch(&c->partials, 1, __ATOMIC_RELAXED);
+    else if (match_status == ENTRY_MATCH)
+        __atomic_add_fetch(grant ? &c->grants : &c->denials, 1, __ATOMIC_RELAXED);
+}
 
-    // Check rrid_stall[s] bit array if IOPMP implements stall-related feature.
-    // rrid_stall[s] are signals indicating that transactions with corresponding
-    // RRID s must be stalled (rrid_stall[s] = 1) or not (rrid_stall[s] = 0).
-    if (iopmp->reg_file.hwcfg2.stall_en && iopmp->rrid_stall[rrid]) {
-        // IOPMP can implement a stall buffer to queue stalled transactions.
-        // If there is any space in the buffer, IOPMP queues the transactions
-        // until the buffer is full. The reference model just returns a flag to
-        // indicate that the input transaction is stalled in this case.
-        if (iopmp->imp_stall_buffer && iopmp->stall_cntr != STALL_BUF_DEPTH) {
-            iopmp_trans_rsp->rrid_stalled = 1;
-            iopmp->stall_cntr++;
-            return;
-        }
-        // If IOPMP doesn't implement any stall buffer or the stall buffer is
-        // full, IOPMP cannot queue the transactions.
-        // IOPMP can fault the stalled transactions in this case and record the
-        // error due to the stalled transactions.
-        if (iopmp->reg_file.err_cfg.stall_violation_en) {
-            error_type = STALLED_TRANSACTION;
-            goto stop_and_report_fault;
-        }
+/**
+* @brief Counts a transaction checked against the entries of an RRID.
+*
+* @param iopmp The IOPMP instance.
+* @param rrid The RRID of the transaction.
+* @param st State of the entry checks of the transaction.
+ */
+static inline void rrid_stats_count(iopmp_dev_t *iopmp, uint16_t rrid, const check_state_t *st)
+{
+    iopmp_rrid_stats_t *c;
 
-        // There is no available stall buffer and IOPMP doesn't fault stalled
-        // transactions. The transactions are truly stalled. The reference model
-        // just return a special flag to simulate this behavior.
-        iopmp_trans_rsp->rrid_stalled_no_available_buffer = 1;
+    if (rrid >= iopmp->stats.rrid_num)
         return;
-    }
+    c = &iopmp->stats.rrids[rrid];
+    __atomic_add_fetch(&c->transactions, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&c->entries_scanned, st->entries_scanned, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&c->mds_visited, st->mds_visited, __ATOMIC_RELAXED);
+}
+#endif
 
-    // When no_w is set to 1, the IOPMP denies all write transactions regardless
-    // of entry rule configurations, reporting them with error type
-    // "not hit any rule" (0x05).
-    if (trans_perm == WRITE_ACCESS && iopmp->reg_file.hwcfg3.no_w) {
-        error_type = NOT_HIT_ANY_RULE;
-        goto stop_and_report_fault;
-    }
+/**
+* @brief Queues a stalled transaction in the stall buffer.
+*
+* The checking threads reserve distinct slots with a relaxed CAS and fill
+* them afterwards. This is safe because the buffer is only drained by
+* stall_buffer_replay(), which runs under epoch_write_enter(): it waits for
+* the checks in progress, so every reserved slot is filled before the drain.
+*
+* @param iopmp The IOPMP instance.
+* @return true if the transaction is queued, false if the stall buffer is full.
+ */
+static inline bool stall_buffer_push(iopmp_dev_t *iopmp, uint16_t rrid, uint64_t addr,
+                                     uint32_t length, uint32_t size, perm_type_e perm,
+                                     bool is_amo)
+{
+#if (STALL_BUF_DEPTH != 0)
+    int cntr = __atomic_load_n(&iopmp->stall_cntr, __ATOMIC_RELAXED);
+    iopmp_trans_req_t *slot;
+
+    do {
+        if (cntr == STALL_BUF_DEPTH)
+            return false;
+    } while (!__atomic_compare_exchange_n(&iopmp->stall_cntr, &cntr, cntr + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    slot = &iopmp->stall_buf[cntr];
+    slot->rrid   = rrid;
+    slot->addr   = addr;
+    slot->length = length;
+    slot->size   = size;
+    slot->perm   = perm;
+    slot->is_amo = is_amo;
+    return true;
+#else
+    return false;
+#endif
+}
 
-    if (trans_perm == INSTR_FETCH) {
-        // When xinr = 0 and no_x is set to 1, the IOPMP denies all instruction
-        // fetch transactions regardless of entry rule configurations, reporting
-        // them with error type "not hit any rule" (0x05).
-        if (!iopmp->reg_file.hwcfg3.xinr && iopmp->reg_file.hwcfg3.no_x) {
-            error_type = NOT_HIT_ANY_RULE;
-            goto stop_and_report_fault;
-        }
-        // When xinr = 1, The IOPMP doesn't perform instruction fetch
-        // permission checking. Instead, the IOPMP treats instruction fetch as
-        // read access.
-        if (iopmp->reg_file.hwcfg3.xinr) {
-            trans_perm = READ_ACCESS;
-        }
-    }
+#if (DECISION_CACHE_EN == 1)
+/**
+* @brief Saves the result of the entry checks as a decision.
+*
+* @param d Output decision.
+* @param st State of the entry checks.
+* @param result Result of the entry checks.
+ */
+static inline void decision_save(decision_t *d, const check_state_t *st, check_result_t result)
+{
+    d->pass       = (result == CHECK_PASS);
+    d->error_type = st->error_type;
+    d->eid        = st->error_eid;
+    d->gen_intrpt = st->gen_intrpt;
+    d->gen_buserr = st->gen_buserr;
+}
 
-    // Read SRCMD table based on `rrid`
-    if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0) {
-        srcmd_en  = iopmp->reg_file.srcmd_table[rrid].srcmd_en;
-        srcmd_enh = iopmp->reg_file.srcmd_table[rrid].srcmd_enh;
-    }
+/**
+* @brief Restores the result of the entry checks from a decision.
+*
+* @param st State of the entry checks.
+* @param d The decision.
+* @return Result of the entry checks.
+ */
+static inline check_result_t decision_load(check_state_t *st, const decision_t *d)
+{
+    st->error_type = d->error_type;
+    st->error_eid  = d->eid;
+    st->gen_intrpt = d->gen_intrpt;
+    st->gen_buserr = d->gen_buserr;
+    return d->pass ? CHECK_PASS : CHECK_FAULT;
+}
+#endif
 
-    int start_md_num;
-    int end_md_num;
-    // Determine MDCFG table range for entries
-    if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0 ||
-        iopmp->reg_file.hwcfg3.srcmd_fmt == 2) {
-        start_md_num = 0;
-        end_md_num   = iopmp->reg_file.hwcfg0.md_num;
-    } else if (iopmp->reg_file.hwcfg3.srcmd_fmt == 1) {
-        start_md_num = rrid;
-        end_md_num   = rrid + 1;
-    }
+#define CHK_CAT_(a, b)  a##_##b
+#define CHK_CAT(a, b)   CHK_CAT_(a, b)
+#define CHK_FN(name)    CHK_CAT(name, CHK_NAME)
+
+// Generic checker, used by configurations without a specialized checker
+#define CHK_NAME        generic
+#define CHK_SRCMD_FMT   (iopmp->reg_file.hwcfg3.srcmd_fmt)
+#define CHK_SPS_EN      (iopmp->reg_file.hwcfg2.sps_en)
+#define CHK_NON_PRIO_EN (iopmp->reg_file.hwcfg2.non_prio_en)
+#define CHK_PEIS        (iopmp->reg_file.hwcfg2.peis)
+#define CHK_PEES        (iopmp->reg_file.hwcfg2.pees)
+#include "iopmp_validate_tmpl.h"
+
+// Specialized checkers for each SRCMD table format, with and without
+// non-priority entries. The MDCFG table format is already resolved by the MD
+// cache, so it doesn't need its own variants.
+// SRCMD format 0 with SPS, with non-priority entries
+#define CHK_NAME        fmt0_sps_np
+#define CHK_SRCMD_FMT   0
+#define CHK_SPS_EN      1
+#define CHK_NON_PRIO_EN 1
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 0, with non-priority entries
+#define CHK_NAME        fmt0_np
+#define CHK_SRCMD_FMT   0
+#define CHK_SPS_EN      0
+#define CHK_NON_PRIO_EN 1
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 1, with non-priority entries
+#define CHK_NAME        fmt1_np
+#define CHK_SRCMD_FMT   1
+#define CHK_SPS_EN      0
+#define CHK_NON_PRIO_EN 1
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 2, with non-priority entries
+#define CHK_NAME        fmt2_np
+#define CHK_SRCMD_FMT   2
+#define CHK_SPS_EN      0
+#define CHK_NON_PRIO_EN 1
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 0 with SPS, without non-priority entries
+#define CHK_NAME        fmt0_sps_prio
+#define CHK_SRCMD_FMT   0
+#define CHK_SPS_EN      1
+#define CHK_NON_PRIO_EN 0
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 0, without non-priority entries
+#define CHK_NAME        fmt0_prio
+#define CHK_SRCMD_FMT   0
+#define CHK_SPS_EN      0
+#define CHK_NON_PRIO_EN 0
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 1, without non-priority entries
+#define CHK_NAME        fmt1_prio
+#define CHK_SRCMD_FMT   1
+#define CHK_SPS_EN      0
+#define CHK_NON_PRIO_EN 0
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
+
+// SRCMD format 2, without non-priority entries
+#define CHK_NAME        fmt2_prio
+#define CHK_SRCMD_FMT   2
+#define CHK_SPS_EN      0
+#define CHK_NON_PRIO_EN 0
+#define CHK_PEIS        1
+#define CHK_PEES        1
+#include "iopmp_validate_tmpl.h"
 
-    /* Prepare input of the rule analyzer which are fixed during entry checks */
-    iopmp_rule_analyzer_input_t rule_analyzer_i;
-    iopmp_rule_analyzer_output_t rule_analyzer_o;
-    rule_analyzer_i.rrid         = rrid;
-    rule_analyzer_i.trans_start  = trans_req->addr;
-    rule_analyzer_i.trans_end    = trans_req->addr +
-                                   ((int)pow(2, trans_req->size) * (trans_req->length + 1));
-    rule_analyzer_i.perm         = trans_perm;
-    rule_analyzer_i.is_amo       = trans_req->is_amo;
-    rule_analyzer_o.match_status = ENTRY_NOTMATCH;
-    rule_analyzer_o.grant_perm   = false;
-
-    // Traverse each MD entry and perform address/permission checks
-    for (int cur_md = start_md_num; cur_md < end_md_num; ++cur_md) {
-        if (iopmp->reg_file.hwcfg3.srcmd_fmt == 0) {
-            if (!IS_MD_ASSOCIATED(cur_md, srcmd_en.md, srcmd_enh.mdh)) continue;
-        }
+/**
+* @brief Reads the configuration used by the transaction checks.
+*
+* @param iopmp The IOPMP instance.
+* @param ctx Output configuration.
+ */
+static void validate_ctx_init(iopmp_dev_t *iopmp, validate_ctx_t *ctx)
+{
+    ctx->enable         = iopmp->reg_file.hwcfg0.enable;
+    ctx->rrid_transl_en = iopmp->reg_file.hwcfg3.rrid_transl_en;
+    ctx->rrid_transl    = iopmp->reg_file.hwcfg3.rrid_transl;
+    ctx->rrid_num       = iopmp->reg_file.hwcfg1.rrid_num;
+    ctx->stall_en       = iopmp->reg_file.hwcfg2.stall_en;
+    ctx->deny_write     = iopmp->reg_file.hwcfg3.no_w;
+    ctx->deny_fetch     = !iopmp->reg_file.hwcfg3.xinr && iopmp->reg_file.hwcfg3.no_x;
+    ctx->fetch_as_read  = iopmp->reg_file.hwcfg3.xinr;
+    ctx->gen_intrpt     = iopmp->reg_file.err_cfg.ie;
+    ctx->gen_buserr     = !iopmp->reg_file.err_cfg.rs;
+    // The index is only equivalent to the linear scan if the MD spans are in
+    // entry order
+    ctx->nonprio_index_en = iopmp->reg_file.hwcfg2.non_prio_en &&
+                            iopmp->md_cache.spans_ordered;
+}
 
-        if (iopmp->reg_file.hwcfg3.mdcfg_fmt == 0) {
-            lwr_entry = (cur_md == 0) ? 0 : iopmp->reg_file.mdcfg[cur_md - 1].t;
-            upr_entry = iopmp->reg_file.mdcfg[cur_md].t;
-        } else {
-            lwr_entry = cur_md * (iopmp->reg_file.hwcfg3.md_entry_num + 1);
-            upr_entry = ((cur_md + 1) * (iopmp->reg_file.hwcfg3.md_entry_num + 1));
-        }
+/**
+  * @brief Selects the transaction checker for the configuration of an IOPMP.
+  *
+  * It is called by reset_iopmp() and after writes to the programmable
+  * fields of HWCFG2 and HWCFG3.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void validate_select(iopmp_dev_t *iopmp)
+{
+    static const iopmp_validator_t validators[2][4] = {
+        { validate_access_fmt0_prio, validate_access_fmt0_sps_prio,
+          validate_access_fmt1_prio, validate_access_fmt2_prio },
+        { validate_access_fmt0_np,   validate_access_fmt0_sps_np,
+          validate_access_fmt1_np,   validate_access_fmt2_np },
+    };
+    uint8_t srcmd_fmt = iopmp->reg_file.hwcfg3.srcmd_fmt;
+    int variant;
+
+    iopmp->validator = validate_access_generic;
+    // The specialized checkers implement per-entry suppression
+    if (!iopmp->reg_file.hwcfg2.peis || !iopmp->reg_file.hwcfg2.pees || (srcmd_fmt > 2))
+        return;
+    // SPS is only available with SRCMD table format 0
+    if (iopmp->reg_file.hwcfg2.sps_en && (srcmd_fmt != 0))
+        return;
 
-        for (int cur_entry = lwr_entry; cur_entry < upr_entry; cur_entry++) {
-            /* Any entry with index >= HWCFG1.entry_num is not available */
-            if (cur_entry >= iopmp->reg_file.hwcfg1.entry_num)
-                break;
-
-            /* Assign necessary input information */
-            rule_analyzer_i.prev_iopmpaddr =
-                (cur_entry == 0) ? 0 : CONCAT32(iopmp->iopmp_entries.entry_table[cur_entry - 1].entry_addrh.addrh,
-                                                iopmp->iopmp_entries.entry_table[cur_entry - 1].entry_addr.addr);
-            rule_analyzer_i.iopmpaddr = CONCAT32(iopmp->iopmp_entries.entry_table[cur_entry].entry_addrh.addrh,
-                                                 iopmp->iopmp_entries.entry_table[cur_entry].entry_addr.addr);
-            rule_analyzer_i.iopmpcfg = iopmp->iopmp_entries.entry_table[cur_entry].entry_cfg;
-            rule_analyzer_i.md       = cur_md;
-            /* Reset output information */
-            rule_analyzer_o.match_status = ENTRY_NOTMATCH;
-            rule_analyzer_o.grant_perm   = false;
-            rule_analyzer_o.sie          = false;
-            rule_analyzer_o.see          = false;
-
-            // Analyze entry for matching and permission granting
-            iopmpRuleAnalyzer(iopmp, &rule_analyzer_i, &rule_analyzer_o);
-            if (rule_analyzer_o.match_status == ENTRY_MATCH && rule_analyzer_o.grant_perm) {
-                // If the entry matches all bytes of the transaction and grants
-                // transaction permission to operate, the transaction is legal.
-                goto pass_checks;
-            } else if (rule_analyzer_o.match_status == ENTRY_PARTIAL_MATCH) {
-                // If the partial matching entry is non-priority entry, just
-                // keep checking next entry.
-                if (iopmp->reg_file.hwcfg2.non_prio_en && cur_entry >= iopmp->reg_file.hwcfg2.prio_entry)
-                    continue;
-
-                // If the partial matching entry is priority entry, check fails.
-                // The priority entry must match all bytes of a transaction, or
-                // transaction is illegal with error type =
-                // "partial hit on a priority rule" (0x04).
-                error_type = PARTIAL_HIT_ON_PRIORITY;
-                error_eid  = cur_entry;
-                goto stop_and_report_fault;
-            } else if (rule_analyzer_o.match_status == ENTRY_MATCH && !rule_analyzer_o.grant_perm) {
-                // If the matching entry is non-priority entry but doesn't grant
-                // transaction permission to operate, the model records this
-                // access as "first illegal access". This "first illegal access"
-                // will be reported if the subsequent entries still fail the
-                // checks. If no matching entry permits, the transaction is
-                // illegal.
-                if (iopmp->reg_file.hwcfg2.non_prio_en && cur_entry >= iopmp->reg_file.hwcfg2.prio_entry) {
-                    // The logic to generate interrupt when matching non-priority entries is:
-                    // "ERR_CFG.ie && (!ENTRY_CFG(i0).{sire|siwe|sixe} || !ENTRY_CFG(i1).{sire|siwe|sixe} ... )"
-                    // Here we perform (!ENTRY_CFG(i0).{sire|siwe|sixe} || !ENTRY_CFG(i1).{sire|siwe|sixe} ... ).
-                    if (iopmp->reg_file.hwcfg2.peis) {
-                        gen_intrpt_nonPrio = (gen_intrpt_nonPrio || !rule_analyzer_o.sie);
-                    }
-                    // The logic to generate bus error when matching non-priority entries is:
-                    // "!ERR_CFG.rs && (!ENTRY_CFG(i0).{sere|sewe|sexe} || !ENTRY_CFG(i1).{sere|sewe|sexe} ... )"
-                    // Here we perform (!ENTRY_CFG(i0).{sere|sewe|sexe} || !ENTRY_CFG(i1).{sere|sewe|sexe} ... ).
-                    if (iopmp->reg_file.hwcfg2.pees) {
-                        gen_buserr_nonPrio = (gen_buserr_nonPrio || !rule_analyzer_o.see);
-                    }
-
-                    nonPrioRuleStatus = perm_to_etype(trans_perm);
-                    // For an illegal transaction matching multiple non-priority
-                    // entries, if the interrupt is triggered or the bus error
-                    // response is returned, ERR_REQID.eid stores the index of
-                    // any of them.
-                    // Here the models determines if this entry could be
-                    // candidate of ERR_REQID.eid field. The matched entry could
-                    // be candidate if it can generate error report.
-                    if (firstIllegalAccess &&
-                        ((iopmp->reg_file.err_cfg.ie && !rule_analyzer_o.sie) ||
-                         (!iopmp->reg_file.err_cfg.rs && !rule_analyzer_o.see))) {
-                        nonPrioRuleNum = cur_entry;
-                        firstIllegalAccess = 0;
-                    }
-                    continue;
-                }
-
-                // If IOPMP supports per-entry interrupt suppression, IOPMP
-                // checks the suppression bit in ENTRY_CFG of the matched entry.
-                // The logic to generate interrupt when matching any priority entry is:
-                // "ERR_CFG.ie && !ENTRY_CFG(i).{sire|siwe|sixe}"
-                if (iopmp->reg_file.hwcfg2.peis) {
-                    gen_intrpt = gen_intrpt && !rule_analyzer_o.sie;
-                }
-                // If IOPMP supports per-entry bus error suppression, IOPMP
-                // checks the suppression bit in ENTRY_CFG of the matched entry.
-                // The logic to generate bus error when matching any priority entry is:
-                // "!ERR_CFG.rs && !ENTRY_CFG(i).{sere|sewe|sexe}"
-                if (iopmp->reg_file.hwcfg2.pees) {
-                    gen_buserr = gen_buserr && !rule_analyzer_o.see;
-                }
-
-                // If the matching entry is priority entry but doesn't grant
-                // transaction permission to operate, the transaction is illegal
-                // with error type = "illegal read access" (0x01) for read
-                // access transaction, "illegal write access/AMO" (0x02) for
-                // write access/atomic memory operation (AMO) transaction.
-                error_type = perm_to_etype(trans_perm);
-                error_eid  = cur_entry;
-                goto stop_and_report_fault;
-            }
-
-            // ENTRY_NOTMATCH: Keep checking next entry
-        }
-    }
+    variant = (srcmd_fmt == 0) ? iopmp->reg_file.hwcfg2.sps_en : (srcmd_fmt + 1);
+    iopmp->validator = validators[iopmp->reg_file.hwcfg2.non_prio_en][variant];
+}
 
-    // If No rule hits, enable error suppression based on global error suppression bit
-    if (iopmp->reg_file.hwcfg2.non_prio_en) {
-        if (nonPrioRuleStatus == NOT_HIT_ANY_RULE) {
-            // None of the non-priority entries fully matches the transaction
-            error_type = NOT_HIT_ANY_RULE;
-        } else {
-            // At least one non-priority entry fully matches the transaction but
-            // doesn't grant transaction permission.
-            // The IOPMP specification says:
-            // If no matching entry permits, the transaction is illegal with
-            // error type = "illegal read access" (0x01) for read access
-            // transaction or "illegal write access/AMO" (0x02) for write
-            // access/AMO transaction.
-            error_type = nonPrioRuleStatus;
-            error_eid  = nonPrioRuleNum;
-
-            // The logic to generate interrupt when matching non-priority entries is:
-            // "ERR_CFG.ie && (!ENTRY_CFG(i0).{sire|siwe|sixe} || !ENTRY_CFG(i1).{sire|siwe|sixe} ... )"
-            if (iopmp->reg_file.hwcfg2.peis) {
-                gen_intrpt = gen_intrpt && gen_intrpt_nonPrio;
-            }
-            // The logic to generate bus error when matching non-priority entries is:
-            // "!ERR_CFG.rs && (!ENTRY_CFG(i0).{sere|sewe|sexe} || !ENTRY_CFG(i1).{sere|sewe|sexe} ... )"
-            if (iopmp->reg_file.hwcfg2.pees) {
-                gen_buserr = gen_buserr && gen_buserr_nonPrio;
-            }
+/**
+  * @brief Releases the stalled transactions whose RRID is no longer stalled.
+  *
+  * The released transactions are checked again with the current
+  * configuration, in the order they were stalled, and their responses are
+  * passed to the stall release callback. The transactions which are still
+  * stalled keep their order and move to the front of the buffer. It is
+  * called with the registers locked after MDSTALL or RRIDSCP resumes
+  * transactions.
+  *
+  * @param iopmp The IOPMP instance.
+ **/
+void stall_buffer_replay(iopmp_dev_t *iopmp)
+{
+#if (STALL_BUF_DEPTH != 0)
+    validate_ctx_t ctx;
+    // The checks publish their slots at epoch_read_exit(), see stall_buffer_push()
+    int count = __atomic_load_n(&iopmp->stall_cntr, __ATOMIC_ACQUIRE);
+    int kept = 0;
+
+    validate_ctx_init(iopmp, &ctx);
+    for (int i = 0; i < count; i++) {
+        iopmp_trans_req_t req = iopmp->stall_buf[i];
+        iopmp_trans_rsp_t rsp;
+        uint8_t intrpt = 0;
+#if (SRC_ENFORCEMENT_EN == 1)
+        uint16_t rrid = 0;
+#else
+        uint16_t rrid = req.rrid;
+#endif
+
+        if (ctx.stall_en && (rrid < ctx.rrid_num) && BITSET_GET(iopmp->rrid_stall, rrid)) {
+            iopmp->stall_buf[kept] = req;
+            kept++;
+            continue;
         }
-    } else {
-        error_type = NOT_HIT_ANY_RULE;
+
+        // The RRID is not stalled, so the checker doesn't queue it again
+        memset(&rsp, 0, sizeof(rsp));
+        iopmp->validator(iopmp, &ctx, req.rrid, req.addr, req.length, req.size,
+                         req.perm, req.is_amo, &rsp, &intrpt);
+        if (iopmp->stall_release)
+            iopmp->stall_release(iopmp->stall_release_ctx, &req, &rsp, intrpt);
     }
-    goto stop_and_report_fault;
+    __atomic_store_n(&iopmp->stall_cntr, kept, __ATOMIC_RELEASE);
+#else
+    (void)iopmp;
+#endif
+}
 
-pass_checks:
-    iopmp_trans_rsp->status = IOPMP_SUCCESS;
-    return;
+/**
+  * @brief Sets the function receiving the transactions released from the
+  *        stall buffer.
+  *
+  * The function is called while the registers are locked, so it must not
+  * access this IOPMP instance. It is kept across reset_iopmp().
+  *
+  * @param iopmp The IOPMP instance.
+  * @param fn The function, or NULL to drop the released transactions.
+  * @param ctx Argument passed to \p fn.
+ **/
+void iopmp_set_stall_release_callback(iopmp_dev_t *iopmp, iopmp_stall_release_fn_t fn, void *ctx)
+{
+    epoch_write_enter(iopmp);
+    iopmp->stall_release     = fn;
+    iopmp->stall_release_ctx = ctx;
+    epoch_write_exit(iopmp);
+}
 
-stop_and_report_fault:
-    // If IOPMP implements error capture feature, IOPMP triggers error capture
-    // to log the error information into the registers.
-    if (!iopmp->reg_file.hwcfg0.no_err_rec) {
-        errorCapture(iopmp, trans_perm, error_type, rrid, error_eid, trans_req->addr, gen_intrpt, gen_buserr, intrpt);
+/**
+  * @brief Processes the IOPMP transaction request, traversing the SRCMD and MDCFG tables
+  *        and entry array to match address and permissions.
+  *
+  * Several threads may check transactions on the same IOPMP instance at the
+  * same time, and while another thread writes its registers.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param trans_req The transaction request with required address, permissions, etc.
+  * @param intrpt Pointer to the variable to store wired interrupt flag.
+  *               This flag is set to 1 if the following conditions are true:
+  *                 - the transaction fails
+  *                 - a primary error capture occurs
+  *                 - the interrupts are not suppressed
+  *                 - IOPMP doesn't implement MSI extension, or MSI is not enabled
+  *               Otherwise, this flag is set to 0.
+  * @return iopmp_trans_rsp_t Response structure with transaction status.
+ **/
+void iopmp_validate_access(iopmp_dev_t *iopmp, iopmp_trans_req_t *trans_req, iopmp_trans_rsp_t* iopmp_trans_rsp, uint8_t *intrpt) {
+    validate_ctx_t ctx;
+    uint8_t trans_intrpt = 0;           // Only written on a primary error capture
+
+    epoch_read_enter(iopmp);
+    validate_ctx_init(iopmp, &ctx);
+    iopmp->validator(iopmp, &ctx, trans_req->rrid, trans_req->addr, trans_req->length,
+                    trans_req->size, trans_req->perm, trans_req->is_amo,
+                    iopmp_trans_rsp, &trans_intrpt);
+#if (TRACE_EN == 1)
+    if (iopmp->trace)
+        trace_record_trans(iopmp, trans_req, iopmp_trans_rsp, trans_intrpt);
+#endif
+    epoch_read_exit(iopmp);
+    *intrpt = trans_intrpt;
+}
+
+/**
+  * @brief Processes a batch of IOPMP transaction requests.
+  *
+  * The result is the same as calling iopmp_validate_access() on each request
+  * in order, including the error capture and stall state, but the
+  * configuration is read only once for the whole batch.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param reqs The transaction requests in structure-of-arrays layout.
+  * @param rsps Array of n responses.
+  * @param intrpts Array of n wired interrupt flags, see iopmp_validate_access().
+  * @param n Number of requests in the batch.
+ **/
+void iopmp_validate_access_batch(iopmp_dev_t *iopmp, const iopmp_trans_req_batch_t *reqs,
+                                 iopmp_trans_rsp_t *rsps, uint8_t *intrpts, size_t n) {
+    validate_ctx_t ctx;
+
+    epoch_read_enter(iopmp);
+    validate_ctx_init(iopmp, &ctx);
+    for (size_t i = 0; i < n; i++) {
+        // The checker only writes the flag on a primary error capture
+        intrpts[i] = 0;
+        iopmp->validator(iopmp, &ctx, reqs->rrid[i], reqs->addr[i], reqs->length[i],
+                         reqs->size[i], (perm_type_e)reqs->perm[i], reqs->is_amo[i],
+                         &rsps[i], &intrpts[i]);
     }
-    // Return response with default status if no match/error occurs
-    // In case of error suppression, success response is returned, with user defined value on initiator port
-    // NOTE: You can change the `user` value
-    if (!gen_buserr) {
-        iopmp_trans_rsp->status = IOPMP_SUCCESS;
-        iopmp_trans_rsp->user = USER;
+#if (TRACE_EN == 1)
+    for (size_t i = 0; iopmp->trace && (i < n); i++) {
+        iopmp_trans_req_t req = {
+            .rrid   = reqs->rrid[i],
+            .addr   = reqs->addr[i],
+            .length = reqs->length[i],
+            .size   = reqs->size[i],
+            .perm   = (perm_type_e)reqs->perm[i],
+            .is_amo = reqs->is_amo[i],
+        };
+
+        trace_record_trans(iopmp, &req, &rsps[i], intrpts[i]);
     }
+#endif
+    epoch_read_exit(iopmp);
 }
@@ -0,0 +1,473 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Transaction Checker Template
+// This file is included by iopmp_validate.c once per checker variant. The
+// following macros must be defined before including it, and are undefined at
+// its end:
+// - CHK_NAME: Suffix of the names of the generated functions.
+// - CHK_SRCMD_FMT: HWCFG3.srcmd_fmt.
+// - CHK_SPS_EN: HWCFG2.sps_en.
+// - CHK_NON_PRIO_EN: HWCFG2.non_prio_en.
+// - CHK_PEIS: HWCFG2.peis.
+// - CHK_PEES: HWCFG2.pees.
+// Defining them as constants removes the branches on these fields from the
+// per-entry path. Defining them as register reads gives a generic checker.
+//
+// The main functions in this file include:
+// - check_entry: Checks a transaction against one entry.
+// - check_nonprio_entry: Checks a non-priority entry found by the index.
+// - validate_access: Checks one transaction request.
+***************************************************************************/
+
+#include "iopmp_rule_analyzer.h"
+
+/**
+* @brief Checks a transaction against one entry.
+*
+* @param iopmp The IOPMP instance.
+* @param st State of the entry checks of the transaction.
+* @param cur_entry Index of the entry.
+* @param cur_md The MD the entry belongs to.
+* @return check_result_t Decision taken by this entry
+ */
+static inline check_result_t CHK_FN(check_entry)(iopmp_dev_t *iopmp, check_state_t *st,
+                                                  uint32_t cur_entry, int cur_md)
+{
+    iopmp_rule_analyzer_output_t rule_analyzer_o;
+
+    /* Assign necessary input information from the decoded entry */
+    st->rule_analyzer_i.lo           = iopmp->entry_cache.lo[cur_entry];
+    st->rule_analyzer_i.hi           = iopmp->entry_cache.hi[cur_entry];
+    st->rule_analyzer_i.iopmpcfg.raw = iopmp->entry_cache.cfg[cur_entry];
+    st->rule_analyzer_i.md           = cur_md;
+    /* Reset output information */
+    rule_analyzer_o.match_status = ENTRY_NOTMATCH;
+    rule_analyzer_o.grant_perm   = false;
+    rule_analyzer_o.sie          = false;
+    rule_analyzer_o.see          = false;
+
+    // Analyze entry for matching and permission granting
+    CHK_FN(iopmpRuleAnalyzer)(iopmp, &st->rule_analyzer_i, &rule_analyzer_o);
+#if (HIT_STATS_EN == 1)
+    st->entries_scanned++;
+    entry_stats_count(iopmp, cur_entry, rule_analyzer_o.match_status, rule_analyzer_o.grant_perm);
+#endif
+    if (rule_analyzer_o.match_status == ENTRY_MATCH && rule_analyzer_o.grant_perm) {
+        // If the entry matches all bytes of the transaction and grants
+        // transaction permission to operate, the transaction is legal.
+        st->uniform = true;
+        return CHECK_PASS;
+    } else if (rule_analyzer_o.match_status == ENTRY_PARTIAL_MATCH) {
+        // If the partial matching entry is non-priority entry, just
+        // keep checking next entry.
+        if (CHK_NON_PRIO_EN && cur_entry >= iopmp->reg_file.hwcfg2.prio_entry)
+            return CHECK_NEXT;
+
+        // If the partial matching entry is priority entry, check fails.
+        // The priority entry must match all bytes of a transaction, or
+        // transaction is illegal with error type =
+        // "partial hit on a priority rule" (0x04).
+        st->error_type = PARTIAL_HIT_ON_PRIORITY;
+        st->error_eid  = cur_entry;
+        return CHECK_FAULT;
+    } else if (rule_analyzer_o.match_status == ENTRY_MATCH && !rule_analyzer_o.grant_perm) {
+        // If the matching entry is non-priority entry but doesn't grant
+        // transaction permission to operate, the model records this
+        // access as "first illegal access". This "first illegal access"
+        // will be reported if the subsequent entries still fail the
+        // checks. If no matching entry permits, the transaction is
+        // illegal.
+        if (CHK_NON_PRIO_EN && cur_entry >= iopmp->reg_file.hwcfg2.prio_entry) {
+            // The logic to generate interrupt when matching non-priority entries is:
+            // "ERR_CFG.ie && (!ENTRY_CFG(i0).{sire|siwe|sixe} || !ENTRY_CFG(i1).{sire|siwe|sixe} ... )"
+            // Here we perform (!ENTRY_CFG(i0).{sire|siwe|sixe} || !ENTRY_CFG(i1).{sire|siwe|sixe} ... ).
+            if (CHK_PEIS) {
+                st->gen_intrpt_nonPrio = (st->gen_intrpt_nonPrio || !rule_analyzer_o.sie);
+            }
+            // The logic to generate bus error when matching non-priority entries is:
+            // "!ERR_CFG.rs && (!ENTRY_CFG(i0).{sere|sewe|sexe} || !ENTRY_CFG(i1).{sere|sewe|sexe} ... )"
+            // Here we perform (!ENTRY_CFG(i0).{sere|sewe|sexe} || !ENTRY_CFG(i1).{sere|sewe|sexe} ... ).
+            if (CHK_PEES) {
+                st->gen_buserr_nonPrio = (st->gen_buserr_nonPrio || !rule_analyzer_o.see);
+            }
+
+            st->nonPrioRuleStatus = perm_to_etype(st->rule_analyzer_i.perm);
+            // For an illegal transaction matching multiple non-priority
+            // entries, if the interrupt is triggered or the bus error
+            // response is returned, ERR_REQID.eid stores the index of
+            // any of them.
+            // Here the models determines if this entry could be
+            // candidate of ERR_REQID.eid field. The matched entry could
+            // be candidate if it can generate error report. The model
+            // reports the candidate with the lowest index, so the result
+            // doesn't depend on the order non-priority entries are visited.
+            if ((st->firstIllegalAccess || (int)cur_entry < st->nonPrioRuleNum) &&
+                ((iopmp->reg_file.err_cfg.ie && !rule_analyzer_o.sie) ||
+                 (!iopmp->reg_file.err_cfg.rs && !rule_analyzer_o.see))) {
+                st->nonPrioRuleNum = cur_entry;
+                st->firstIllegalAccess = 0;
+            }
+            return CHECK_NEXT;
+        }
+
+        // If IOPMP supports per-entry interrupt suppression, IOPMP
+        // checks the suppression bit in ENTRY_CFG of the matched entry.
+        // The logic to generate interrupt when matching any priority entry is:
+        // "ERR_CFG.ie && !ENTRY_CFG(i).{sire|siwe|sixe}"
+        if (CHK_PEIS) {
+            st->gen_intrpt = st->gen_intrpt && !rule_analyzer_o.sie;
+        }
+        // If IOPMP supports per-entry bus error suppression, IOPMP
+        // checks the suppression bit in ENTRY_CFG of the matched entry.
+        // The logic to generate bus error when matching any priority entry is:
+        // "!ERR_CFG.rs && !ENTRY_CFG(i).{sere|sewe|sexe}"
+        if (CHK_PEES) {
+            st->gen_buserr = st->gen_buserr && !rule_analyzer_o.see;
+        }
+
+        // If the matching entry is priority entry but doesn't grant
+        // transaction permission to operate, the transaction is illegal
+        // with error type = "illegal read access" (0x01) for read
+        // access transaction, "illegal write access/AMO" (0x02) for
+        // write access/atomic memory operation (AMO) transaction.
+        st->error_type = perm_to_etype(st->rule_analyzer_i.perm);
+        st->error_eid  = cur_entry;
+        st->uniform    = true;
+        return CHECK_FAULT;
+    }
+
+    // ENTRY_NOTMATCH: Keep checking next entry
+    return CHECK_NEXT;
+}
+
+/**
+* @brief Checks a non-priority entry found by the non-priority entry index.
+*
+* @param iopmp The IOPMP instance.
+* @param entry_idx Index of an entry which covers all bytes of the transaction.
+* @param arg State of the entry checks of the transaction.
+* @return true if the entry grants the transaction, which stops the lookup
+ */
+static bool CHK_FN(check_nonprio_entry)(iopmp_dev_t *iopmp, uint16_t entry_idx, void *arg)
+{
+    check_state_t *st = arg;
+    int md = md_cache_entry_md(iopmp, entry_idx);
+
+    // Skip entries of MDs not associated with the RRID
+    if ((md < 0) || !((st->md_mask >> md) & 1))
+        return false;
+
+    return CHK_FN(check_entry)(iopmp, st, entry_idx, md) == CHECK_PASS;
+}
+
+/**
+* @brief Checks a transaction against the entries of the MDs of its RRID.
+*
+* st->md_mask and st->rule_analyzer_i must be set, and the other fields of
+* st initialized by check_state_init(). The walk has no side effects, other
+* than the hit counters if HIT_STATS_EN is set.
+*
+* @param iopmp The IOPMP instance.
+* @param ctx Configuration read by validate_ctx_init().
+* @param st State of the entry checks of the transaction.
+* @return CHECK_PASS or CHECK_FAULT, with the error to report in st.
+ */
+static check_result_t CHK_FN(check_entries)(iopmp_dev_t *iopmp, const validate_ctx_t *ctx,
+                                            check_state_t *st)
+{
+    uint32_t lwr_entry, upr_entry, prio_upr_entry, cur_entry;
+    uint64_t md_mask = st->md_mask;
+    bool use_nonprio_index;
+
+    // Only an entry covering all bytes of the transaction can decide a
+    // transaction among non-priority entries, and their order doesn't affect
+    // the result. The model looks them up in the non-priority entry index
+    // instead of scanning them, unless the MD spans are not in entry order
+    // or the transaction wraps around the address space.
+    use_nonprio_index = ctx->nonprio_index_en &&
+                        (st->rule_analyzer_i.trans_start < st->rule_analyzer_i.trans_end);
+
+    // Traverse the entries of each associated MD in ascending MD order and
+    // perform address/permission checks
+    for (; md_mask; md_mask &= (md_mask - 1)) {
+        int cur_md = __builtin_ctzll(md_mask);
+
+        // Spans are already clipped to HWCFG1.entry_num
+        lwr_entry = iopmp->md_cache.lwr_entry[cur_md];
+        upr_entry = iopmp->md_cache.upr_entry[cur_md];
+        if (use_nonprio_index && (upr_entry > iopmp->reg_file.hwcfg2.prio_entry)) {
+            upr_entry = iopmp->reg_file.hwcfg2.prio_entry;
+        }
+
+        // The first priority entry touching the transaction decides it, so
+        // skip the priority entries which don't cover any byte of it
+        prio_upr_entry = upr_entry;
+        if (CHK_NON_PRIO_EN &&
+            (prio_upr_entry > iopmp->reg_file.hwcfg2.prio_entry)) {
+            prio_upr_entry = iopmp->reg_file.hwcfg2.prio_entry;
+        }
+        cur_entry = lwr_entry;
+        if (cur_entry < prio_upr_entry) {
+            cur_entry = prio_match_first(iopmp, cur_entry, prio_upr_entry,
+                                         st->rule_analyzer_i.trans_start,
+                                         st->rule_analyzer_i.trans_end);
+        }
+#if (HIT_STATS_EN == 1)
+        // The priority entries skipped don't match, but they are scanned
+        st->mds_visited++;
+        st->entries_scanned += cur_entry - lwr_entry;
+#endif
+
+        for (; cur_entry < upr_entry; cur_entry++) {
+            switch (CHK_FN(check_entry)(iopmp, st, cur_entry, cur_md)) {
+            case CHECK_PASS:
+                return CHECK_PASS;
+            case CHECK_FAULT:
+                return CHECK_FAULT;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (use_nonprio_index &&
+        nonprio_index_query(iopmp, st->rule_analyzer_i.trans_start,
+                            st->rule_analyzer_i.trans_end,
+                            CHK_FN(check_nonprio_entry), st)) {
+        return CHECK_PASS;
+    }
+
+    // If No rule hits, enable error suppression based on global error suppression bit
+    if (CHK_NON_PRIO_EN) {
+        if (st->nonPrioRuleStatus == NOT_HIT_ANY_RULE) {
+            // None of the non-priority entries fully matches the transaction
+            st->error_type = NOT_HIT_ANY_RULE;
+        } else {
+            // At least one non-priority entry fully matches the transaction but
+            // doesn't grant transaction permission.
+            // The IOPMP specification says:
+            // If no matching entry permits, the transaction is illegal with
+            // error type = "illegal read access" (0x01) for read access
+            // transaction or "illegal write access/AMO" (0x02) for write
+            // access/AMO transaction.
+            st->error_type = st->nonPrioRuleStatus;
+            st->error_eid  = st->nonPrioRuleNum;
+
+            // The logic to generate interrupt when matching non-priority entries is:
+            // "ERR_CFG.ie && (!ENTRY_CFG(i0).{sire|siwe|sixe} || !ENTRY_CFG(i1).{sire|siwe|sixe} ... )"
+            if (CHK_PEIS) {
+                st->gen_intrpt = st->gen_intrpt && st->gen_intrpt_nonPrio;
+            }
+            // The logic to generate bus error when matching non-priority entries is:
+            // "!ERR_CFG.rs && (!ENTRY_CFG(i0).{sere|sewe|sexe} || !ENTRY_CFG(i1).{sere|sewe|sexe} ... )"
+            if (CHK_PEES) {
+                st->gen_buserr = st->gen_buserr && st->gen_buserr_nonPrio;
+            }
+        }
+    } else {
+        st->error_type = NOT_HIT_ANY_RULE;
+    }
+    return CHECK_FAULT;
+
+}
+
+/**
+* @brief Checks one transaction request.
+*
+* @param iopmp The IOPMP instance.
+* @param ctx Configuration read by validate_ctx_init().
+* @param req_rrid Requester ID of the transaction.
+* @param addr Target address of the transaction.
+* @param length Length of the transaction.
+* @param size Size of each access in the transaction.
+* @param perm Type of permission requested.
+* @param is_amo Indicates the AMO access.
+* @param iopmp_trans_rsp Response structure with transaction status.
+* @param intrpt Pointer to the variable to store wired interrupt flag.
+ */
+static void CHK_FN(validate_access)(iopmp_dev_t *iopmp, const validate_ctx_t *ctx,
+                                    uint16_t req_rrid, uint64_t addr, uint32_t length,
+                                    uint32_t size, perm_type_e perm, bool is_amo,
+                                    iopmp_trans_rsp_t *iopmp_trans_rsp, uint8_t *intrpt)
+{
+    iopmp_trans_rsp->rrid         = req_rrid;
+    iopmp_trans_rsp->rrid_stalled = 0;
+    iopmp_trans_rsp->user         = 0;
+    iopmp_trans_rsp->status       = IOPMP_ERROR;
+    iopmp_trans_rsp->rrid_transl  = req_rrid;
+
+    // Check to block invalid combination
+    if (perm == INSTR_FETCH && is_amo) {
+        fprintf(stderr, "Instruction Fetch transaction cannot be an Atomic Memory Operation (AMO)\n");
+        assert(is_amo == 0);
+    }
+
+#if (SRC_ENFORCEMENT_EN == 1)
+    // Enforce RRID=0 for Source-Enforcement
+    const uint16_t rrid = 0;
+#else
+    const uint16_t rrid = req_rrid;
+#endif
+    perm_type_e trans_perm = perm;
+    check_state_t st;
+    check_result_t result;
+
+    check_state_init(&st, ctx);
+
+    // IOPMP always allow the transaction when enable = 0
+    if (!ctx->enable) {
+        goto pass_checks;
+    }
+
+    // Tag a new RRID which represents that the transaction has been checked.
+    // The RRID translation takes effect when IOPMP checker is enabled.
+    if (ctx->rrid_transl_en) {
+        iopmp_trans_rsp->rrid_transl = ctx->rrid_transl;
+    }
+
+    // Check for valid RRID; if invalid, capture error and return
+    if (rrid >= ctx->rrid_num) {
+        st.error_type = UNKNOWN_RRID;
+        goto stop_and_report_fault;
+    }
+
+    // Check rrid_stall[s] bit array if IOPMP implements stall-related feature.
+    // rrid_stall[s] are signals indicating that transactions with corresponding
+    // RRID s must be stalled (rrid_stall[s] = 1) or not (rrid_stall[s] = 0).
+    if (ctx->stall_en && BITSET_GET(iopmp->rrid_stall, rrid)) {
+        // IOPMP can implement a stall buffer to queue stalled transactions.
+        // If there is any space in the buffer, IOPMP queues the transactions
+        // until the buffer is full, and releases them when they are resumed,
+        // see stall_buffer_replay().
+        if (iopmp->imp_stall_buffer &&
+            stall_buffer_push(iopmp, req_rrid, addr, length, size, perm, is_amo)) {
+            iopmp_trans_rsp->rrid_stalled = 1;
+            return;
+        }
+        // If IOPMP doesn't implement any stall buffer or the stall buffer is
+        // full, IOPMP cannot queue the transactions.
+        // IOPMP can fault the stalled transactions in this case and record the
+        // error due to the stalled transactions.
+        if (iopmp->reg_file.err_cfg.stall_violation_en) {
+            st.error_type = STALLED_TRANSACTION;
+            goto stop_and_report_fault;
+        }
+
+        // There is no available stall buffer and IOPMP doesn't fault stalled
+        // transactions. The transactions are truly stalled. The reference model
+        // just return a special flag to simulate this behavior.
+        iopmp_trans_rsp->rrid_stalled_no_available_buffer = 1;
+        return;
+    }
+
+    // When no_w is set to 1, the IOPMP denies all write transactions regardless
+    // of entry rule configurations, reporting them with error type
+    // "not hit any rule" (0x05).
+    if (trans_perm == WRITE_ACCESS && ctx->deny_write) {
+        st.error_type = NOT_HIT_ANY_RULE;
+        goto stop_and_report_fault;
+    }
+
+    if (trans_perm == INSTR_FETCH) {
+        // When xinr = 0 and no_x is set to 1, the IOPMP denies all instruction
+        // fetch transactions regardless of entry rule configurations, reporting
+        // them with error type "not hit any rule" (0x05).
+        if (ctx->deny_fetch) {
+            st.error_type = NOT_HIT_ANY_RULE;
+            goto stop_and_report_fault;
+        }
+        // When xinr = 1, The IOPMP doesn't perform instruction fetch
+        // permission checking. Instead, the IOPMP treats instruction fetch as
+        // read access.
+        if (ctx->fetch_as_read) {
+            trans_perm = READ_ACCESS;
+        }
+    }
+
+    // MDs associated with `rrid` which own at least one entry. The MD cache
+    // already resolves the SRCMD table format and the MDCFG table format.
+    /* Prepare input of the rule analyzer which are fixed during entry checks */
+    st.md_mask                     = iopmp->md_cache.rrid_mds[rrid] & iopmp->md_cache.nonempty_mds;
+    st.rule_analyzer_i.rrid        = rrid;
+    st.rule_analyzer_i.trans_start = addr;
+    st.rule_analyzer_i.trans_end   = addr + ((int)pow(2, size) * (length + 1));
+    st.rule_analyzer_i.perm        = trans_perm;
+    st.rule_analyzer_i.is_amo      = is_amo;
+
+    // The hit counters need every transaction to be checked against the
+    // entries, so they bypass the decision cache
+#if (DECISION_CACHE_EN == 1) && (HIT_STATS_EN == 0)
+    decision_t decision;
+
+    if (decision_cache_lookup(iopmp, rrid, trans_perm, is_amo,
+                              st.rule_analyzer_i.trans_start,
+                              st.rule_analyzer_i.trans_end, &decision)) {
+        result = decision_load(&st, &decision);
+        goto apply_decision;
+    }
+    if (decision_cache_fits(st.rule_analyzer_i.trans_start, st.rule_analyzer_i.trans_end)) {
+        // Check the whole block. If no entry boundary falls inside it, every
+        // transaction within the block gets this decision.
+        check_state_t block_st;
+
+        check_state_init(&block_st, ctx);
+        block_st.md_mask                     = st.md_mask;
+        block_st.rule_analyzer_i             = st.rule_analyzer_i;
+        block_st.rule_analyzer_i.trans_start = st.rule_analyzer_i.trans_start & ~((uint64_t)DECISION_CACHE_BLOCK - 1);
+        block_st.rule_analyzer_i.trans_end   = block_st.rule_analyzer_i.trans_start + DECISION_CACHE_BLOCK;
+        result = CHK_FN(check_entries)(iopmp, ctx, &block_st);
+        if (block_st.uniform) {
+            decision_save(&decision, &block_st, result);
+            decision_cache_insert(iopmp, rrid, trans_perm, is_amo,
+                                  block_st.rule_analyzer_i.trans_start, &decision);
+            result = decision_load(&st, &decision);
+            goto apply_decision;
+        }
+    }
+#endif
+
+    result = CHK_FN(check_entries)(iopmp, ctx, &st);
+
+#if (DECISION_CACHE_EN == 1) && (HIT_STATS_EN == 0)
+apply_decision:
+#endif
+#if (HIT_STATS_EN == 1)
+    rrid_stats_count(iopmp, rrid, &st);
+#endif
+    if (result == CHECK_PASS)
+        goto pass_checks;
+    goto stop_and_report_fault;
+
+pass_checks:
+    iopmp_trans_rsp->status = IOPMP_SUCCESS;
+    return;
+
+stop_and_report_fault:
+#if (VIOLATION_LOG_EN == 1)
+    violation_log_record(iopmp, trans_perm, st.error_type, rrid, st.error_eid, addr,
+                         st.gen_intrpt, st.gen_buserr);
+#endif
+    // If IOPMP implements error capture feature, IOPMP triggers error capture
+    // to log the error information into the registers.
+    if (!iopmp->reg_file.hwcfg0.no_err_rec) {
+        errorCapture(iopmp, trans_perm, st.error_type, rrid, st.error_eid, addr, st.gen_intrpt, st.gen_buserr, intrpt);
+    }
+    // Return response with default status if no match/error occurs
+    // In case of error suppression, success response is returned, with user defined value on initiator port
+    // NOTE: You can change the `user` value
+    if (!st.gen_buserr) {
+        iopmp_trans_rsp->status = IOPMP_SUCCESS;
+        iopmp_trans_rsp->user = USER;
+    }
+}
+
+#undef CHK_NAME
+#undef CHK_SRCMD_FMT
+#undef CHK_SPS_EN
+#undef CHK_NON_PRIO_EN
+#undef CHK_PEIS
+#undef CHK_PEES
@@ -0,0 +1,117 @@
+/***************************************************************************
+// Copyright (c) 2025 by 10xEngineers.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+//
+// Date: October 16, 2026
+// Description: IOPMP Violation Log
+// The error capture record only keeps the first violation, and the MFR
+// extension one bit per RRID. The violation log is a side-band record of
+// every violation, with its address, RRID, entry index, error type and
+// suppression, kept until software drains it.
+//
+// The log is a bounded ring of VIOLATION_LOG_DEPTH records. Concurrent
+// checks reserve consecutive sequence numbers and publish each record once it
+// is written. A violation found while the ring is full isn't recorded, and
+// is counted instead, so the records left are never overwritten.
+//
+// The main functions in this file include:
+// - violation_log_record: Records a violation.
+// - iopmp_violation_log_drain: Moves the oldest records out of the log.
+***************************************************************************/
+
+#include "iopmp.h"
+
+#if (VIOLATION_LOG_EN == 1)
+
+/**
+  * @brief Records a violation in the violation log.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param perm Type of the transaction.
+  * @param etype Type of the violation.
+  * @param rrid RRID of the transaction.
+  * @param eid Entry index reported with the error.
+  * @param addr Address of the transaction.
+  * @param intrpt The violation triggers an interrupt.
+  * @param buserr The violation returns a bus error.
+ **/
+void violation_log_record(iopmp_dev_t *iopmp, perm_type_e perm, uint8_t etype, uint16_t rrid,
+                          uint16_t eid, uint64_t addr, bool intrpt, bool buserr)
+{
+    violation_log_t *log = &iopmp->violation_log;
+    uint64_t seq = __atomic_load_n(&log->tail, __ATOMIC_RELAXED);
+    violation_slot_t *slot;
+
+    // Reserve the next slot unless the records not yet drained fill the ring
+    do {
+        if ((seq - __atomic_load_n(&log->head, __ATOMIC_ACQUIRE)) >= VIOLATION_LOG_DEPTH) {
+            __atomic_add_fetch(&log->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&log->tail, &seq, seq + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    slot = &log->slots[seq & (VIOLATION_LOG_DEPTH - 1)];
+    slot->rec.seq    = seq;
+    slot->rec.addr   = addr;
+    slot->rec.rrid   = rrid;
+    slot->rec.eid    = eid;
+    slot->rec.perm   = perm;
+    slot->rec.etype  = etype;
+    slot->rec.intrpt = intrpt;
+    slot->rec.buserr = buserr;
+    __atomic_store_n(&slot->ready, seq + 1, __ATOMIC_RELEASE);
+}
+
+#endif
+
+/**
+  * @brief Moves the oldest records out of the violation log.
+  *
+  * The records are returned in the order of their sequence numbers. A record
+  * still being written by a concurrent check ends the drain, it is returned
+  * by the next one. Nothing is drained when the model is built without the
+  * violation log.
+  *
+  * @param iopmp The IOPMP instance.
+  * @param records Array of max output records.
+  * @param max Maximum number of records to drain.
+  * @param dropped Output number of violations which weren't recorded since
+  *                the previous drain because the log was full, or NULL.
+  * @return The number of records drained.
+ **/
+size_t iopmp_violation_log_drain(iopmp_dev_t *iopmp, iopmp_violation_t *records, size_t max,
+                                 uint64_t *dropped)
+{
+    size_t n = 0;
+
+#if (VIOLATION_LOG_EN == 1)
+    violation_log_t *log = &iopmp->violation_log;
+    uint64_t seq, tail;
+
+    // Drains are serialized with register accesses, checks keep recording
+    epoch_lock(iopmp);
+    seq  = log->head;
+    tail = __atomic_load_n(&log->tail, __ATOMIC_ACQUIRE);
+    for (; (seq < tail) && (n < max); seq++, n++) {
+        const violation_slot_t *slot = &log->slots[seq & (VIOLATION_LOG_DEPTH - 1)];
+
+        if (__atomic_load_n(&slot->ready, __ATOMIC_ACQUIRE) != (seq + 1))
+            break;
+        records[n] = slot->rec;
+    }
+    // The slots drained can be reused
+    __atomic_store_n(&log->head, seq, __ATOMIC_RELEASE);
+    if (dropped)
+        *dropped = __atomic_exchange_n(&log->dropped, 0, __ATOMIC_RELAXED);
+    epoch_unlock(iopmp);
+#else
+    (void)iopmp;
+    (void)records;
+    (void)max;
+    if (dropped)
+        *dropped = 0;
+#endif
+    return n;
+}
@@ -9,31 +9,193 @@
 // Description: This file contains all the functions that could be used
 // while testing any IOPMP Model.
 ***************************************************************************/
+#include <pthread.h>
 #include "test_utils.h"
 #include "config.h"
 #include "iopmp.h"
 
 int test_num;
-int8_t *memory;
 uint64_t bus_error = 0;
 
+// Sparse memory: pages are allocated on their first write and found
+// through a hash of their page number. Unwritten memory reads as zero.
+#define MEM_PAGE_SHIFT      12
+#define MEM_PAGE_SIZE       (1ULL << MEM_PAGE_SHIFT)
+#define MEM_MIN_BUCKETS     1024
+
+typedef struct mem_page_t {
+    uint64_t pfn;                       // Address >> MEM_PAGE_SHIFT
+    struct mem_page_t *next;            // Next page in the bucket
+    uint8_t data[MEM_PAGE_SIZE];
+} mem_page_t;
+
+static struct {
+    mem_page_t **buckets;
+    size_t num_buckets;                 // A power of 2
+    size_t num_pages;
+    size_t max_pages;                   // Pages which may be allocated
+    pthread_mutex_t lock;               // MSIs are written by concurrent checks
+} mem = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static inline size_t mem_bucket(uint64_t pfn, size_t num_buckets)
+{
+    return (size_t)((pfn * 0x9E3779B97F4A7C15ULL) >> 32) & (num_buckets - 1);
+}
+
+static mem_page_t *mem_find_page(uint64_t pfn)
+{
+    mem_page_t *page;
+
+    if (!mem.buckets) return NULL;
+    for (page = mem.buckets[mem_bucket(pfn, mem.num_buckets)]; page; page = page->next) {
+        if (page->pfn == pfn) return page;
+    }
+    return NULL;
+}
+
+/* Doubles the buckets so chains stay short */
+static void mem_grow_buckets(void)
+{
+    size_t num_buckets = mem.num_buckets * 2;
+    mem_page_t **buckets = calloc(num_buckets, sizeof(*buckets));
+
+    if (!buckets) return;   // Keep the longer chains
+    for (size_t i = 0; i < mem.num_buckets; i++) {
+        mem_page_t *page = mem.buckets[i];
+
+        while (page) {
+            mem_page_t *next = page->next;
+            size_t b = mem_bucket(page->pfn, num_buckets);
+
+            page->next = buckets[b];
+            buckets[b] = page;
+            page = next;
+        }
+    }
+    free(mem.buckets);
+    mem.buckets     = buckets;
+    mem.num_buckets = num_buckets;
+}
+
+static mem_page_t *mem_get_page(uint64_t pfn)
+{
+    mem_page_t *page = mem_find_page(pfn);
+    size_t b;
+
+    if (page || !mem.buckets || (mem.num_pages == mem.max_pages)) return page;
+
+    page = calloc(1, sizeof(*page));
+    if (!page) return NULL;
+    page->pfn = pfn;
+    b = mem_bucket(pfn, mem.num_buckets);
+    page->next = mem.buckets[b];
+    mem.buckets[b] = page;
+    if (++mem.num_pages > mem.num_buckets) mem_grow_buckets();
+    return page;
+}
+
 /**
-  * @brief Allocates memory of the specified size in gigabytes.
+  * @brief Creates a sparse memory of the specified size in gigabytes.
   *
-  * @param mem_gb - The size of the memory to allocate in gigabytes.
-  * @return 0 if the memory allocation was successful, -1 otherwise.
+  * Pages are allocated on their first write, anywhere in the 64-bit address
+  * space, until mem_gb gigabytes are allocated.
+  *
+  * @param mem_gb - The maximum size of the memory to allocate in gigabytes.
+  * @return 0 if the memory creation was successful, -1 otherwise.
  **/
 int create_memory(uint8_t mem_gb) {
-    // Calculate the total memory size in bytes
-    size_t total_size = (size_t)mem_gb * 1024UL * 1024UL * 1024UL;
+    destroy_memory();
+
+    pthread_mutex_lock(&mem.lock);
+    mem.buckets = calloc(MEM_MIN_BUCKETS, sizeof(*mem.buckets));
+    mem.num_buckets = MEM_MIN_BUCKETS;
+    mem.max_pages   = ((uint64_t)mem_gb << 30) >> MEM_PAGE_SHIFT;
+    pthread_mutex_unlock(&mem.lock);
+
+    return mem.buckets ? 0 : -1;
+}
 
-    // Allocate memory and check for allocation failure
-    memory = malloc(total_size);
-    if (memory == NULL) {
-        return -1; // Memory allocation failed
+/**
+  * @brief Releases the memory created by create_memory().
+ **/
+void destroy_memory(void) {
+    pthread_mutex_lock(&mem.lock);
+    for (size_t i = 0; i < mem.num_buckets; i++) {
+        mem_page_t *page = mem.buckets[i];
+
+        while (page) {
+            mem_page_t *next = page->next;
+            free(page);
+            page = next;
+        }
+    }
+    free(mem.buckets);
+    mem.buckets     = NULL;
+    mem.num_buckets = 0;
+    mem.num_pages   = 0;
+    pthread_mutex_unlock(&mem.lock);
+}
+
+/**
+  * @brief Reads a block of bytes from the memory.
+  *
+  * @param addr - The memory address from where the data should be read.
+  * @param buf - The buffer receiving the data.
+  * @param len - The number of bytes to read.
+  * @return 0 if the read was successful, BUS_ERROR if the block covers the bus error address.
+ **/
+uint8_t read_memory_block(uint64_t addr, void *buf, size_t len) {
+    uint8_t *dst = buf;
+
+    if (len && (bus_error >= addr) && (bus_error - addr < len)) { return BUS_ERROR; }
+
+    pthread_mutex_lock(&mem.lock);
+    while (len) {
+        uint64_t page_off = addr & (MEM_PAGE_SIZE - 1);
+        size_t n = (len < MEM_PAGE_SIZE - page_off) ? len : (size_t)(MEM_PAGE_SIZE - page_off);
+        mem_page_t *page = mem_find_page(addr >> MEM_PAGE_SHIFT);
+
+        if (page) { memcpy(dst, &page->data[page_off], n); }
+        else      { memset(dst, 0, n); }
+        dst += n;
+        addr += n;
+        len -= n;
+    }
+    pthread_mutex_unlock(&mem.lock);
+
+    return 0; // Read successful
+}
+
+/**
+  * @brief Writes a block of bytes to the memory.
+  *
+  * @param addr - The memory address where the data should be written.
+  * @param buf - The data to write.
+  * @param len - The number of bytes to write.
+  * @return 0 if the write was successful, BUS_ERROR if the block covers the
+  *         bus error address or the memory is full.
+ **/
+uint8_t write_memory_block(uint64_t addr, const void *buf, size_t len) {
+    const uint8_t *src = buf;
+    uint8_t status = 0;
+
+    if (len && (bus_error >= addr) && (bus_error - addr < len)) { return BUS_ERROR; }
+
+    pthread_mutex_lock(&mem.lock);
+    while (len) {
+        uint64_t page_off = addr & (MEM_PAGE_SIZE - 1);
+        size_t n = (len < MEM_PAGE_SIZE - page_off) ? len : (size_t)(MEM_PAGE_SIZE - page_off);
+        mem_page_t *page = mem_get_page(addr >> MEM_PAGE_SHIFT);
+
+        if (!page) { status = BUS_ERROR; break; }
+        memcpy(&page->data[page_off], src, n);
+        src += n;
+        addr += n;
+        len -= n;
     }
+    pthread_mutex_unlock(&mem.lock);
 
-    return 0; // Memory allocation successful
+    return status;
 }
 
 /**
@@ -45,12 +207,12 @@ int create_memory(uint8_t mem_gb) {
   * @return 0 if the read was successful, BUS_ERROR if the address corresponds to a bus error.
  **/
 uint8_t read_memory(uint64_t addr, uint8_t size, uint64_t *data) {
-    uint64_t readData;
+    uint64_t readData = 0;
     // Validate address against bus_error
     if (addr == bus_error) { return BUS_ERROR; }
 
     // Perform memory read
-    memcpy(&readData, &memory[addr], size);
+    read_memory_block(addr, &readData, size);
 
     if (size == 4) { *data = (readData & (uint64_t)0xFFFFFFFF); }
     else { *data = readData; }
@@ -75,9 +237,7 @@ uint8_t write_memory(uint64_t *data, uint64_t addr, uint32_t size) {
     else { modifiedData = *data; }
 
     // Perform memory write
-    memcpy(&memory[addr], &modifiedData, size);
-
-    return 0; // Write successful
+    return write_memory_block(addr, &modifiedData, size);
 }
 
 /**
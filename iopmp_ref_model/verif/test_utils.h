@@ -53,11 +53,13 @@
 #define SEXE 0x400
 
 extern int test_num;
-extern int8_t *memory;
 extern uint64_t bus_error;
 
 extern int create_memory(uint8_t mem_gb);
+extern void destroy_memory(void);
 extern uint8_t read_memory(uint64_t addr, uint8_t size, uint64_t *data);
+extern uint8_t read_memory_block(uint64_t addr, void *buf, size_t len);
+extern uint8_t write_memory_block(uint64_t addr, const void *buf, size_t len);
 extern void configure_srcmd_n(iopmp_dev_t *iopmp, uint8_t srcmd_reg, uint16_t srcmd_idx, reg_intf_dw data, uint8_t num_bytes);
 extern void configure_mdcfg_n(iopmp_dev_t *iopmp, uint8_t md_idx, reg_intf_dw data, uint8_t num_bytes);
 extern void configure_entry_n(iopmp_dev_t *iopmp, uint8_t entry_reg, uint64_t entry_idx, reg_intf_dw data, uint8_t num_bytes);
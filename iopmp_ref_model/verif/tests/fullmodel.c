@@ -11,6 +11,8 @@
 // Max Supported MDs: 63
 ***************************************************************************/
 
+#include <pthread.h>
+#include <unistd.h>
 #include "iopmp.h"
 #include "config.h"
 #include "test_utils.h"
@@ -20,6 +22,88 @@ iopmp_trans_req_t iopmp_trans_req;
 iopmp_trans_rsp_t iopmp_trans_rsp;
 err_info_t err_info_temp;
 
+#if (SRC_ENFORCEMENT_EN == 0)
+// Arena for IOPMP instances, released as a whole
+typedef struct {
+    uint8_t buf[256 * 1024];
+    size_t used;
+} arena_t;
+
+static void *arena_alloc(void *ctx, size_t size, size_t align)
+{
+    arena_t *arena = ctx;
+    size_t offset = ALIGNUP(arena->used + ((uintptr_t)arena->buf % align), align) -
+                    ((uintptr_t)arena->buf % align);
+
+    if (offset + size > sizeof(arena->buf))
+        return NULL;
+    arena->used = offset + size;
+    return arena->buf + offset;
+}
+
+static arena_t arena;
+#endif
+
+#if (SRC_ENFORCEMENT_EN == 0)
+// Queries the stall status of an RRID through RRIDSCP
+static uint8_t query_rrid_stall(iopmp_dev_t *iopmp, uint16_t rrid)
+{
+    rridscp_t rridscp;
+
+    write_register(iopmp, RRIDSCP_OFFSET, rrid, 4);    // RRIDSCP.op = 0 (query)
+    rridscp.raw = read_register(iopmp, RRIDSCP_OFFSET, 4);
+    return rridscp.stat;
+}
+#endif
+
+#if (SRC_ENFORCEMENT_EN == 0) && (STALL_BUF_DEPTH != 0)
+// Transactions released from the stall buffer, see stall_release()
+typedef struct {
+    int num;
+    iopmp_trans_req_t reqs[STALL_BUF_DEPTH];
+    iopmp_trans_rsp_t rsps[STALL_BUF_DEPTH];
+} stall_release_log_t;
+
+// Records a transaction released from the stall buffer
+static void stall_release(void *ctx, const iopmp_trans_req_t *req,
+                          const iopmp_trans_rsp_t *rsp, uint8_t intrpt)
+{
+    stall_release_log_t *log = ctx;
+
+    (void)intrpt;
+    log->reqs[log->num] = *req;
+    log->rsps[log->num] = *rsp;
+    log->num++;
+}
+#endif
+
+#if (SRC_ENFORCEMENT_EN == 0) && (CONCURRENT_CHECK_EN == 1)
+#define NUM_CHECK_THREADS   4
+
+// Arguments of check_thread()
+typedef struct {
+    iopmp_dev_t *iopmp;
+    uint16_t rrid;
+    int faults;                         // Transactions returning a bus error
+} check_thread_arg_t;
+
+// Checks read accesses of one RRID
+static void *check_thread(void *p)
+{
+    check_thread_arg_t *arg = p;
+    iopmp_trans_req_t req;
+    iopmp_trans_rsp_t rsp;
+    uint8_t intrpt;
+
+    for (int i = 0; i < 1000; i++) {
+        receiver_port(arg->rrid, 0x2000 + (8 * (i % 64)), 0, 3, READ_ACCESS, 0, &req);
+        iopmp_validate_access(arg->iopmp, &req, &rsp, &intrpt);
+        arg->faults += (rsp.status == IOPMP_ERROR);
+    }
+    return NULL;
+}
+#endif
+
 int main()
 {
     // Create IOPMP instance
@@ -188,6 +272,26 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
+    START_TEST("Test NA4 - Partial hit on a priority rule after non-matching entries");
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4); // SRCMD_EN[2] is associated with MD[3]
+    configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x10, 4);  // SRCMD_R[2] is associated with MD[3]
+    configure_mdcfg_n(&iopmp, 3, 14, 4);             // MDCFG[3].t contains 14
+    configure_entry_n(&iopmp, ENTRY_ADDR, 5, 100 >> 2, 4);
+    configure_entry_n(&iopmp, ENTRY_CFG, 5, (NA4 | R), 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 12, 364 >> 2, 4);
+    configure_entry_n(&iopmp, ENTRY_CFG, 12, (NA4 | R), 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 13, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 13, (NAPOT | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(2, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+    // requestor Port Signals
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, PARTIAL_HIT_ON_PRIORITY);
+    FAIL_IF((iopmp.reg_file.err_reqid.eid != 12));
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    END_TEST();
+
     START_TEST_IF(iopmp.reg_file.hwcfg0.tor_en, "Test TOR - 4Byte Read Access",
     reset_iopmp(&iopmp, &cfg);
     configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4); // SRCMD_EN[2] is associated with MD[3]
@@ -282,6 +386,23 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
+    START_TEST_IF(iopmp.reg_file.hwcfg0.tor_en,
+                  "Test TOR - Updating ENTRY_ADDR of the previous entry",
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4); // SRCMD_EN[2] is associated with MD[3]
+    configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x10, 4);  // SRCMD_R[2] is associated with MD[3]
+    configure_mdcfg_n(&iopmp, 3, 2, 4);              // MDCFG[3].t contains 2
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 368 >> 2, 4);
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (TOR | R), 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 0, 368 >> 2, 4); // TOR range of IOPMP_ENTRY[1] becomes empty
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(2, 364, 0, 2, READ_ACCESS, 0, &iopmp_trans_req);
+    // requestor Port Signals
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, NOT_HIT_ANY_RULE);
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    END_TEST();)
+
     START_TEST("Test NA4 - 4Byte Read Access");
     reset_iopmp(&iopmp, &cfg);
     configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
@@ -481,6 +602,54 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();
 
+    START_TEST_IF(iopmp.reg_file.hwcfg2.sps_en, "Test NAPOT - Revoking SRCMD_R of the MD",
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_R, 32, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(32, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+    // requestor Port Signals
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    configure_srcmd_n(&iopmp, SRCMD_R, 32, 0x0, 4);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, ILLEGAL_READ_ACCESS);
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    END_TEST();)
+
+#if (DECISION_CACHE_EN == 1) && (HIT_STATS_EN == 0)
+    START_TEST("Test NAPOT - Cached decisions of repeated accesses");
+    iopmp_decision_cache_stats_t dc_stats;
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_R, 32, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 0x41F, 4); // 256 Bytes at 0x1000
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(32, 0x1010, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    // Another access within the same block is decided by the cache
+    receiver_port(32, 0x1020, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    iopmp_get_decision_cache_stats(&iopmp, &dc_stats);
+    FAIL_IF((dc_stats.hits != 1));
+    // Reprogramming the entry invalidates the cached decision
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, NAPOT, 4);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, ILLEGAL_READ_ACCESS);
+    iopmp_get_decision_cache_stats(&iopmp, &dc_stats);
+    FAIL_IF((dc_stats.hits != 1));
+    FAIL_IF((dc_stats.invalidations == 0));
+    write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);
+    END_TEST();
+#endif
+
     START_TEST("Test NAPOT - 8 Byte read access error");
     reset_iopmp(&iopmp, &cfg);
     configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
@@ -496,6 +665,40 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();
 
+    START_TEST("Test NAPOT - Batch of read and write accesses");
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_R, 32, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    {
+        uint64_t batch_addr[3]   __attribute__((aligned(64))) = {360, 368, 360};
+        uint32_t batch_length[3] __attribute__((aligned(64))) = {0, 0, 0};
+        uint32_t batch_size[3]   __attribute__((aligned(64))) = {3, 2, 3};
+        uint16_t batch_rrid[3]   __attribute__((aligned(64))) = {32, 32, 32};
+        uint8_t  batch_perm[3]   __attribute__((aligned(64))) = {READ_ACCESS, READ_ACCESS, WRITE_ACCESS};
+        bool     batch_is_amo[3] __attribute__((aligned(64))) = {0, 0, 0};
+        iopmp_trans_req_batch_t batch = {batch_addr, batch_length, batch_size,
+                                         batch_rrid, batch_perm, batch_is_amo};
+        iopmp_trans_rsp_t batch_rsp[3];
+        uint8_t batch_intrpt[3];
+
+        iopmp_validate_access_batch(&iopmp, &batch, batch_rsp, batch_intrpt, 3);
+        FAIL_IF((batch_rsp[0].status != IOPMP_SUCCESS));
+        FAIL_IF((batch_rsp[1].status != IOPMP_ERROR));
+        FAIL_IF((batch_rsp[2].status != IOPMP_ERROR));
+        // The first failing request of the batch is captured
+        err_info_temp.raw = read_register(&iopmp, ERR_INFO_OFFSET, 4);
+        FAIL_IF((err_info_temp.v != 1));
+        FAIL_IF((err_info_temp.ttype != READ_ACCESS));
+        FAIL_IF((err_info_temp.etype != NOT_HIT_ANY_RULE));
+        FAIL_IF((read_register(&iopmp, ERR_REQADDR_OFFSET, 4) != (368 >> 2)));
+    }
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    END_TEST();
+
     START_TEST("Test NAPOT - 8 Byte write access error");
     reset_iopmp(&iopmp, &cfg);
     configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
@@ -597,6 +800,33 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
+    START_TEST_IF(iopmp.reg_file.hwcfg2.non_prio_en,
+                  "Test NAPOT - Overlapping non-priority Entries deny access",
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x20, 4);
+    configure_srcmd_n(&iopmp, SRCMD_X, 32, 0x20, 4);
+    configure_mdcfg_n(&iopmp, 3, 17, 4);
+    configure_mdcfg_n(&iopmp, 4, 25, 4);
+    // Program the higher entry first, the lowest index is still reported
+    configure_entry_n(&iopmp, ENTRY_ADDR, 22, 91, 4); // 32 bytes from 352
+    configure_entry_n(&iopmp, ENTRY_CFG, 22, (NAPOT | R), 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 19, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 19, (NAPOT | R), 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 21, 91, 4); // Partial hit is ignored
+    configure_entry_n(&iopmp, ENTRY_CFG, 21, (NA4 | X), 4);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(32, 360, 0, 3, INSTR_FETCH, 0, &iopmp_trans_req);
+    // requestor Port Signals
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, ILLEGAL_INSTR_FETCH);
+    FAIL_IF((iopmp.reg_file.err_reqid.eid != 19));
+    write_register(&iopmp, ERR_INFO_OFFSET, 1, 4); // Clear ERR_INFO.v
+    // Granting entry among the covering entries
+    configure_entry_n(&iopmp, ENTRY_CFG, 22, (NAPOT | X), 4);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    END_TEST();)
+
     START_TEST("Test NAPOT - 8 Byte Instruction access when xinr=1");
     cfg.xinr = true;
     reset_iopmp(&iopmp, &cfg);
@@ -679,6 +909,138 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();
 
+    START_TEST("Test SRCMD_EN and MDCFG, reprogramming MD association");
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_X, 2, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | X), 4);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(2, 360, 0, 3, INSTR_FETCH, 0, &iopmp_trans_req);
+    // requestor Port Signals
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x0, 4);   // RRID 2 is no longer associated with MD[3]
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, NOT_HIT_ANY_RULE);
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 2, 2, 4);              // MD[3] owns no entry, MD[2] owns IOPMP_ENTRY[0-1]
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, NOT_HIT_ANY_RULE);
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    END_TEST();
+
+    START_TEST("Test instance sized for a small configuration in an arena");
+    iopmp_allocator_t arena_allocator = { .alloc = arena_alloc, .free = NULL, .ctx = &arena };
+    iopmp_cfg_t small_cfg = cfg;
+    iopmp_dev_t *small_iopmp;
+    small_cfg.rrid_num   = 4;
+    small_cfg.entry_num  = 16;
+    small_cfg.prio_entry = 4;
+    small_iopmp = iopmp_create(&small_cfg, &arena_allocator);
+    FAIL_IF((small_iopmp == NULL));
+    FAIL_IF((arena.used > (64 * 1024)));
+    configure_srcmd_n(small_iopmp, SRCMD_EN, 2, 0x10, 4);
+    configure_srcmd_n(small_iopmp, SRCMD_X, 2, 0x10, 4);
+    FAIL_IF((read_register(small_iopmp, SRCMD_TABLE_BASE_OFFSET + (2 * 32), 4) != 0x10));
+    configure_mdcfg_n(small_iopmp, 3, 2, 4);
+    configure_entry_n(small_iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(small_iopmp, ENTRY_CFG, 1, (NAPOT | X), 4);
+    set_hwcfg0_enable(small_iopmp);
+    receiver_port(2, 360, 0, 3, INSTR_FETCH, 0, &iopmp_trans_req);
+    iopmp_validate_access(small_iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(small_iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    // RRIDs and entries beyond the configuration are not implemented
+    receiver_port(4, 360, 0, 3, INSTR_FETCH, 0, &iopmp_trans_req);
+    iopmp_validate_access(small_iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(small_iopmp, IOPMP_ERROR, UNKNOWN_RRID);
+    FAIL_IF((read_entry_n(small_iopmp, ENTRY_CFG, 16, 4) != 0));
+    iopmp_destroy(small_iopmp);
+    END_TEST();
+
+    START_TEST("Test checkpoint and restore of the IOPMP state");
+    iopmp_checkpoint_t *ckpt;
+    iopmp_dev_t *clone;
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_X, 2, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | X), 4);
+    set_hwcfg0_enable(&iopmp);
+    ckpt = iopmp_checkpoint(&iopmp);
+    FAIL_IF((ckpt == NULL));
+    // Reprogram and lock the entry, and record two violations
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+    write_register(&iopmp, ENTRYLCK_OFFSET, 0x4, 4); // ENTRY[0]-ENTRY[1] are locked
+    receiver_port(2, 360, 0, 3, INSTR_FETCH, 0, &iopmp_trans_req);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, ILLEGAL_INSTR_FETCH);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    FAIL_IF((iopmp.err_svs.sv[0].raw == 0));
+    FAIL_IF((iopmp_restore(&iopmp, ckpt) < 0));
+    FAIL_IF((read_register(&iopmp, ENTRYLCK_OFFSET, 4) != 0));
+    FAIL_IF(((read_register(&iopmp, ERR_INFO_OFFSET, 4) & 1) != 0));
+    FAIL_IF((iopmp.err_svs.sv[0].raw != 0));
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    // Stall the RRID, then restore the same checkpoint again
+    write_register(&iopmp, MDSTALL_OFFSET, 0x10, 4);
+    FAIL_IF((iopmp_restore(&iopmp, ckpt) < 0));
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    FAIL_IF((iopmp_trans_rsp.rrid_stalled != 0));
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_SUCCESS, ENTRY_MATCH);
+    // Another instance takes the whole state
+    clone = iopmp_create(&cfg, NULL);
+    FAIL_IF((clone == NULL));
+    FAIL_IF((iopmp_restore(clone, ckpt) < 0));
+    iopmp_validate_access(clone, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(clone, IOPMP_SUCCESS, ENTRY_MATCH);
+    FAIL_IF((read_entry_n(clone, ENTRY_CFG, 1, 4) != (NAPOT | X)));
+    iopmp_destroy(clone);
+    iopmp_checkpoint_free(ckpt);
+    END_TEST();
+
+    START_TEST("Test block register writes in a programming session");
+    static const reg_intf_dw mdcfg_block[] = { 8, 4, 12, 2 };
+    iopmp_dev_t *session_iopmp = iopmp_create(&cfg, NULL);
+    FAIL_IF((session_iopmp == NULL));
+    // Program one instance register by register
+    reset_iopmp(&iopmp, &cfg);
+    set_hwcfg0_enable(&iopmp);
+    for (int m = 0; m < 4; m++) {
+        configure_mdcfg_n(&iopmp, m, mdcfg_block[m], 4);
+    }
+    configure_mdcfg_n(&iopmp, 1, 3, 4);
+    configure_mdcfg_n(&iopmp, 0, 2, 4);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+    write_register(&iopmp, MDSTALL_OFFSET, 0x10, 4);    // Stall MD[3]
+    configure_srcmd_n(&iopmp, SRCMD_EN, 5, 0x10, 4);    // Not stalled until the next MDSTALL write
+    // Program the other one in a session
+    iopmp_program_begin(session_iopmp);
+    set_hwcfg0_enable(session_iopmp);
+    write_register_block(session_iopmp, MDCFG_TABLE_BASE_OFFSET, mdcfg_block, 4, 4);
+    configure_mdcfg_n(session_iopmp, 1, 3, 4);
+    configure_mdcfg_n(session_iopmp, 0, 2, 4);
+    configure_srcmd_n(session_iopmp, SRCMD_EN, 2, 0x10, 4);
+    write_register(session_iopmp, MDSTALL_OFFSET, 0x10, 4);
+    configure_srcmd_n(session_iopmp, SRCMD_EN, 5, 0x10, 4);
+    iopmp_program_commit(session_iopmp);
+    for (int m = 0; m < 4; m++) {
+        FAIL_IF((read_register(session_iopmp, MDCFG_TABLE_BASE_OFFSET + (m * 4), 4) !=
+                 read_register(&iopmp, MDCFG_TABLE_BASE_OFFSET + (m * 4), 4)));
+    }
+    FAIL_IF((read_register(session_iopmp, MDCFG_TABLE_BASE_OFFSET + 4, 4) != 8));
+    FAIL_IF((read_register(session_iopmp, MDCFG_TABLE_BASE_OFFSET + 12, 4) != 12));
+    FAIL_IF((query_rrid_stall(&iopmp, 2) != 1));
+    FAIL_IF((query_rrid_stall(&iopmp, 5) != 2));
+    FAIL_IF((query_rrid_stall(session_iopmp, 2) != 1));
+    FAIL_IF((query_rrid_stall(session_iopmp, 5) != 2));
+    iopmp_destroy(session_iopmp);
+    END_TEST();
+
     START_TEST("Test Entry_LCK, updating locked ENTRY field");
     reset_iopmp(&iopmp, &cfg);
     write_register(&iopmp, ENTRYLCK_OFFSET, 0x8, 4); // ENTRY[0]-ENTRY[3] are locked
@@ -821,6 +1183,47 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
+#if (CONCURRENT_CHECK_EN == 1)
+    START_TEST_IF(iopmp.reg_file.hwcfg2.mfr_en, "Test MFR Extension with concurrent checks",
+    pthread_t threads[NUM_CHECK_THREADS];
+    check_thread_arg_t args[NUM_CHECK_THREADS];
+    err_mfr_t err_mfr_temp;
+    reset_iopmp(&iopmp, &cfg);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    for (int i = 0; i < NUM_CHECK_THREADS; i++) {
+        configure_srcmd_n(&iopmp, SRCMD_EN, i + 1, 0x10, 4);
+        args[i].iopmp  = &iopmp;
+        args[i].rrid   = i + 1;
+        args[i].faults = 0;
+    }
+    set_hwcfg0_enable(&iopmp);
+    for (int i = 0; i < NUM_CHECK_THREADS; i++) {
+        pthread_create(&threads[i], NULL, check_thread, &args[i]);
+    }
+    // Reprogram an entry of an unrelated MD while the checks run
+    for (int i = 0; i < 100; i++) {
+        configure_entry_n(&iopmp, ENTRY_ADDR, 100, i, 4);
+    }
+    for (int i = 0; i < NUM_CHECK_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        FAIL_IF((args[i].faults != 1000));
+    }
+    err_info_temp.raw = read_register(&iopmp, ERR_INFO_OFFSET, 4);
+    FAIL_IF((err_info_temp.v != 1));
+    FAIL_IF((err_info_temp.etype != NOT_HIT_ANY_RULE));
+    FAIL_IF((err_info_temp.svc != 1));
+    FAIL_IF((iopmp.reg_file.err_reqid.rrid < 1) || (iopmp.reg_file.err_reqid.rrid > NUM_CHECK_THREADS));
+    // Every RRID records subsequent violations
+    err_mfr_temp.raw = read_register(&iopmp, ERR_MFR_OFFSET, 4);
+    FAIL_IF((err_mfr_temp.svi != 0));
+    FAIL_IF((err_mfr_temp.svs != 1));
+    FAIL_IF((err_mfr_temp.svw != 0x1E));
+    err_info_temp.raw = read_register(&iopmp, ERR_INFO_OFFSET, 4);
+    FAIL_IF((err_info_temp.svc != 0));
+    write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);
+    END_TEST();)
+#endif
+
     START_TEST_IF(iopmp.imp_mdlck, "Test MDLCK, updating locked srcmd_enh field",
     reset_iopmp(&iopmp, &cfg);
     write_register(&iopmp, MDLCKH_OFFSET, 0x1, 4);
@@ -1036,6 +1439,300 @@ int main()
     END_TEST();)
 #endif
 
+    START_TEST_IF(iopmp.reg_file.hwcfg2.stall_en && iopmp.imp_rridscp, "Stall MD Feature, RRIDs sharing MDs",
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);    // RRID 2 and 5 are in MD[3]
+    configure_srcmd_n(&iopmp, SRCMD_EN, 5, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 7, 0x20, 4);    // RRID 7 is in MD[4]
+    configure_srcmd_n(&iopmp, SRCMD_ENH, 63, 0x1, 4);   // RRID 63 is in MD[31]
+    write_register(&iopmp, MDSTALL_OFFSET, 0x10, 4);
+    FAIL_IF((query_rrid_stall(&iopmp, 2) != 1));
+    FAIL_IF((query_rrid_stall(&iopmp, 5) != 1));
+    FAIL_IF((query_rrid_stall(&iopmp, 7) != 2));
+    FAIL_IF((query_rrid_stall(&iopmp, 63) != 2));
+    configure_srcmd_n(&iopmp, SRCMD_EN, 5, 0x20, 4);    // RRID 5 moves to MD[4]
+    write_register(&iopmp, MDSTALL_OFFSET, 0x10, 4);
+    FAIL_IF((query_rrid_stall(&iopmp, 2) != 1));
+    FAIL_IF((query_rrid_stall(&iopmp, 5) != 2));
+    write_register(&iopmp, MDSTALLH_OFFSET, 0x1, 4);    // Stall MD[31] too
+    write_register(&iopmp, MDSTALL_OFFSET, 0x11, 4);    // Exempt MD[3] and MD[31]
+    FAIL_IF((query_rrid_stall(&iopmp, 2) != 2));
+    FAIL_IF((query_rrid_stall(&iopmp, 5) != 1));
+    FAIL_IF((query_rrid_stall(&iopmp, 7) != 1));
+    FAIL_IF((query_rrid_stall(&iopmp, 63) != 2));
+    write_register(&iopmp, MDSTALLH_OFFSET, 0, 4);
+    write_register(&iopmp, MDSTALL_OFFSET, 0, 4);
+    FAIL_IF((query_rrid_stall(&iopmp, 2) != 2));
+    FAIL_IF((query_rrid_stall(&iopmp, 7) != 2));
+    END_TEST();)
+
+#if (STALL_BUF_DEPTH != 0)
+    START_TEST("Test stall buffer replay on resume");
+    if (iopmp.reg_file.hwcfg2.stall_en && iopmp.imp_stall_buffer) {
+        stall_release_log_t log = {0};
+        reset_iopmp(&iopmp, &cfg);
+        iopmp_set_stall_release_callback(&iopmp, stall_release, &log);
+        configure_srcmd_n(&iopmp, SRCMD_EN, 5, 0x10, 4);    // RRID 5 is in MD[3]
+        configure_srcmd_n(&iopmp, SRCMD_R, 5, 0x10, 4);
+        configure_srcmd_n(&iopmp, SRCMD_EN, 7, 0x20, 4);    // RRID 7 is in MD[4]
+        configure_mdcfg_n(&iopmp, 3, 2, 4);
+        configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+        configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+        set_hwcfg0_enable(&iopmp);
+        write_register(&iopmp, MDSTALL_OFFSET, 0x10, 4);    // Stall MD[3]
+        receiver_port(5, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        FAIL_IF((iopmp_trans_rsp.rrid_stalled != 1));
+        receiver_port(5, 360, 0, 3, WRITE_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        FAIL_IF((iopmp_trans_rsp.rrid_stalled != 1));
+        receiver_port(7, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        FAIL_IF((iopmp_trans_rsp.rrid_stalled != 0));     // MD[4] is not stalled
+        write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);       // Clear ERR_INFO.v
+        FAIL_IF((iopmp.stall_cntr != 2));
+        FAIL_IF((log.num != 0));
+        // Resuming MD[3] releases the queued transactions in order
+        write_register(&iopmp, MDSTALL_OFFSET, 0, 4);
+        FAIL_IF((log.num != 2));
+        FAIL_IF((iopmp.stall_cntr != 0));
+        FAIL_IF((log.reqs[0].perm != READ_ACCESS));
+        FAIL_IF((log.rsps[0].status != IOPMP_SUCCESS));
+        FAIL_IF((log.reqs[1].perm != WRITE_ACCESS));
+        FAIL_IF((log.rsps[1].status != IOPMP_ERROR));
+        FAIL_IF((log.rsps[1].rrid != 5));
+        error_record_chk(&iopmp, ILLEGAL_WRITE_ACCESS, WRITE_ACCESS, 360, 1);
+        write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+        // RRIDSCP stalls and resumes RRID 5 alone
+        log.num = 0;
+        write_register(&iopmp, RRIDSCP_OFFSET, 5 | (1U << 30), 4);
+        receiver_port(5, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        FAIL_IF((iopmp_trans_rsp.rrid_stalled != 1));
+        FAIL_IF((log.num != 0));
+        write_register(&iopmp, RRIDSCP_OFFSET, 5 | (2U << 30), 4);
+        FAIL_IF((log.num != 1));
+        FAIL_IF((log.rsps[0].status != IOPMP_SUCCESS));
+        FAIL_IF((iopmp.stall_cntr != 0));
+        iopmp_set_stall_release_callback(&iopmp, NULL, NULL);
+    }
+    END_TEST();
+#endif
+
+#if (VIOLATION_LOG_EN == 1)
+    START_TEST("Test violation log");
+    {
+        static iopmp_violation_t records[VIOLATION_LOG_DEPTH];
+        uint64_t dropped;
+        size_t n;
+
+        reset_iopmp(&iopmp, &cfg);
+        configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+        configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x10, 4);
+        configure_mdcfg_n(&iopmp, 3, 2, 4);
+        configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+        configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+        set_hwcfg0_enable(&iopmp);
+        receiver_port(2, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);     // Legal
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        receiver_port(2, 360, 0, 3, WRITE_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        receiver_port(7, 0x1000, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        n = iopmp_violation_log_drain(&iopmp, records, 1, &dropped);
+        FAIL_IF((n != 1) || (dropped != 0));
+        FAIL_IF((records[0].seq != 0) || (records[0].rrid != 2) || (records[0].addr != 360));
+        FAIL_IF((records[0].perm != WRITE_ACCESS) || (records[0].etype != ILLEGAL_WRITE_ACCESS));
+        FAIL_IF((records[0].eid != 1) || !records[0].buserr);
+        n = iopmp_violation_log_drain(&iopmp, records, VIOLATION_LOG_DEPTH, &dropped);
+        FAIL_IF((n != 1) || (dropped != 0));
+        FAIL_IF((records[0].seq != 1) || (records[0].rrid != 7) || (records[0].addr != 0x1000));
+        FAIL_IF((records[0].etype != NOT_HIT_ANY_RULE));
+        FAIL_IF((iopmp_violation_log_drain(&iopmp, records, VIOLATION_LOG_DEPTH, NULL) != 0));
+
+        // The violations found while the log is full are only counted
+        for (int i = 0; i < VIOLATION_LOG_DEPTH + 3; i++) {
+            receiver_port(7, 0x1000 + (8 * i), 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+            iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        }
+        n = iopmp_violation_log_drain(&iopmp, records, VIOLATION_LOG_DEPTH, &dropped);
+        FAIL_IF((n != VIOLATION_LOG_DEPTH) || (dropped != 3));
+        FAIL_IF((records[0].seq != 2) || (records[n - 1].addr != 0x1000 + (8 * (n - 1))));
+        write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);
+    }
+    END_TEST();
+#endif
+
+#if (HIT_STATS_EN == 1)
+    START_TEST("Test entry hit and RRID scan counters");
+    {
+        iopmp_entry_stats_t entry_stats;
+        iopmp_rrid_stats_t rrid_stats;
+        char line[64];
+        bool found = false;
+        FILE *file;
+
+        reset_iopmp(&iopmp, &cfg);
+        configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+        configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x10, 4);
+        configure_mdcfg_n(&iopmp, 3, 2, 4);
+        configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+        configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+        set_hwcfg0_enable(&iopmp);
+        for (int i = 0; i < 2; i++) {
+            receiver_port(2, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);
+            iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        }
+        receiver_port(2, 360, 0, 3, WRITE_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);
+
+        FAIL_IF(iopmp_get_entry_stats(&iopmp, 1, &entry_stats) < 0);
+        FAIL_IF((entry_stats.matches != 3) || (entry_stats.grants != 2) || (entry_stats.denials != 1));
+        FAIL_IF(iopmp_get_rrid_stats(&iopmp, 2, &rrid_stats) < 0);
+        FAIL_IF((rrid_stats.transactions != 3) || (rrid_stats.entries_scanned < 3) ||
+                (rrid_stats.mds_visited < 3));
+        FAIL_IF(iopmp_get_entry_stats(&iopmp, iopmp.reg_file.hwcfg1.entry_num, &entry_stats) == 0);
+
+        file = tmpfile();
+        FAIL_IF(!file || (iopmp_dump_stats(&iopmp, file, IOPMP_STATS_CSV) < 0));
+        rewind(file);
+        while (fgets(line, sizeof(line), file))
+            found |= (strcmp(line, "1,3,2,1,0\n") == 0);
+        fclose(file);
+        FAIL_IF(!found);
+
+        iopmp_clear_stats(&iopmp);
+        iopmp_get_rrid_stats(&iopmp, 2, &rrid_stats);
+        FAIL_IF(rrid_stats.transactions != 0);
+    }
+    END_TEST();
+#endif
+
+    START_TEST("Test entry advisor");
+    {
+        iopmp_trans_req_t trace[11];
+        iopmp_entry_advice_t advice;
+        iopmp_checkpoint_t *ckpt;
+        char line[128];
+        bool found = false;
+        FILE *file;
+        uint64_t synced;
+
+        // MD 1 holds entries 16 to 19, the busiest one last
+        reset_iopmp(&iopmp, &cfg);
+        configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x4, 4);
+        configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x4, 4);
+        configure_mdcfg_n(&iopmp, 0, 16, 4);
+        for (int m = 1; m < 63; m++)
+            configure_mdcfg_n(&iopmp, m, 20, 4);
+        configure_entry_n(&iopmp, ENTRY_ADDR, 17, 0x41F, 4); // 256 Bytes at 0x1000
+        configure_entry_n(&iopmp, ENTRY_CFG, 17, (NAPOT | R), 4);
+        configure_entry_n(&iopmp, ENTRY_ADDR, 19, 0x81F, 4); // 256 Bytes at 0x2000
+        configure_entry_n(&iopmp, ENTRY_CFG, 19, (NAPOT | R), 4);
+        set_hwcfg0_enable(&iopmp);
+        receiver_port(2, 0x1000, 0, 3, READ_ACCESS, 0, &trace[0]);
+        for (int i = 1; i < 10; i++)
+            receiver_port(2, 0x2000 + (8 * i), 0, 3, READ_ACCESS, 0, &trace[i]);
+        receiver_port(2, 0x2000, 0, 3, WRITE_ACCESS, 0, &trace[10]);
+
+        ckpt = iopmp_checkpoint(&iopmp);
+        FAIL_IF(!ckpt);
+        synced = iopmp.checkpoint.synced;
+        FAIL_IF(iopmp_advise_entries(&iopmp, trace, 11, &advice) < 0);
+        FAIL_IF((advice.scanned != 42) || (advice.scanned_advised != 13));
+        FAIL_IF((advice.prio_entry != 16) || (advice.order[15] != 15));
+        FAIL_IF((advice.order[16] != 19) || (advice.order[17] != 17) || (advice.order[20] != 20));
+        FAIL_IF((advice.mdcfg_t[0] != 16) || (advice.mdcfg_t[1] != 18) || (advice.mdcfg_t[62] != 18));
+        // The instance itself is unchanged
+        FAIL_IF((iopmp.reg_file.mdcfg[1].t != 20) || iopmp.reg_file.err_info.v);
+        // and stays in sync with the checkpoint of the caller
+        FAIL_IF(iopmp.checkpoint.synced != synced);
+        iopmp_checkpoint_free(ckpt);
+
+        file = tmpfile();
+        FAIL_IF(!file || (iopmp_emit_entry_advice(&iopmp, &advice, file, "advised") < 0));
+        rewind(file);
+        while (fgets(line, sizeof(line), file))
+            found |= (strstr(line, "{ .addr = 0x81f, .cfg = 0x") != NULL);
+        fclose(file);
+        FAIL_IF(!found);
+        iopmp_entry_advice_free(&advice);
+    }
+    END_TEST();
+
+#if (TRACE_EN == 1)
+    START_TEST("Test trace record and replay");
+    {
+        iopmp_trace_replay_stats_t replay;
+        iopmp_trace_header_t header;
+        iopmp_trace_record_t *records;
+        FILE *file = tmpfile();
+        size_t size;
+        void *trace;
+
+        reset_iopmp(&iopmp, &cfg);
+        FAIL_IF(!file || (iopmp_trace_record_start(&iopmp, file) < 0));
+        FAIL_IF(iopmp_trace_record_start(&iopmp, file) == 0);
+        configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+        configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x10, 4);
+        configure_mdcfg_n(&iopmp, 3, 2, 4);
+        configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+        configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+        set_hwcfg0_enable(&iopmp);
+        receiver_port(2, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);     // Legal
+        intrpt = 1;     // Left over by the caller, it isn't recorded
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        FAIL_IF(intrpt != 0);
+        receiver_port(2, 360, 0, 3, WRITE_ACCESS, 0, &iopmp_trans_req);
+        iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+        FAIL_IF(!read_register(&iopmp, ERR_INFO_OFFSET, 4));
+        write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);
+        FAIL_IF(iopmp_trace_record_stop(&iopmp) < 0);
+
+        rewind(file);
+        FAIL_IF(fread(&header, sizeof(header), 1, file) != 1);
+        FAIL_IF(memcmp(header.magic, "IOPMPTRC", 8) || (header.num_records == 0));
+
+        // Replaying on the instance reset again gets the recorded results. The
+        // reads are HWCFG0 by set_hwcfg0_enable() and ERR_INFO
+        reset_iopmp(&iopmp, &cfg);
+        FAIL_IF(iopmp_trace_replay_file(&iopmp, file, &replay) < 0);
+        FAIL_IF((replay.transactions != 2) || (replay.reads != 2) || (replay.mismatches != 0));
+        FAIL_IF((replay.writes + replay.reads + replay.transactions) != header.num_records);
+
+        // A response differing from the recorded one is reported
+        size  = sizeof(header) + (header.num_records * sizeof(iopmp_trace_record_t));
+        trace = malloc(size);
+        rewind(file);
+        FAIL_IF(!trace || (fread(trace, size, 1, file) != 1));
+        records = (iopmp_trace_record_t *)((iopmp_trace_header_t *)trace + 1);
+        for (uint64_t i = 0; i < header.num_records; i++) {
+            if (records[i].kind == IOPMP_TRACE_TRANS) {
+                records[i].flags ^= IOPMP_TRACE_ERROR;
+                break;
+            }
+        }
+        reset_iopmp(&iopmp, &cfg);
+        FAIL_IF(iopmp_trace_replay(&iopmp, trace, size, &replay) < 0);
+        FAIL_IF((replay.mismatches != 1) || (records[replay.first_mismatch].kind != IOPMP_TRACE_TRANS));
+        free(trace);
+
+        // A reset ends the recording with a complete header
+        rewind(file);
+        FAIL_IF(iopmp_trace_record_start(&iopmp, file) < 0);
+        read_register(&iopmp, HWCFG0_OFFSET, 4);
+        reset_iopmp(&iopmp, &cfg);
+        read_register(&iopmp, HWCFG0_OFFSET, 4);
+        FAIL_IF(iopmp_trace_record_stop(&iopmp) == 0);
+        rewind(file);
+        FAIL_IF(fread(&header, sizeof(header), 1, file) != 1);
+        FAIL_IF(header.num_records != 1);
+        fclose(file);
+    }
+    END_TEST();
+#endif
+
     START_TEST_IF(iopmp.reg_file.hwcfg3.rrid_transl_en, "Test Cascading IOPMP Feature",
     reset_iopmp(&iopmp, &cfg);
     configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
@@ -1053,6 +1750,137 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
+    START_TEST("Test cascade of two IOPMPs");
+    iopmp_dev_t *stage1 = iopmp_create(&cfg, NULL);
+    FAIL_IF((stage1 == NULL));
+    // Stage 0 grants RRID 32 to read and write, and tags it with RRID 48
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 32, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_R, 32, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_W, 32, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | W | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    // Stage 1 only grants RRID 48 to read
+    configure_srcmd_n(stage1, SRCMD_EN, 48, 0x10, 4);
+    configure_srcmd_n(stage1, SRCMD_R, 48, 0x10, 4);
+    configure_mdcfg_n(stage1, 3, 2, 4);
+    configure_entry_n(stage1, ENTRY_ADDR, 1, 90, 4);
+    configure_entry_n(stage1, ENTRY_CFG, 1, (NAPOT | R), 4);
+    set_hwcfg0_enable(stage1);
+    {
+        iopmp_dev_t *stages[2] = {&iopmp, stage1};
+        iopmp_cascade_t cascade = {stages, 2};
+        iopmp_trans_rsp_t stage_rsp[2 * 3];
+        uint8_t stage_intrpt[2 * 3];
+        uint32_t stages_checked[3];
+        uint64_t batch_addr[3]   __attribute__((aligned(64))) = {360, 360, 360};
+        uint32_t batch_length[3] __attribute__((aligned(64))) = {0, 0, 0};
+        uint32_t batch_size[3]   __attribute__((aligned(64))) = {3, 3, 3};
+        uint16_t batch_rrid[3]   __attribute__((aligned(64))) = {32, 32, 33};
+        uint8_t  batch_perm[3]   __attribute__((aligned(64))) = {READ_ACCESS, WRITE_ACCESS, READ_ACCESS};
+        bool     batch_is_amo[3] __attribute__((aligned(64))) = {0, 0, 0};
+        iopmp_trans_req_batch_t batch = {batch_addr, batch_length, batch_size,
+                                         batch_rrid, batch_perm, batch_is_amo};
+
+        if (iopmp.reg_file.hwcfg3.rrid_transl_en) {
+            // The write is granted by stage 0 and faulted by stage 1
+            receiver_port(32, 360, 0, 3, WRITE_ACCESS, 0, &iopmp_trans_req);
+            FAIL_IF((iopmp_cascade_validate(&cascade, &iopmp_trans_req, stage_rsp, stage_intrpt) != 2));
+            FAIL_IF((stage_rsp[0].status != IOPMP_SUCCESS));
+            FAIL_IF((stage_rsp[0].rrid_transl != 48));
+            FAIL_IF((stage_rsp[1].rrid != 48));
+            FAIL_IF((stage_rsp[1].status != IOPMP_ERROR));
+            FAIL_IF((error_record_chk(stage1, ILLEGAL_WRITE_ACCESS, WRITE_ACCESS, 360, 1) != 0));
+            write_register(stage1, ERR_INFO_OFFSET, 0, 4);
+
+            iopmp_cascade_validate_batch(&cascade, &batch, stage_rsp, stage_intrpt, stages_checked, 3);
+            FAIL_IF((stages_checked[0] != 2) || (stage_rsp[3].status != IOPMP_SUCCESS));
+            FAIL_IF((stages_checked[1] != 2) || (stage_rsp[4].status != IOPMP_ERROR));
+            // RRID 33 is faulted by stage 0 and never reaches stage 1
+            FAIL_IF((stages_checked[2] != 1) || (stage_rsp[2].status != IOPMP_ERROR));
+            FAIL_IF((error_record_chk(&iopmp, NOT_HIT_ANY_RULE, READ_ACCESS, 360, 1) != 0));
+        }
+    }
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    write_register(stage1, ERR_INFO_OFFSET, 0, 4);
+    iopmp_destroy(stage1);
+    END_TEST();
+
+    START_TEST("Test fabric of two IOPMPs sharding RRIDs");
+    iopmp_dev_t *shard1 = iopmp_create(&cfg, NULL);
+    FAIL_IF((shard1 == NULL));
+    // Shard 0 grants RRID 2 to read, shard 1 owns RRIDs 64-127 and grants none
+    reset_iopmp(&iopmp, &cfg);
+    configure_srcmd_n(&iopmp, SRCMD_EN, 2, 0x10, 4);
+    configure_srcmd_n(&iopmp, SRCMD_R, 2, 0x10, 4);
+    configure_mdcfg_n(&iopmp, 3, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4); // (364 >> 2) and keeping lsb 0
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    set_hwcfg0_enable(shard1);
+    {
+        enum { FABRIC_REQS = 300 };
+        static const uint16_t fabric_rrids[3] = {2, 66, 200};
+        iopmp_dev_t *shards[2] = {&iopmp, shard1};
+        iopmp_fabric_route_t routes[2] = {
+            { .rrid_lo = 0,  .rrid_hi = 64,  .addr_lo = 0, .addr_hi = UINT64_MAX, .rrid_base = 0,  .instance = 0 },
+            { .rrid_lo = 64, .rrid_hi = 128, .addr_lo = 0, .addr_hi = UINT64_MAX, .rrid_base = 64, .instance = 1 },
+        };
+        static uint64_t fabric_addr[FABRIC_REQS]   __attribute__((aligned(64)));
+        static uint32_t fabric_length[FABRIC_REQS] __attribute__((aligned(64)));
+        static uint32_t fabric_size[FABRIC_REQS]   __attribute__((aligned(64)));
+        static uint16_t fabric_rrid[FABRIC_REQS]   __attribute__((aligned(64)));
+        static uint8_t  fabric_perm[FABRIC_REQS]   __attribute__((aligned(64)));
+        static bool     fabric_is_amo[FABRIC_REQS] __attribute__((aligned(64)));
+        static iopmp_trans_rsp_t seq_rsp[FABRIC_REQS], par_rsp[FABRIC_REQS];
+        static uint8_t seq_intrpt[FABRIC_REQS], par_intrpt[FABRIC_REQS];
+        static int32_t routed_to[FABRIC_REQS];
+        iopmp_trans_req_batch_t batch = {fabric_addr, fabric_length, fabric_size,
+                                         fabric_rrid, fabric_perm, fabric_is_amo};
+        iopmp_fabric_t *fabric;
+
+        for (int i = 0; i < FABRIC_REQS; i++) {
+            fabric_addr[i] = 360;
+            fabric_size[i] = 3;
+            fabric_rrid[i] = fabric_rrids[i % 3];
+            fabric_perm[i] = READ_ACCESS;
+        }
+
+        // The threaded fabric gives the same results as the unthreaded one
+        fabric = iopmp_fabric_create(shards, 2, routes, 2, false);
+        FAIL_IF((fabric == NULL));
+        iopmp_fabric_validate_batch(fabric, &batch, seq_rsp, seq_intrpt, routed_to, FABRIC_REQS);
+        iopmp_fabric_destroy(fabric);
+        FAIL_IF((error_record_chk(shard1, NOT_HIT_ANY_RULE, READ_ACCESS, 360, 1) != 0));
+        write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+        write_register(shard1, ERR_INFO_OFFSET, 0, 4);
+
+        // The workers block while they have no request
+        fabric = iopmp_fabric_create(shards, 2, routes, 2, true);
+        FAIL_IF((fabric == NULL));
+        usleep(20000);
+        iopmp_fabric_validate_batch(fabric, &batch, par_rsp, par_intrpt, NULL, FABRIC_REQS);
+        iopmp_fabric_destroy(fabric);
+        FAIL_IF((memcmp(seq_rsp, par_rsp, sizeof(seq_rsp)) != 0));
+        FAIL_IF((memcmp(seq_intrpt, par_intrpt, sizeof(seq_intrpt)) != 0));
+
+        FAIL_IF((routed_to[0] != 0) || (seq_rsp[0].status != IOPMP_SUCCESS));
+        FAIL_IF((routed_to[1] != 1) || (seq_rsp[1].status != IOPMP_ERROR));
+        FAIL_IF((seq_rsp[1].rrid != 66));
+        FAIL_IF((routed_to[2] != -1) || (seq_rsp[2].status != IOPMP_ERROR));
+        FAIL_IF((error_record_chk(shard1, NOT_HIT_ANY_RULE, READ_ACCESS, 360, 1) != 0));
+        FAIL_IF((error_record_chk(&iopmp, 0, 0, 0, 0) != 0));
+
+        // Two workers can't check the same instance
+        shards[1] = &iopmp;
+        FAIL_IF((iopmp_fabric_create(shards, 2, routes, 2, true) != NULL));
+    }
+    write_register(shard1, ERR_INFO_OFFSET, 0, 4);
+    iopmp_destroy(shard1);
+    END_TEST();
+
     START_TEST_IF(iopmp.reg_file.hwcfg2.msi_en, "Test MSI Write error",
     uint64_t read_data;
     reset_iopmp(&iopmp, &cfg);
@@ -1104,9 +1932,37 @@ int main()
     CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, ILLEGAL_INSTR_FETCH);
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
+
+    START_TEST_IF(iopmp.reg_file.hwcfg2.msi_en && iopmp.reg_file.hwcfg0.addrh_en, "Test MSI above 4 GB",
+    uint64_t read_data;
+    uint8_t block[64];
+    reset_iopmp(&iopmp, &cfg);
+    write_register(&iopmp, ERR_CFG_OFFSET, 0x8F0A, 4);
+    write_register(&iopmp, ERR_MSIADDR_OFFSET, 0xFFC, 4);
+    write_register(&iopmp, ERR_MSIADDRH_OFFSET, 0x80, 4);   // MSI at 0x80_0000_0FFC
+    configure_srcmd_n(&iopmp, SRCMD_ENH, 2, 0x1, 4);
+    configure_srcmd_n(&iopmp, SRCMD_XH, 2, 0x1, 4);
+    configure_mdcfg_n(&iopmp, 31, 2, 4);
+    configure_entry_n(&iopmp, ENTRY_ADDR, 1, 90, 4);
+    configure_entry_n(&iopmp, ENTRY_CFG, 1, (NAPOT | R), 4);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(2, 360, 0, 3, INSTR_FETCH, 0, &iopmp_trans_req);
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    CHECK_IOPMP_TRANS(&iopmp, IOPMP_ERROR, ILLEGAL_INSTR_FETCH);
+    read_memory(0x8000000FFCULL, 4, &read_data);
+    FAIL_IF(read_data != 0x8F);
+    // A block read across the page boundary sees the MSI and untouched memory
+    FAIL_IF(read_memory_block(0x8000000FF8ULL, block, sizeof(block)) != 0);
+    FAIL_IF((block[4] != 0x8F) || (block[8] != 0) || (block[63] != 0));
+    memset(block, 0x5A, sizeof(block));
+    FAIL_IF(write_memory_block(0x8000000FF8ULL, block, sizeof(block)) != 0);
+    read_memory(0x8000001000ULL, 4, &read_data);
+    FAIL_IF(read_data != 0x5A5A5A5A);
+    write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
+    END_TEST();)
 #endif
 
-    free(memory);
+    destroy_memory();
 
 #if (SRC_ENFORCEMENT_EN)
     START_TEST("Test SourceEnforcement Enable Feature");
@@ -1131,5 +1987,7 @@ int main()
     END_TEST();
 #endif
 
+    iopmp_destroy(&iopmp);
+
     return 0;
 }
@@ -8,9 +8,13 @@
 iopmp_dev_t iopmp_dev = {0};
 iopmp_cfg_t cfg = {0};
 
+/* Number of MMIO reads issued by libiopmp */
+static uint32_t io_reads;
+
 /* Override libiopmp IO functions */
 uint32_t io_read32(uintptr_t addr)
 {
+    io_reads++;
     return read_register(&iopmp_dev, addr, 4);
 }
 
@@ -19,6 +23,18 @@ void io_write32(uintptr_t addr, uint32_t val)
     return write_register(&iopmp_dev, addr, val, 4);
 }
 
+/* RRIDs passed to sv_handler() */
+static uint32_t sv_rrids[16];
+static uint32_t sv_num;
+
+static void sv_handler(void *arg, uint32_t rrid)
+{
+    (void)arg;
+    if (sv_num < 16)
+        sv_rrids[sv_num] = rrid;
+    sv_num++;
+}
+
 int main(void)
 {
     IOPMP_t iopmp = {0};
@@ -301,5 +317,92 @@ int main(void)
     FAIL_IF(addr != (uintptr_t)iopmp_dev.reg_file.entryoffset.offset);
     END_TEST();
 
+    START_TEST("Drain subsequent violation windows");
+    if (hwcfg2.mfr_en) {
+        static const uint16_t rrids[] = { 1, 40, 3, 17, 18 };
+        iopmp_trans_req_t req;
+        iopmp_trans_rsp_t rsp;
+        uint8_t intrpt;
+
+        // No rule is set, so every transaction is a violation. The first
+        // one is recorded by ERR_INFO, the others by ERR_MFR.
+        set_hwcfg0_enable(&iopmp_dev);
+        for (int i = 0; i < 5; i++) {
+            receiver_port(rrids[i], 0x1000, 0, 3, READ_ACCESS, 0, &req);
+            iopmp_validate_access(&iopmp_dev, &req, &rsp, &intrpt);
+        }
+        ret = iopmp_mfr_drain(&iopmp, sv_handler, NULL, &val_u32);
+        FAIL_IF(ret != IOPMP_OK);
+        FAIL_IF(val_u32 != 4);
+        FAIL_IF(sv_num != 4);
+        FAIL_IF(sv_rrids[0] != 3 || sv_rrids[1] != 17 ||
+                sv_rrids[2] != 18 || sv_rrids[3] != 40);
+        ret = iopmp_mfr_drain(&iopmp, sv_handler, NULL, &val_u32);
+        FAIL_IF(ret != IOPMP_ERR_NOT_EXIST);
+        FAIL_IF(val_u32 != 0);
+        ret = iopmp_mfr_drain(&iopmp, NULL, NULL, NULL);
+        FAIL_IF(ret != IOPMP_ERR_INVALID_PARAMETER);
+    } else {
+        ret = iopmp_mfr_drain(&iopmp, sv_handler, NULL, NULL);
+        FAIL_IF(ret != IOPMP_ERR_NOT_SUPPORTED);
+    }
+    END_TEST();
+
+    START_TEST("Serve the getters from a shadow of the tables");
+    {
+        static uint64_t shadow[2048];
+        struct iopmp_entry entry = { .addr = 0x400, .cfg = 0x1 };
+        uint64_t entry_addr = iopmp_dev.reg_file.entryoffset.offset +
+                              (20 * ENTRY_REG_STRIDE);
+        uint32_t entry_idx_start, num_entry, reads;
+        uint64_t mds;
+        size_t size;
+
+        ret = iopmp_shadow_get_size(&iopmp, &size);
+        FAIL_IF(ret != IOPMP_OK);
+        // 512 entries, 64 RRIDs of SRCMD_EN/R/W/X and 63 MDCFG
+        FAIL_IF(size != (512 * 12) + (64 * 8 * 4) + (63 * 4));
+        FAIL_IF(size > sizeof(shadow));
+        FAIL_IF(iopmp_shadow_resync(&iopmp) != IOPMP_ERR_NOT_EXIST);
+        FAIL_IF(iopmp_shadow_attach(&iopmp, shadow, size - 1) !=
+                IOPMP_ERR_OUT_OF_BOUNDS);
+        FAIL_IF(iopmp_shadow_attach(&iopmp, (uint8_t *)shadow + 4, size) !=
+                IOPMP_ERR_INVALID_PARAMETER);
+        FAIL_IF(iopmp_shadow_attach(&iopmp, shadow, size) != IOPMP_OK);
+
+        // The setters write through, the getters read no register
+        FAIL_IF(iopmp_set_entry(&iopmp, &entry, 20) != IOPMP_OK);
+        FAIL_IF(iopmp_set_rrid_md_association(&iopmp, 5, 0x6, 0, &mds,
+                                              false) != IOPMP_OK);
+        reads = io_reads;
+        memset(&entry, 0, sizeof(entry));
+        FAIL_IF(iopmp_get_entry(&iopmp, &entry, 20) != IOPMP_OK);
+        FAIL_IF(entry.addr != 0x400 || entry.cfg != 0x1);
+        FAIL_IF(iopmp_get_rrid_md_association(&iopmp, 5, &mds, &val_bool) !=
+                IOPMP_OK);
+        FAIL_IF(mds != 0x6 || val_bool);
+        FAIL_IF(iopmp_get_md_entry_association(&iopmp, 1, &entry_idx_start,
+                                               &num_entry) != IOPMP_OK);
+        FAIL_IF(iopmp_sps_get_rrid_md_read(&iopmp, 5, &mds) != IOPMP_OK);
+        FAIL_IF(io_reads != reads);
+
+        // A write behind libiopmp is seen after a resync
+        write_register(&iopmp_dev, entry_addr, 0x800, 4);
+        FAIL_IF(iopmp_get_entry(&iopmp, &entry, 20) != IOPMP_OK);
+        FAIL_IF(entry.addr != 0x400);
+        FAIL_IF(iopmp_shadow_resync(&iopmp) != IOPMP_OK);
+        FAIL_IF(iopmp_get_entry(&iopmp, &entry, 20) != IOPMP_OK);
+        FAIL_IF(entry.addr != 0x800);
+
+        FAIL_IF(iopmp_shadow_detach(&iopmp) != IOPMP_OK);
+        FAIL_IF(iopmp_shadow_detach(&iopmp) != IOPMP_ERR_NOT_EXIST);
+        reads = io_reads;
+        FAIL_IF(iopmp_get_entry(&iopmp, &entry, 20) != IOPMP_OK);
+        FAIL_IF(io_reads == reads);
+    }
+    END_TEST();
+
+    iopmp_destroy(&iopmp_dev);
+
     return 0;
 }
@@ -960,7 +960,7 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
-    free(memory);
+    destroy_memory();
 
 #if (SRC_ENFORCEMENT_EN)
     START_TEST("Test SourceEnforcement Enable Feature");
@@ -984,5 +984,7 @@ int main()
     END_TEST();
 #endif
 
+    iopmp_destroy(&iopmp);
+
     return 0;
 }
@@ -471,6 +471,32 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
+    START_TEST_IF(iopmp.reg_file.hwcfg2.mfr_en, "Test MFR Extension, windows found from ERR_MFR.svi",
+    reset_iopmp(&iopmp, &cfg);
+    set_hwcfg0_enable(&iopmp);
+    receiver_port(1, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);   // Primary error capture
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    receiver_port(40, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);  // Window 2
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    receiver_port(3, 360, 0, 3, READ_ACCESS, 0, &iopmp_trans_req);   // Window 0
+    iopmp_validate_access(&iopmp, &iopmp_trans_req, &iopmp_trans_rsp, &intrpt);
+    write_register(&iopmp, ERR_MFR_OFFSET, (1 << 16), 4);          // ERR_MFR.svi = 1
+    err_mfr_t err_mfr_temp;
+    err_mfr_temp.raw = read_register(&iopmp, ERR_MFR_OFFSET, 4);
+    FAIL_IF((err_mfr_temp.svs != 1));
+    FAIL_IF((err_mfr_temp.svi != 2));
+    FAIL_IF((err_mfr_temp.svw != 0x100));
+    err_mfr_temp.raw = read_register(&iopmp, ERR_MFR_OFFSET, 4);   // Wraps around
+    FAIL_IF((err_mfr_temp.svs != 1));
+    FAIL_IF((err_mfr_temp.svi != 0));
+    FAIL_IF((err_mfr_temp.svw != 0x8));
+    err_info_temp.raw = read_register(&iopmp, ERR_INFO_OFFSET, 4);
+    FAIL_IF((err_info_temp.svc != 0));
+    err_mfr_temp.raw = read_register(&iopmp, ERR_MFR_OFFSET, 4);
+    FAIL_IF((err_mfr_temp.svs != 0));
+    write_register(&iopmp, ERR_INFO_OFFSET, 1, 4);
+    END_TEST();)
+
     START_TEST_IF(iopmp.reg_file.hwcfg2.peis, "Test Interrupt Suppression is Enabled",
     reset_iopmp(&iopmp, &cfg);
     write_register(&iopmp, ERR_CFG_OFFSET, 0x2, 4);
@@ -645,7 +671,7 @@ int main()
     write_register(&iopmp, ERR_INFO_OFFSET, 0, 4);
     END_TEST();)
 
-    free(memory);
+    destroy_memory();
 
 #if (SRC_ENFORCEMENT_EN)
     START_TEST("Test SourceEnforcement Enable Feature");
@@ -708,5 +734,7 @@ int main()
     END_TEST();)
 #endif
 
+    iopmp_destroy(&iopmp);
+
     return 0;
 }
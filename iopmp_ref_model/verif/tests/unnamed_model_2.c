@@ -792,7 +792,7 @@ int main()
     END_TEST();)
 #endif
 
-    free(memory);
+    destroy_memory();
 
 #if (SRC_ENFORCEMENT_EN)
     START_TEST("Test SourceEnforcement Enable Feature");
@@ -815,5 +815,7 @@ int main()
     END_TEST();
 #endif
 
+    iopmp_destroy(&iopmp);
+
     return 0;
 }
@@ -24,6 +24,30 @@
 /******************************************************************************/
 /* libiopmp data structure.                                                   */
 /******************************************************************************/
+/**
+ * Structure for the shadow of the entry array, MDCFG and SRCMD tables of an
+ * IOPMP instance, see iopmp_shadow_attach(). The tables not implemented by the
+ * instance are NULL
+ */
+struct iopmp_shadow {
+    /** {ENTRY_ADDRH(i), ENTRY_ADDR(i)} of entry_num entries */
+    uint64_t *entry_addr;
+    /** ENTRY_CFG(i) of entry_num entries */
+    uint32_t *entry_cfg;
+    /** MDCFG(m) of md_num MDs, when mdcfg_fmt=0 */
+    uint32_t *mdcfg;
+    /** {SRCMD_ENH(s), SRCMD_EN(s)} of rrid_num RRIDs, when srcmd_fmt=0 */
+    uint64_t *srcmd_en;
+    /** {SRCMD_PERMH(m), SRCMD_PERM(m)} of md_num MDs, when srcmd_fmt=2 */
+    uint64_t *srcmd_perm;
+    /** {SRCMD_RH(s), SRCMD_R(s)} of rrid_num RRIDs, when SPS is supported */
+    uint64_t *srcmd_r;
+    /** {SRCMD_WH(s), SRCMD_W(s)} of rrid_num RRIDs, when SPS is supported */
+    uint64_t *srcmd_w;
+    /** {SRCMD_XH(s), SRCMD_X(s)} of rrid_num RRIDs, when SPS is supported */
+    uint64_t *srcmd_x;
+};
+
 /**
  * Structure for an IOPMP instance, including base address, operations,
  * configurations, etc
@@ -86,6 +110,9 @@ struct iopmp_instance {
     /** Cache of ERR_CFG.msidata */
     uint16_t msidata;
 
+    /** Shadow of the entry array, MDCFG and SRCMD tables if shadow_en=1 */
+    struct iopmp_shadow shadow;
+
     /** Flags */
     struct {
         /** Flag to indicate the IOPMP instance has been initialized */
@@ -167,6 +194,8 @@ struct iopmp_instance {
         unsigned int support_stall_by_md : 1;
         /** Flag to indicate if IOPMP is stalling some transactions */
         unsigned int is_stalling : 1;
+        /** Flag to indicate the getters of the tables are served by shadow */
+        unsigned int shadow_en : 1;
     };
 };
 
@@ -320,6 +349,12 @@ typedef struct iopmp_entry IOPMP_Entry_t;
 
 typedef struct iopmp_err_report IOPMP_ERR_REPORT_t;
 
+/**
+ * \brief Callback receiving an RRID with a subsequent violation, see
+ *        iopmp_mfr_drain()
+ */
+typedef void (*iopmp_sv_handler_t)(void *arg, uint32_t rrid);
+
 /** Maximum supported RRID when srcmd_fmt=2 */
 #define IOPMP_MAX_RRID_SRCMD_FMT_2  32
 
@@ -1743,6 +1778,32 @@ enum iopmp_error iopmp_capture_error(IOPMP_t *iopmp,
 enum iopmp_error iopmp_mfr_get_sv_window(IOPMP_t *iopmp, uint16_t *svi,
                                          uint16_t *svw);
 
+/**
+ * \brief Drain all pending subsequent violation windows, if IOPMP supports MFR
+ * extension
+ *
+ * Each read of ERR_MFR moves to the next window holding subsequent violations
+ * and clears it, so one read is issued per pending window plus one read to
+ * find there is none left.
+ *
+ * \param[in] iopmp             The IOPMP instance to be drained
+ * \param[in] handler           The callback invoked once per violating RRID,
+ *                              in window order
+ * \param[in] arg               The argument passed to \p handler
+ * \param[out] num_rrids        The number of RRIDs passed to \p handler. It
+ *                              can be NULL
+ *
+ * \retval IOPMP_OK if at least one subsequent violation is found
+ * \retval IOPMP_ERR_NOT_SUPPORTED if \p iopmp does not support MFR extension
+ * \retval IOPMP_ERR_INVALID_PARAMETER if given \p handler is NULL
+ * \retval IOPMP_ERR_NOT_EXIST if there is no any subsequent violation
+ *
+ * \note At most one pass over the windows is drained, so windows refilled by
+ *       violations during the call may be left for the next call
+ */
+enum iopmp_error iopmp_mfr_drain(IOPMP_t *iopmp, iopmp_sv_handler_t handler,
+                                 void *arg, uint32_t *num_rrids);
+
 /**
  * \brief Lock SRCMD_EN(rrid), SRCMD_ENH(rrid), SRCMD_R(rrid), SRCMD_RH(rrid),
  * SRCMD_W(rrid), and SRCMD_WH(rrid) if any
@@ -2485,4 +2546,67 @@ static inline enum iopmp_error iopmp_clear_entry(IOPMP_t *iopmp, uint32_t idx)
 enum iopmp_error iopmp_entries_get_belong_md(IOPMP_t *iopmp, uint32_t idx_start,
                                              uint32_t num_entry, uint64_t *mds);
 
+/**
+ * \brief Get the size of the shadow of the entry array, MDCFG and SRCMD tables
+ *
+ * The size depends on entry_num, md_num and rrid_num of \p iopmp, and on the
+ * tables its model implements.
+ *
+ * \param[in] iopmp             The IOPMP instance
+ * \param[out] size             Pointer to integer to store the size in bytes
+ *
+ * \retval IOPMP_OK on success
+ * \retval IOPMP_ERR_INVALID_PARAMETER if given \p size is NULL
+ */
+enum iopmp_error iopmp_shadow_get_size(IOPMP_t *iopmp, size_t *size);
+
+/**
+ * \brief Attach a shadow of the entry array, MDCFG and SRCMD tables to an IOPMP
+ * instance
+ *
+ * The shadow is loaded from the IOPMP. From then on, the getters of entries,
+ * MD-entry associations, RRID-MD associations and SPS permissions are served
+ * from the shadow instead of MMIO reads, and the setters write through it.
+ *
+ * \param[in] iopmp             The IOPMP instance
+ * \param[in] buf               The buffer holding the shadow, 8-byte aligned.
+ *                              It belongs to \p iopmp until
+ *                              iopmp_shadow_detach() or iopmp_init()
+ * \param[in] size              The size of \p buf in bytes, see
+ *                              iopmp_shadow_get_size()
+ *
+ * \retval IOPMP_OK on success
+ * \retval IOPMP_ERR_INVALID_PARAMETER if given \p buf is NULL or misaligned
+ * \retval IOPMP_ERR_OUT_OF_BOUNDS if given \p size is too small
+ *
+ * \note The setters keep the values they write. A WARL field the IOPMP
+ *       legalizes without being read back, e.g. ENTRY_ADDR under a coarse
+ *       granularity, is shadowed as written until iopmp_shadow_resync()
+ */
+enum iopmp_error iopmp_shadow_attach(IOPMP_t *iopmp, void *buf, size_t size);
+
+/**
+ * \brief Reload the shadow of an IOPMP instance from the IOPMP
+ *
+ * It is needed when the tables are written behind libiopmp, e.g. by another
+ * hart or a debugger, or to compare the shadow with the IOPMP at bring-up.
+ *
+ * \param[in] iopmp             The IOPMP instance
+ *
+ * \retval IOPMP_OK on success
+ * \retval IOPMP_ERR_NOT_EXIST if no shadow is attached to \p iopmp
+ */
+enum iopmp_error iopmp_shadow_resync(IOPMP_t *iopmp);
+
+/**
+ * \brief Detach the shadow of an IOPMP instance. The getters read the IOPMP
+ * again
+ *
+ * \param[in] iopmp             The IOPMP instance
+ *
+ * \retval IOPMP_OK on success
+ * \retval IOPMP_ERR_NOT_EXIST if no shadow is attached to \p iopmp
+ */
+enum iopmp_error iopmp_shadow_detach(IOPMP_t *iopmp);
+
 #endif
@@ -318,13 +318,26 @@ DECLARE_FUNC_READ_SRCMD_H(srcmd_wh,    (iopmp->md_num > 31));
 DECLARE_FUNC_READ_SRCMD_H(srcmd_xh,    (iopmp->md_num > 31));
 #endif
 
-/* Helper functions to read 64-bit value from SRCMD registers */
+/*
+ * Helper functions to read 64-bit value from SRCMD registers. fetch_*() always
+ * reads the IOPMP and refreshes the shadow, e.g. to check a WARL field after a
+ * write. read_*() is served by the shadow if any
+ */
 #define DECLARE_FUNC_READ_SRCMD_64(name)                                \
-static uint64_t read_ ## name ## _64(IOPMP_t *iopmp, uint32_t idx)      \
+static uint64_t fetch_ ## name ## _64(IOPMP_t *iopmp, uint32_t idx)     \
 {                                                                       \
     uint32_t val_##name    = read_##name(iopmp, idx);                   \
     uint32_t val_##name##h = read_##name##h(iopmp, idx);                \
-    return ((uint64_t)val_##name##h << 32) | val_##name;                \
+    uint64_t val = ((uint64_t)val_##name##h << 32) | val_##name;        \
+    if (iopmp->shadow_en)                                               \
+        iopmp->shadow.name[idx] = val;                                  \
+    return val;                                                         \
+}                                                                       \
+static uint64_t read_ ## name ## _64(IOPMP_t *iopmp, uint32_t idx)      \
+{                                                                       \
+    if (iopmp->shadow_en)                                               \
+        return iopmp->shadow.name[idx];                                 \
+    return fetch_##name##_64(iopmp, idx);                               \
 }
 DECLARE_FUNC_READ_SRCMD_64(srcmd_en);
 DECLARE_FUNC_READ_SRCMD_64(srcmd_perm);
@@ -370,6 +383,8 @@ static void write_ ## name ## _64(IOPMP_t *iopmp, uint32_t idx,         \
 {                                                                       \
     write_##name##h(iopmp, idx, val >> 32);                             \
     write_##name(iopmp, idx, val & 0xFFFFFFFF);                         \
+    if (iopmp->shadow_en)                                               \
+        iopmp->shadow.name[idx] = val;                                  \
 }
 DECLARE_FUNC_WRITE_SRCMD_64(srcmd_en);
 DECLARE_FUNC_WRITE_SRCMD_64(srcmd_perm);
@@ -1076,6 +1091,46 @@ static enum iopmp_error generic_get_sv_window(IOPMP_t *iopmp, uint16_t *svi,
     return IOPMP_ERR_NOT_EXIST;
 }
 
+/**
+ * \brief Pass the RRIDs of all pending subsequent violation windows to a
+ * callback
+ *
+ * \param[in] iopmp             The IOPMP instance to be drained
+ * \param[in] handler           The callback invoked once per violating RRID
+ * \param[in] arg               The argument passed to \p handler
+ *
+ * \return The number of RRIDs passed to \p handler
+ *
+ * \note ERR_MFR.svi is not written since each read already starts from the
+ *       last window found. ERR_INFO.svc is not read since a read of ERR_MFR
+ *       without any pending window costs the same.
+ */
+static uint32_t generic_drain_sv_windows(IOPMP_t *iopmp,
+                                         iopmp_sv_handler_t handler, void *arg)
+{
+    uint32_t num_windows = (iopmp->rrid_num + 15) / 16;
+    uint32_t num_rrids = 0;
+    uint32_t err_mfr;
+    uint32_t svi;
+    uint64_t svw;
+
+    for (uint32_t i = 0; i < num_windows; i++) {
+        err_mfr = io_read32(iopmp->addr + IOPMP_ERR_MFR_BASE);
+        if (!(err_mfr & IOPMP_ERR_MFR_SVS_MASK))
+            break;
+
+        svi = EXTRACT_FIELD(err_mfr, IOPMP_ERR_MFR_SVI);
+        svw = EXTRACT_FIELD(err_mfr, IOPMP_ERR_MFR_SVW);
+        while (svw) {
+            handler(arg, (svi * 16) + iopmp_ctzll(svw));
+            svw &= svw - 1;
+            num_rrids++;
+        }
+    }
+
+    return num_rrids;
+}
+
 enum iopmp_error generic_set_entries(IOPMP_t *iopmp,
                                      const struct iopmp_entry *entry_array,
                                      uint32_t idx_start, uint32_t num_entry)
@@ -1089,6 +1144,10 @@ enum iopmp_error generic_set_entries(IOPMP_t *iopmp,
         if (iopmp->addrh_en)
             io_write32(e + IOPMP_ENTRY_ADDRH_BASE, entry_array[i].addr >> 32);
         io_write32(e + IOPMP_ENTRY_CFG_BASE, entry_array[i].cfg);
+        if (iopmp->shadow_en) {
+            iopmp->shadow.entry_addr[idx_start + i] = entry_array[i].addr;
+            iopmp->shadow.entry_cfg[idx_start + i] = entry_array[i].cfg;
+        }
 
         e += IOPMP_ENTRY_STRIDE;
     }
@@ -1096,8 +1155,9 @@ enum iopmp_error generic_set_entries(IOPMP_t *iopmp,
     return IOPMP_OK;
 }
 
-void generic_get_entries(IOPMP_t *iopmp, struct iopmp_entry *entry_array,
-                         uint32_t idx_start, uint32_t num_entry)
+/* Read entries from IOPMP, bypassing the shadow */
+static void fetch_entries(IOPMP_t *iopmp, struct iopmp_entry *entry_array,
+                          uint32_t idx_start, uint32_t num_entry)
 {
     uintptr_t e = get_addr_of_entry(iopmp, idx_start);
     uint32_t addr, addrh = 0, cfg;
@@ -1117,6 +1177,22 @@ void generic_get_entries(IOPMP_t *iopmp, struct iopmp_entry *entry_array,
     }
 }
 
+void generic_get_entries(IOPMP_t *iopmp, struct iopmp_entry *entry_array,
+                         uint32_t idx_start, uint32_t num_entry)
+{
+    int i;
+
+    if (!iopmp->shadow_en) {
+        fetch_entries(iopmp, entry_array, idx_start, num_entry);
+        return;
+    }
+
+    for (i = 0; i < num_entry; i++) {
+        entry_array[i].addr = iopmp->shadow.entry_addr[idx_start + i];
+        entry_array[i].cfg = iopmp->shadow.entry_cfg[idx_start + i];
+    }
+}
+
 void generic_clear_entries(IOPMP_t *iopmp, uint32_t idx_start,
                            uint32_t num_entry)
 {
@@ -1128,11 +1204,58 @@ void generic_clear_entries(IOPMP_t *iopmp, uint32_t idx_start,
         io_write32(e + IOPMP_ENTRY_ADDR_BASE, 0);
         if (iopmp->addrh_en)
             io_write32(e + IOPMP_ENTRY_ADDRH_BASE, 0);
+        if (iopmp->shadow_en) {
+            iopmp->shadow.entry_addr[idx_start + i] = 0;
+            iopmp->shadow.entry_cfg[idx_start + i] = 0;
+        }
 
         e += IOPMP_ENTRY_STRIDE;
     }
 }
 
+/**
+ * \brief Reload the shadow of the entry array, MDCFG and SRCMD tables from
+ * IOPMP
+ *
+ * \param[in] iopmp             The IOPMP instance with an attached shadow
+ */
+static void generic_shadow_resync(IOPMP_t *iopmp)
+{
+    struct iopmp_shadow *shadow = &iopmp->shadow;
+    struct iopmp_entry entry;
+    uint32_t i;
+
+    for (i = 0; i < iopmp->entry_num; i++) {
+        fetch_entries(iopmp, &entry, i, 1);
+        shadow->entry_addr[i] = entry.addr;
+        shadow->entry_cfg[i] = entry.cfg;
+    }
+
+    if (shadow->mdcfg) {
+        for (i = 0; i < iopmp->md_num; i++)
+            shadow->mdcfg[i] = io_read32(get_addr_of_mdcfg(iopmp, i));
+    }
+
+    /* fetch_*() refresh the shadow */
+    if (shadow->srcmd_en) {
+        for (i = 0; i < iopmp->rrid_num; i++)
+            fetch_srcmd_en_64(iopmp, i);
+    }
+    if (shadow->srcmd_perm) {
+        for (i = 0; i < iopmp->md_num; i++)
+            fetch_srcmd_perm_64(iopmp, i);
+    }
+#ifdef ENABLE_SPS
+    if (shadow->srcmd_r) {
+        for (i = 0; i < iopmp->rrid_num; i++) {
+            fetch_srcmd_r_64(iopmp, i);
+            fetch_srcmd_w_64(iopmp, i);
+            fetch_srcmd_x_64(iopmp, i);
+        }
+    }
+#endif
+}
+
 /******************************************************************************/
 /* Functions specific to some models                                          */
 /******************************************************************************/
@@ -1158,7 +1281,7 @@ enum iopmp_error srcmd_fmt_0_set_association_rrid_md(IOPMP_t *iopmp,
     write_srcmd_en_64(iopmp, rrid, srcmd_en_64);
 
     /* SRCMD_EN.md and SRCMD_ENH.mdh are WARL. Read them back to check. */
-    srcmd_en_64 = read_srcmd_en_64(iopmp, rrid);
+    srcmd_en_64 = fetch_srcmd_en_64(iopmp, rrid);
     *mds = srcmd_en_64 >> IOPMP_SRCMD_EN_MD_SHIFT;
 
     return (*mds == __mds) ? IOPMP_OK : IOPMP_ERR_ILLEGAL_VALUE;
@@ -1236,7 +1359,10 @@ void mdcfg_fmt_0_get_md_entry_top(IOPMP_t *iopmp, uint32_t mdidx,
 {
     uint32_t mdcfg;
 
-    mdcfg = io_read32(get_addr_of_mdcfg(iopmp, mdidx));
+    if (iopmp->shadow_en)
+        mdcfg = iopmp->shadow.mdcfg[mdidx];
+    else
+        mdcfg = io_read32(get_addr_of_mdcfg(iopmp, mdidx));
     *entry_top = EXTRACT_FIELD(mdcfg, IOPMP_MDCFG_T);
 }
 
@@ -1258,6 +1384,8 @@ enum iopmp_error mdcfg_fmt_0_set_md_entry_top(IOPMP_t *iopmp, uint32_t mdidx,
     io_write32(addr_mdcfg, mdcfg);
     /* MDCFG.t is WARL field. Read it back to check it */
     mdcfg = io_read32(addr_mdcfg);
+    if (iopmp->shadow_en)
+        iopmp->shadow.mdcfg[mdidx] = mdcfg;
     *entry_top = EXTRACT_FIELD(mdcfg, IOPMP_MDCFG_T);
 
     return (__entry_top == *entry_top) ? IOPMP_OK : IOPMP_ERR_ILLEGAL_VALUE;
@@ -1297,6 +1425,10 @@ enum iopmp_error srcmd_fmt_2_set_md_permission(IOPMP_t *iopmp, uint32_t rrid,
         write_srcmd_perm(iopmp, mdidx, srcmd_perm);
         /* SRCMD_PERM.perm is WARL field. Read it back to check value */
         srcmd_perm = read_srcmd_perm(iopmp, mdidx);
+        if (iopmp->shadow_en)
+            iopmp->shadow.srcmd_perm[mdidx] =
+                (iopmp->shadow.srcmd_perm[mdidx] & ~(uint64_t)UINT32_MAX) |
+                srcmd_perm;
         *r = ((srcmd_perm & mask) >> shift) & 0b1;
         *w = ((srcmd_perm & mask) >> (shift + 1)) & 0b1;
         if (__r != *r || __w != *w)
@@ -1310,6 +1442,10 @@ enum iopmp_error srcmd_fmt_2_set_md_permission(IOPMP_t *iopmp, uint32_t rrid,
         write_srcmd_permh(iopmp, mdidx, srcmd_perm);
         /* SRCMD_PERMH.permh is WARL field. Read it back to check value */
         srcmd_perm = read_srcmd_permh(iopmp, mdidx);
+        if (iopmp->shadow_en)
+            iopmp->shadow.srcmd_perm[mdidx] =
+                (iopmp->shadow.srcmd_perm[mdidx] & UINT32_MAX) |
+                ((uint64_t)srcmd_perm << 32);
         *r = ((srcmd_perm & mask) >> shift) & 0b1;
         *w = ((srcmd_perm & mask) >> (shift + 1)) & 0b1;
         if (__r != *r || __w != *w)
@@ -1332,7 +1468,7 @@ srcmd_fmt_2_set_md_permission_multi(IOPMP_t *iopmp, uint32_t mdidx,
     write_srcmd_perm_64(iopmp, mdidx, srcmd_perm_64);
 
     /* SRCMD_PERM(H).perm is WARL field. Read it back to check value */
-    rb_srcmd_perm_64 = read_srcmd_perm_64(iopmp, mdidx);
+    rb_srcmd_perm_64 = fetch_srcmd_perm_64(iopmp, mdidx);
     if (rb_srcmd_perm_64 != srcmd_perm_64) {
         /* Set the value into cfg structure to let user check it */
         cfg->srcmd_perm_val = (rb_srcmd_perm_64 & cfg->srcmd_perm_mask);
@@ -1363,7 +1499,7 @@ static enum iopmp_error srcmd_fmt_2_mdcfg_fmt_1_md_entry_num_0_set_entry(
     /* The "private_data" member in the entry encodes SRCMD_PERM(H) */
     write_srcmd_perm_64(iopmp, entry_idx, entry->private_data);
     /* SRCMD_PERM(H).perm is WARL field. Read it back to check value */
-    if (read_srcmd_perm_64(iopmp, entry_idx) != entry->private_data)
+    if (fetch_srcmd_perm_64(iopmp, entry_idx) != entry->private_data)
         return IOPMP_ERR_ILLEGAL_VALUE;
 
     return generic_set_entries(iopmp, entry, entry_idx, 1);
@@ -1427,7 +1563,7 @@ static enum iopmp_error sps_set_srcmd_r_64_md(IOPMP_t *iopmp, uint32_t rrid,
     srcmd_r_64 = __mds << IOPMP_SRCMD_R_MD_SHIFT;
     write_srcmd_r_64(iopmp, rrid, srcmd_r_64);
     /* SRCMD_R.md and SRCMD_RH.mdh are WARL. Read them back to check. */
-    *mds = sps_get_srcmd_r_64_md(iopmp, rrid);
+    *mds = fetch_srcmd_r_64(iopmp, rrid) >> IOPMP_SRCMD_R_MD_SHIFT;
 
     return (*mds == __mds) ? IOPMP_OK : IOPMP_ERR_ILLEGAL_VALUE;
 }
@@ -1470,7 +1606,7 @@ static enum iopmp_error sps_set_srcmd_w_64_md(IOPMP_t *iopmp, uint32_t rrid,
     srcmd_w_64 = __mds << IOPMP_SRCMD_W_MD_SHIFT;
     write_srcmd_w_64(iopmp, rrid, srcmd_w_64);
     /* SRCMD_W.md and SRCMD_WH.mdh are WARL. Read them back to check. */
-    *mds = sps_get_srcmd_w_64_md(iopmp, rrid);
+    *mds = fetch_srcmd_w_64(iopmp, rrid) >> IOPMP_SRCMD_W_MD_SHIFT;
 
     return (*mds == __mds) ? IOPMP_OK : IOPMP_ERR_ILLEGAL_VALUE;
 }
@@ -1513,7 +1649,7 @@ static enum iopmp_error sps_set_srcmd_x_64_md(IOPMP_t *iopmp, uint32_t rrid,
     srcmd_x_64 = __mds << IOPMP_SRCMD_X_MD_SHIFT;
     write_srcmd_x_64(iopmp, rrid, srcmd_x_64);
     /* SRCMD_X.md and SRCMD_XH.mdh are WARL. Read them back to check. */
-    *mds = sps_get_srcmd_x_64_md(iopmp, rrid);
+    *mds = fetch_srcmd_x_64(iopmp, rrid) >> IOPMP_SRCMD_X_MD_SHIFT;
 
     return (*mds == __mds) ? IOPMP_OK : IOPMP_ERR_ILLEGAL_VALUE;
 }
@@ -1544,9 +1680,11 @@ static struct iopmp_operations_generic iopmp_operations_generic = {
     .capture_error = generic_capture_error,
     .invalidate_error = generic_invalidate_error,
     .get_sv_window = generic_get_sv_window,
+    .drain_sv_windows = generic_drain_sv_windows,
     .set_entries = generic_set_entries,
     .get_entries = generic_get_entries,
     .clear_entries = generic_clear_entries,
+    .shadow_resync = generic_shadow_resync,
 };
 
 #ifdef ENABLE_SPS
@@ -820,6 +820,28 @@ enum iopmp_error iopmp_mfr_get_sv_window(IOPMP_t *iopmp, uint16_t *svi,
     return iopmp->ops_generic->get_sv_window(iopmp, svi, svw);
 }
 
+enum iopmp_error iopmp_mfr_drain(IOPMP_t *iopmp, iopmp_sv_handler_t handler,
+                                 void *arg, uint32_t *num_rrids)
+{
+    uint32_t num;
+
+    assert(iopmp_is_initialized(iopmp));
+
+    if (!iopmp->mfr_en)
+        return IOPMP_ERR_NOT_SUPPORTED;
+
+    if (!handler)
+        return IOPMP_ERR_INVALID_PARAMETER;
+
+    /* If HWCFG2.mfr_en=1, this operation is mandatory */
+    assert(iopmp->ops_generic->drain_sv_windows);
+    num = iopmp->ops_generic->drain_sv_windows(iopmp, handler, arg);
+    if (num_rrids)
+        *num_rrids = num;
+
+    return num ? IOPMP_OK : IOPMP_ERR_NOT_EXIST;
+}
+
 enum iopmp_error iopmp_lock_srcmd_table_fmt_0(IOPMP_t *iopmp, uint32_t rrid)
 {
     assert(iopmp_is_initialized(iopmp));
@@ -1879,3 +1901,104 @@ enum iopmp_error iopmp_entries_get_belong_md(IOPMP_t *iopmp, uint32_t idx_start,
     *mds = __mds;
     return IOPMP_OK;
 }
+
+/**
+ * \brief Lay out the shadow of an IOPMP instance in a buffer
+ *
+ * The 64-bit tables come first so that an 8-byte aligned buffer aligns all
+ * of them.
+ *
+ * \param[in] iopmp             The IOPMP instance
+ * \param[in] buf               The buffer to be laid out, or NULL to only get
+ *                              the size
+ * \param[out] shadow           The shadow pointing into \p buf. It can be NULL
+ *
+ * \return The size of the shadow in bytes
+ */
+static size_t __shadow_layout(IOPMP_t *iopmp, void *buf,
+                              struct iopmp_shadow *shadow)
+{
+    struct iopmp_shadow __shadow = { 0 };
+    uint8_t *p = buf;
+    size_t size = 0;
+
+#define __SHADOW_TABLE(table, num)                                      \
+    do {                                                                \
+        if (p)                                                          \
+            __shadow.table = (void *)(p + size);                        \
+        size += (num) * sizeof(*__shadow.table);                        \
+    } while (0)
+
+    __SHADOW_TABLE(entry_addr, iopmp->entry_num);
+    if (iopmp->srcmd_fmt == IOPMP_SRCMD_FMT_0)
+        __SHADOW_TABLE(srcmd_en, iopmp->rrid_num);
+    if (iopmp->srcmd_fmt == IOPMP_SRCMD_FMT_2)
+        __SHADOW_TABLE(srcmd_perm, iopmp->md_num);
+    if (iopmp->ops_sps) {
+        __SHADOW_TABLE(srcmd_r, iopmp->rrid_num);
+        __SHADOW_TABLE(srcmd_w, iopmp->rrid_num);
+        __SHADOW_TABLE(srcmd_x, iopmp->rrid_num);
+    }
+    __SHADOW_TABLE(entry_cfg, iopmp->entry_num);
+    if (iopmp->mdcfg_fmt == IOPMP_MDCFG_FMT_0)
+        __SHADOW_TABLE(mdcfg, iopmp->md_num);
+
+#undef __SHADOW_TABLE
+
+    if (shadow)
+        *shadow = __shadow;
+    return size;
+}
+
+enum iopmp_error iopmp_shadow_get_size(IOPMP_t *iopmp, size_t *size)
+{
+    assert(iopmp_is_initialized(iopmp));
+
+    if (!size)
+        return IOPMP_ERR_INVALID_PARAMETER;
+
+    *size = __shadow_layout(iopmp, NULL, NULL);
+    return IOPMP_OK;
+}
+
+enum iopmp_error iopmp_shadow_attach(IOPMP_t *iopmp, void *buf, size_t size)
+{
+    assert(iopmp_is_initialized(iopmp));
+
+    if (!buf || ((uintptr_t)buf & (sizeof(uint64_t) - 1)))
+        return IOPMP_ERR_INVALID_PARAMETER;
+
+    if (size < __shadow_layout(iopmp, NULL, NULL))
+        return IOPMP_ERR_OUT_OF_BOUNDS;
+
+    __shadow_layout(iopmp, buf, &iopmp->shadow);
+    iopmp->shadow_en = true;
+
+    assert(iopmp->ops_generic->shadow_resync);
+    iopmp->ops_generic->shadow_resync(iopmp);
+    return IOPMP_OK;
+}
+
+enum iopmp_error iopmp_shadow_resync(IOPMP_t *iopmp)
+{
+    assert(iopmp_is_initialized(iopmp));
+
+    if (!iopmp->shadow_en)
+        return IOPMP_ERR_NOT_EXIST;
+
+    assert(iopmp->ops_generic->shadow_resync);
+    iopmp->ops_generic->shadow_resync(iopmp);
+    return IOPMP_OK;
+}
+
+enum iopmp_error iopmp_shadow_detach(IOPMP_t *iopmp)
+{
+    assert(iopmp_is_initialized(iopmp));
+
+    if (!iopmp->shadow_en)
+        return IOPMP_ERR_NOT_EXIST;
+
+    iopmp->shadow_en = false;
+    memset(&iopmp->shadow, 0, sizeof(iopmp->shadow));
+    return IOPMP_OK;
+}
@@ -92,6 +92,10 @@ struct iopmp_operations_generic {
     enum iopmp_error (*get_sv_window)(IOPMP_t *iopmp, uint16_t *svi,
                                       uint16_t *svw);
 
+    /** For MFR extension. Pass the RRIDs of all pending windows to @handler */
+    uint32_t (*drain_sv_windows)(IOPMP_t *iopmp, iopmp_sv_handler_t handler,
+                                 void *arg);
+
     /**
      * Set the values of entry[@idx_start]~entry[@idx_start+@num_entry-1] from
      * given @entry_array to IOPMP instance.
@@ -110,6 +114,9 @@ struct iopmp_operations_generic {
     /** Clear the values of entry[@idx_start]~entry[@idx_start+@num_entry-1] */
     void (*clear_entries)(IOPMP_t *iopmp, uint32_t idx_start,
                           uint32_t num_entry);
+
+    /** Reload the shadow of the entry array, MDCFG and SRCMD tables */
+    void (*shadow_resync)(IOPMP_t *iopmp);
 };
 
 /** Structure represents the operations for specific model */